@@ -0,0 +1,170 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "allocation_counter.h"
+#include "benchmark_data.h"
+#include "icypuff/file_metadata_parser.h"
+#include "icypuff/format_constants.h"
+#include "icypuff/icypuff.h"
+#include "icypuff/icypuff_reader.h"
+#include "icypuff/memory_input_file.h"
+#include "icypuff/memory_output_file.h"
+
+namespace icypuff {
+namespace {
+
+using bench::AllocationScope;
+using bench::BuildPuffinFile;
+using bench::CodecArg;
+
+constexpr int kFooterBlobCount = 1000;
+
+// Heap allocations of opening a file and parsing its footer, per blob
+void BM_AllocGetBlobs(benchmark::State& state) {
+  auto file = BuildPuffinFile(kFooterBlobCount, bench::kSketchBlobSize,
+                              CompressionCodec::None);
+  if (!file) {
+    state.SkipWithError("Failed to build file");
+    return;
+  }
+
+  AllocationScope scope;
+  for (auto _ : state) {
+    IcypuffReader reader(std::make_unique<MemoryInputFile>(*file),
+                         static_cast<int64_t>(file->size()));
+    auto blobs = reader.get_blobs();
+    if (!blobs.ok()) {
+      state.SkipWithError("Failed to read footer");
+      break;
+    }
+    benchmark::DoNotOptimize(blobs.value().data());
+  }
+  scope.report(state, kFooterBlobCount);
+}
+
+BENCHMARK(BM_AllocGetBlobs);
+
+// Heap allocations of FromJson alone, per blob
+void BM_AllocFooterParse(benchmark::State& state) {
+  auto file = BuildPuffinFile(kFooterBlobCount, bench::kSketchBlobSize,
+                              CompressionCodec::None);
+  if (!file) {
+    state.SkipWithError("Failed to build file");
+    return;
+  }
+  IcypuffReader reader(std::make_unique<MemoryInputFile>(*file),
+                       static_cast<int64_t>(file->size()));
+  auto footer_size = reader.footer_size();
+  if (!footer_size.ok()) {
+    state.SkipWithError("Failed to read footer");
+    return;
+  }
+  // The uncompressed payload sits between the footer start magic and the
+  // footer struct
+  std::string json(reinterpret_cast<const char*>(file->data()) +
+                       file->size() - footer_size.value() +
+                       FOOTER_START_MAGIC_LENGTH,
+                   footer_size.value() - FOOTER_START_MAGIC_LENGTH -
+                       FOOTER_STRUCT_LENGTH);
+
+  AllocationScope scope;
+  for (auto _ : state) {
+    auto metadata = FileMetadataParser::FromJson(json);
+    if (!metadata.ok()) {
+      state.SkipWithError("Footer parsing failed");
+      break;
+    }
+    benchmark::DoNotOptimize(metadata.value().get());
+  }
+  scope.report(state, kFooterBlobCount);
+}
+
+BENCHMARK(BM_AllocFooterParse);
+
+// Heap allocations of read_blob per blob, by codec
+void BM_AllocReadBlob(benchmark::State& state) {
+  constexpr int kBlobCount = 16;
+  const CompressionCodec codec = CodecArg(state.range(0));
+  auto file = BuildPuffinFile(kBlobCount, 4 << 10, codec);
+  if (!file) {
+    state.SkipWithError("Failed to build file");
+    return;
+  }
+  IcypuffReader reader(std::make_unique<MemoryInputFile>(*file),
+                       static_cast<int64_t>(file->size()));
+  auto blobs_result = reader.get_blobs();
+  if (!blobs_result.ok()) {
+    state.SkipWithError("Failed to read footer");
+    return;
+  }
+  const auto& blobs = blobs_result.value();
+
+  size_t next = 0;
+  AllocationScope scope;
+  for (auto _ : state) {
+    auto data = reader.read_blob(*blobs[next]);
+    if (!data.ok()) {
+      state.SkipWithError("Failed to read blob");
+      break;
+    }
+    benchmark::DoNotOptimize(data.value().data());
+    next = (next + 1) % blobs.size();
+  }
+  scope.report(state);
+}
+
+BENCHMARK(BM_AllocReadBlob)->ArgName("codec")->DenseRange(0, 2);
+
+std::unique_ptr<IcypuffWriter> NewMemoryWriter(CompressionCodec codec) {
+  auto writer_result = Icypuff::write(std::make_unique<MemoryOutputFile>())
+                           .compress_blobs(codec)
+                           .build();
+  return writer_result.ok() ? std::move(writer_result).value() : nullptr;
+}
+
+// Heap allocations of write_blob per blob, by codec. Writer setup and
+// teardown are excluded, and a fresh writer is started every
+// kBlobsPerWriter blobs so the peak heap reflects a bounded file.
+void BM_AllocWriteBlob(benchmark::State& state) {
+  constexpr int kBlobsPerWriter = 1000;
+  const CompressionCodec codec = CodecArg(state.range(0));
+  const auto blob = bench::MakeBlobData(4 << 10);
+  auto params = bench::SketchMetadata(0);
+
+  auto writer = NewMemoryWriter(codec);
+  int blobs_in_writer = 0;
+  AllocationScope scope;
+  for (auto _ : state) {
+    if (!writer || blobs_in_writer == kBlobsPerWriter) {
+      state.PauseTiming();
+      scope.pause();
+      writer = NewMemoryWriter(codec);
+      blobs_in_writer = 0;
+      scope.resume();
+      state.ResumeTiming();
+      if (!writer) {
+        state.SkipWithError("Failed to create writer");
+        break;
+      }
+    }
+    blobs_in_writer++;
+    auto metadata =
+        writer->write_blob(blob.data(), blob.size(), params.type,
+                           params.input_fields, params.snapshot_id,
+                           params.sequence_number, codec, params.properties);
+    if (!metadata.ok()) {
+      state.SkipWithError("Failed to write blob");
+      break;
+    }
+    benchmark::DoNotOptimize(metadata.value().get());
+  }
+  scope.report(state);
+}
+
+BENCHMARK(BM_AllocWriteBlob)->ArgName("codec")->DenseRange(0, 2);
+
+}  // namespace
+}  // namespace icypuff
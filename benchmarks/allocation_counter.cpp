@@ -0,0 +1,187 @@
+#include "allocation_counter.h"
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace icypuff {
+namespace bench {
+
+namespace {
+
+constexpr auto kRelaxed = std::memory_order_relaxed;
+
+// Every allocation is preceded by a header holding its size, so deletes
+// know how much memory they return
+constexpr size_t HEADER_SIZE = alignof(std::max_align_t);
+
+std::atomic<bool> counting{false};
+// Frees are tracked while paused so the live size stays accurate
+std::atomic<bool> tracking{false};
+std::atomic<int64_t> allocations{0};
+std::atomic<int64_t> allocated_bytes{0};
+std::atomic<int64_t> live_bytes{0};
+std::atomic<int64_t> peak_bytes{0};
+
+void RecordAllocation(size_t size) {
+  if (!counting.load(kRelaxed)) {
+    return;
+  }
+  allocations.fetch_add(1, kRelaxed);
+  allocated_bytes.fetch_add(static_cast<int64_t>(size), kRelaxed);
+  int64_t live =
+      live_bytes.fetch_add(static_cast<int64_t>(size), kRelaxed) +
+      static_cast<int64_t>(size);
+  int64_t peak = peak_bytes.load(kRelaxed);
+  while (live > peak && !peak_bytes.compare_exchange_weak(peak, live)) {
+  }
+}
+
+void RecordFree(size_t size) {
+  if (tracking.load(kRelaxed)) {
+    live_bytes.fetch_sub(static_cast<int64_t>(size), kRelaxed);
+  }
+}
+
+void* Allocate(size_t size, size_t alignment, bool nothrow) {
+  size_t header = alignment > HEADER_SIZE ? alignment : HEADER_SIZE;
+  void* base = nullptr;
+  if (alignment > HEADER_SIZE) {
+    size_t total = (header + size + alignment - 1) / alignment * alignment;
+    base = std::aligned_alloc(alignment, total);
+  } else {
+    base = std::malloc(header + size);
+  }
+  if (!base) {
+    // Benchmarks are built without exceptions, so there is no bad_alloc
+    if (nothrow) {
+      return nullptr;
+    }
+    std::abort();
+  }
+  auto* ptr = static_cast<unsigned char*>(base) + header;
+  reinterpret_cast<size_t*>(ptr)[-1] = size;
+  RecordAllocation(size);
+  return ptr;
+}
+
+void Free(void* ptr, size_t alignment) {
+  if (!ptr) {
+    return;
+  }
+  size_t header = alignment > HEADER_SIZE ? alignment : HEADER_SIZE;
+  RecordFree(static_cast<size_t*>(ptr)[-1]);
+  std::free(static_cast<unsigned char*>(ptr) - header);
+}
+
+}  // namespace
+
+void StartCountingAllocations() {
+  allocations.store(0, kRelaxed);
+  allocated_bytes.store(0, kRelaxed);
+  live_bytes.store(0, kRelaxed);
+  peak_bytes.store(0, kRelaxed);
+  tracking.store(true, kRelaxed);
+  counting.store(true, kRelaxed);
+}
+
+void PauseCountingAllocations() { counting.store(false, kRelaxed); }
+
+void ResumeCountingAllocations() { counting.store(true, kRelaxed); }
+
+AllocationCounts StopCountingAllocations() {
+  counting.store(false, kRelaxed);
+  tracking.store(false, kRelaxed);
+  return AllocationCounts{
+      .allocations = allocations.load(kRelaxed),
+      .bytes = allocated_bytes.load(kRelaxed),
+      .peak_bytes = peak_bytes.load(kRelaxed),
+  };
+}
+
+int64_t PeakRssBytes() {
+#if defined(_WIN32)
+  return 0;
+#else
+  rusage usage{};
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+#if defined(__APPLE__)
+  return static_cast<int64_t>(usage.ru_maxrss);
+#else
+  // Linux reports kilobytes
+  return static_cast<int64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+}  // namespace bench
+}  // namespace icypuff
+
+using icypuff::bench::Allocate;
+using icypuff::bench::Free;
+
+void* operator new(size_t size) {
+  return Allocate(size, 0, false);
+}
+void* operator new[](size_t size) {
+  return Allocate(size, 0, false);
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  return Allocate(size, 0, true);
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  return Allocate(size, 0, true);
+}
+void* operator new(size_t size, std::align_val_t alignment) {
+  return Allocate(size, static_cast<size_t>(alignment), false);
+}
+void* operator new[](size_t size, std::align_val_t alignment) {
+  return Allocate(size, static_cast<size_t>(alignment), false);
+}
+void* operator new(size_t size, std::align_val_t alignment,
+                   const std::nothrow_t&) noexcept {
+  return Allocate(size, static_cast<size_t>(alignment), true);
+}
+void* operator new[](size_t size, std::align_val_t alignment,
+                     const std::nothrow_t&) noexcept {
+  return Allocate(size, static_cast<size_t>(alignment), true);
+}
+
+void operator delete(void* ptr) noexcept { Free(ptr, 0); }
+void operator delete[](void* ptr) noexcept { Free(ptr, 0); }
+void operator delete(void* ptr, size_t) noexcept { Free(ptr, 0); }
+void operator delete[](void* ptr, size_t) noexcept { Free(ptr, 0); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+  Free(ptr, 0);
+}
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+  Free(ptr, 0);
+}
+void operator delete(void* ptr, std::align_val_t alignment) noexcept {
+  Free(ptr, static_cast<size_t>(alignment));
+}
+void operator delete[](void* ptr, std::align_val_t alignment) noexcept {
+  Free(ptr, static_cast<size_t>(alignment));
+}
+void operator delete(void* ptr, size_t, std::align_val_t alignment) noexcept {
+  Free(ptr, static_cast<size_t>(alignment));
+}
+void operator delete[](void* ptr, size_t,
+                       std::align_val_t alignment) noexcept {
+  Free(ptr, static_cast<size_t>(alignment));
+}
+void operator delete(void* ptr, std::align_val_t alignment,
+                     const std::nothrow_t&) noexcept {
+  Free(ptr, static_cast<size_t>(alignment));
+}
+void operator delete[](void* ptr, std::align_val_t alignment,
+                       const std::nothrow_t&) noexcept {
+  Free(ptr, static_cast<size_t>(alignment));
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+
+namespace icypuff {
+namespace bench {
+
+// Heap activity between StartCountingAllocations and
+// StopCountingAllocations. Counts cover global operator new, i.e. all C++
+// allocations; codec libraries allocating through malloc are not included.
+struct AllocationCounts {
+  int64_t allocations = 0;
+  int64_t bytes = 0;
+  // Highest live heap size above the level at the start
+  int64_t peak_bytes = 0;
+};
+
+void StartCountingAllocations();
+// Excludes allocations, e.g. of benchmark setup, from the counts
+void PauseCountingAllocations();
+void ResumeCountingAllocations();
+AllocationCounts StopCountingAllocations();
+
+// Peak resident set size of the process so far
+int64_t PeakRssBytes();
+
+// Counts the allocations of a benchmark's timed loop and reports them per
+// operation, along with the peak RSS
+class AllocationScope {
+ public:
+  AllocationScope() { StartCountingAllocations(); }
+
+  void pause() { PauseCountingAllocations(); }
+  void resume() { ResumeCountingAllocations(); }
+
+  void report(benchmark::State& state, int64_t ops_per_iteration = 1) {
+    AllocationCounts counts = StopCountingAllocations();
+    double ops = static_cast<double>(state.iterations() * ops_per_iteration);
+    if (ops > 0) {
+      state.counters["allocs_per_op"] = counts.allocations / ops;
+      state.counters["bytes_per_op"] = counts.bytes / ops;
+    }
+    state.counters["peak_heap_bytes"] = static_cast<double>(counts.peak_bytes);
+    state.counters["peak_rss_bytes"] = static_cast<double>(PeakRssBytes());
+  }
+};
+
+}  // namespace bench
+}  // namespace icypuff
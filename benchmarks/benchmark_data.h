@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "icypuff/blob_metadata.h"
+#include "icypuff/compression_codec.h"
+#include "icypuff/memory_output_file.h"
+#include "icypuff/synthetic_dataset.h"
+
+namespace icypuff {
+namespace bench {
+
+constexpr int kSketchBlobSize = 64;
+
+// Benchmark arguments are integers, codecs are passed by index
+inline CompressionCodec CodecArg(int64_t index) {
+  switch (index) {
+    case 1:
+      return CompressionCodec::Lz4;
+    case 2:
+      return CompressionCodec::Zstd;
+    default:
+      return CompressionCodec::None;
+  }
+}
+
+// Footer metadata shaped like a stats file full of small sketches
+inline BlobMetadataParams SketchMetadata(int index) {
+  BlobMetadataParams params;
+  params.type = "apache-datasketches-theta-v1";
+  params.input_fields = {index % 100 + 1};
+  params.snapshot_id = 3055729675574597004 + index;
+  params.sequence_number = index;
+  params.offset = 4 + static_cast<int64_t>(index) * kSketchBlobSize;
+  params.length = kSketchBlobSize;
+  params.properties = {{"ndv", std::to_string(index * 7)}};
+  return params;
+}
+
+// Generates a synthetic Puffin file in memory, nullptr on failure
+inline std::shared_ptr<std::vector<uint8_t>> BuildSyntheticFile(
+    const SyntheticDatasetOptions& options) {
+  auto buffer = std::make_shared<std::vector<uint8_t>>();
+  auto result = GenerateSyntheticDataset(
+      std::make_unique<MemoryOutputFile>(buffer), options);
+  return result.ok() ? buffer : nullptr;
+}
+
+// Deterministic, moderately compressible blob contents: words drawn from a
+// small vocabulary, like serialized statistics
+inline std::vector<uint8_t> MakeBlobData(size_t size, uint32_t seed = 42) {
+  static const char* kWords[] = {"theta", "sketch", "ndv",   "bloom",
+                                 "hll",   "field",  "42",    "3055729675",
+                                 "null",  "count",  "lower", "upper"};
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<> dis(0, std::size(kWords) - 1);
+  std::vector<uint8_t> data;
+  data.reserve(size + 16);
+  while (data.size() < size) {
+    const char* word = kWords[dis(gen)];
+    data.insert(data.end(), word, word + std::char_traits<char>::length(word));
+    data.push_back(' ');
+  }
+  data.resize(size);
+  return data;
+}
+
+// Builds a Puffin file in memory with blob_count blobs of blob_size bytes
+inline std::shared_ptr<std::vector<uint8_t>> BuildPuffinFile(
+    int blob_count, size_t blob_size, CompressionCodec codec) {
+  SyntheticDatasetOptions options;
+  options.blob_count = blob_count;
+  options.min_blob_size = blob_size;
+  options.max_blob_size = blob_size;
+  options.codecs = {codec};
+  return BuildSyntheticFile(options);
+}
+
+}  // namespace bench
+}  // namespace icypuff
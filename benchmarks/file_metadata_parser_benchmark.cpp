@@ -0,0 +1,81 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "benchmark_data.h"
+#include "icypuff/file_metadata_parser.h"
+
+namespace icypuff {
+namespace {
+
+using bench::SketchMetadata;
+
+std::vector<std::unique_ptr<BlobMetadata>> SketchBlobs(int blob_count) {
+  std::vector<std::unique_ptr<BlobMetadata>> blobs;
+  blobs.reserve(blob_count);
+  for (int i = 0; i < blob_count; i++) {
+    blobs.push_back(BlobMetadata::Create(SketchMetadata(i)).value());
+  }
+  return blobs;
+}
+
+const std::unordered_map<std::string, std::string> kProperties = {
+    {"created-by", "icypuff-bench"}};
+
+void BM_FooterSerialize(benchmark::State& state) {
+  const auto blob_count = static_cast<int>(state.range(0));
+  auto blobs = SketchBlobs(blob_count);
+
+  std::string json;
+  for (auto _ : state) {
+    json.clear();
+    auto result = FileMetadataParser::AppendJson(blobs, kProperties, json);
+    if (!result.ok()) {
+      state.SkipWithError("Footer serialization failed");
+      break;
+    }
+    benchmark::DoNotOptimize(json.data());
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(json.size()));
+  state.counters["blobs"] = blob_count;
+}
+
+BENCHMARK(BM_FooterSerialize)
+    ->Arg(1000)
+    ->Arg(100000)
+    ->Unit(benchmark::kMillisecond);
+
+void BM_FooterParse(benchmark::State& state) {
+  const auto blob_count = static_cast<int>(state.range(0));
+  std::string json;
+  if (!FileMetadataParser::AppendJson(SketchBlobs(blob_count), kProperties,
+                                      json)
+           .ok()) {
+    state.SkipWithError("Footer serialization failed");
+    return;
+  }
+
+  for (auto _ : state) {
+    auto metadata = FileMetadataParser::FromJson(json);
+    if (!metadata.ok()) {
+      state.SkipWithError("Footer parsing failed");
+      break;
+    }
+    benchmark::DoNotOptimize(metadata.value().get());
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(json.size()));
+  state.counters["blobs"] = blob_count;
+}
+
+BENCHMARK(BM_FooterParse)
+    ->Arg(1000)
+    ->Arg(100000)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace icypuff
@@ -0,0 +1,131 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+#include "benchmark_data.h"
+#include "icypuff/icypuff_reader.h"
+#include "icypuff/memory_input_file.h"
+#include "icypuff/synthetic_dataset.h"
+
+namespace icypuff {
+namespace {
+
+using bench::BuildPuffinFile;
+using bench::CodecArg;
+
+// Latency of opening a file and parsing its footer
+void BM_ReaderOpen(benchmark::State& state) {
+  const auto blob_count = static_cast<int>(state.range(0));
+  auto file = BuildPuffinFile(blob_count, bench::kSketchBlobSize,
+                              CompressionCodec::None);
+  if (!file) {
+    state.SkipWithError("Failed to build file");
+    return;
+  }
+
+  for (auto _ : state) {
+    IcypuffReader reader(std::make_unique<MemoryInputFile>(*file),
+                         static_cast<int64_t>(file->size()));
+    auto blobs = reader.get_blobs();
+    if (!blobs.ok()) {
+      state.SkipWithError("Failed to read footer");
+      break;
+    }
+    benchmark::DoNotOptimize(blobs.value().data());
+  }
+  state.counters["blobs"] = blob_count;
+}
+
+BENCHMARK(BM_ReaderOpen)
+    ->Arg(1)
+    ->Arg(100)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Unit(benchmark::kMicrosecond);
+
+// Throughput of read_blob for one codec and blob size, in uncompressed bytes
+void BM_ReadBlob(benchmark::State& state) {
+  constexpr int kBlobCount = 16;
+  const CompressionCodec codec = CodecArg(state.range(0));
+  const auto blob_size = static_cast<int64_t>(state.range(1));
+  auto file = BuildPuffinFile(kBlobCount, blob_size, codec);
+  if (!file) {
+    state.SkipWithError("Failed to build file");
+    return;
+  }
+
+  IcypuffReader reader(std::make_unique<MemoryInputFile>(*file),
+                       static_cast<int64_t>(file->size()));
+  auto blobs_result = reader.get_blobs();
+  if (!blobs_result.ok()) {
+    state.SkipWithError("Failed to read footer");
+    return;
+  }
+  const auto& blobs = blobs_result.value();
+
+  size_t next = 0;
+  for (auto _ : state) {
+    auto data = reader.read_blob(*blobs[next]);
+    if (!data.ok()) {
+      state.SkipWithError("Failed to read blob");
+      break;
+    }
+    benchmark::DoNotOptimize(data.value().data());
+    next = (next + 1) % blobs.size();
+  }
+  state.SetBytesProcessed(state.iterations() * blob_size);
+}
+
+BENCHMARK(BM_ReadBlob)
+    ->ArgNames({"codec", "blob_size"})
+    ->ArgsProduct({{0, 1, 2}, {4 << 10, 1 << 20}})
+    ->Unit(benchmark::kMicrosecond);
+
+// Footer load of a realistically shaped file: mixed sketch types and
+// codecs, several high-cardinality properties per blob, many snapshots and
+// a compressed footer. The second argument adds a blob index, which
+// replaces the JSON parse.
+void BM_ReaderOpenMixed(benchmark::State& state) {
+  SyntheticDatasetOptions options;
+  options.blob_count = state.range(0);
+  options.size_distribution = BlobSizeDistribution::kLogNormal;
+  options.min_blob_size = 32;
+  options.max_blob_size = 64 << 10;
+  options.types = {"apache-datasketches-theta-v1",
+                   "apache-datasketches-theta-v1", "deletion-vector-v1",
+                   "bloom-filter-v1"};
+  options.codecs = {CompressionCodec::None, CompressionCodec::Zstd};
+  options.properties_per_blob = 3;
+  options.property_cardinality = 1000000;
+  options.field_count = 1000;
+  options.snapshot_count = 100;
+  options.compress_footer = true;
+  options.write_blob_index = state.range(1) != 0;
+  auto file = bench::BuildSyntheticFile(options);
+  if (!file) {
+    state.SkipWithError("Failed to build file");
+    return;
+  }
+
+  for (auto _ : state) {
+    IcypuffReader reader(std::make_unique<MemoryInputFile>(*file),
+                         static_cast<int64_t>(file->size()));
+    auto blobs = reader.get_blobs();
+    if (!blobs.ok()) {
+      state.SkipWithError("Failed to read footer");
+      break;
+    }
+    benchmark::DoNotOptimize(blobs.value().data());
+  }
+  state.counters["blobs"] = static_cast<double>(options.blob_count);
+  state.counters["file_bytes"] = static_cast<double>(file->size());
+}
+
+BENCHMARK(BM_ReaderOpenMixed)
+    ->ArgNames({"blobs", "index"})
+    ->ArgsProduct({{10000, 1000000}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace icypuff
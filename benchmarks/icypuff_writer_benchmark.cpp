@@ -0,0 +1,112 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "benchmark_data.h"
+#include "icypuff/icypuff.h"
+#include "icypuff/memory_output_file.h"
+
+namespace icypuff {
+namespace {
+
+using bench::CodecArg;
+using bench::MakeBlobData;
+using bench::SketchMetadata;
+
+constexpr int kBlobsPerIteration = 16;
+
+// Throughput of write_blob and close for one codec and blob size, in
+// uncompressed bytes
+void BM_WriteBlob(benchmark::State& state) {
+  const CompressionCodec codec = CodecArg(state.range(0));
+  const auto blob_size = static_cast<size_t>(state.range(1));
+  const auto blob = MakeBlobData(blob_size);
+  auto buffer = std::make_shared<std::vector<uint8_t>>();
+
+  for (auto _ : state) {
+    auto writer_result =
+        Icypuff::write(std::make_unique<MemoryOutputFile>(buffer))
+            .compress_blobs(codec)
+            .build();
+    if (!writer_result.ok()) {
+      state.SkipWithError("Failed to create writer");
+      break;
+    }
+    auto writer = std::move(writer_result).value();
+    for (int i = 0; i < kBlobsPerIteration; i++) {
+      if (!writer->write_blob(blob.data(), blob.size(), "bench-blob", {1}, 1,
+                              1)
+               .ok()) {
+        state.SkipWithError("Failed to write blob");
+        break;
+      }
+    }
+    if (!writer->close().ok()) {
+      state.SkipWithError("Failed to close writer");
+      break;
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * kBlobsPerIteration *
+                          static_cast<int64_t>(blob_size));
+  state.counters["ratio"] =
+      static_cast<double>(blob_size * kBlobsPerIteration) /
+      static_cast<double>(buffer->size());
+}
+
+BENCHMARK(BM_WriteBlob)
+    ->ArgNames({"codec", "blob_size"})
+    ->ArgsProduct({{0, 1, 2}, {4 << 10, 1 << 20}})
+    ->Unit(benchmark::kMicrosecond);
+
+// Latency of IcypuffWriter::close(), which serializes and writes the footer
+void BM_WriterClose(benchmark::State& state) {
+  const auto blob_count = static_cast<int>(state.range(0));
+  const std::vector<uint8_t> blob(bench::kSketchBlobSize, 0x2A);
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto writer_result =
+        Icypuff::write(std::make_unique<MemoryOutputFile>())
+            .created_by("icypuff-bench")
+            .build();
+    if (!writer_result.ok()) {
+      state.SkipWithError("Failed to create writer");
+      break;
+    }
+    auto writer = std::move(writer_result).value();
+    for (int i = 0; i < blob_count; i++) {
+      auto params = SketchMetadata(i);
+      auto blob_result = writer->write_blob(
+          blob.data(), blob.size(), params.type, params.input_fields,
+          params.snapshot_id, params.sequence_number, CompressionCodec::None,
+          params.properties);
+      if (!blob_result.ok()) {
+        state.SkipWithError("Failed to write blob");
+        break;
+      }
+    }
+    state.ResumeTiming();
+
+    auto close_result = writer->close();
+    if (!close_result.ok()) {
+      state.SkipWithError("Failed to close writer");
+      break;
+    }
+
+    state.PauseTiming();
+    writer.reset();
+    state.ResumeTiming();
+  }
+  state.counters["blobs"] = blob_count;
+}
+
+BENCHMARK(BM_WriterClose)
+    ->Arg(1000)
+    ->Arg(100000)
+    ->Unit(benchmark::kMillisecond)
+    ->Iterations(10);
+
+}  // namespace
+}  // namespace icypuff
@@ -0,0 +1,274 @@
+#include <cxxopts.hpp>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "icypuff/icypuff.h"
+#include "icypuff/icypuff_verifier.h"
+#include "icypuff/local_input_file.h"
+#include "icypuff/local_output_file.h"
+#include "icypuff/synthetic_dataset.h"
+
+namespace {
+
+constexpr const char* USAGE =
+    "Usage: puffin-tool <command> [options]\n"
+    "\n"
+    "Commands:\n"
+    "  merge      Merge Puffin files into one without recompressing blobs\n"
+    "  generate   Write a synthetic Puffin file for scale testing\n"
+    "  verify     Check the structure and every blob of Puffin files\n";
+
+// Merges the input files, copying the compressed blob bytes verbatim
+int merge(int argc, char* argv[]) {
+  cxxopts::Options options("puffin-tool merge",
+                           "Merge Puffin files into one without decoding "
+                           "their blobs");
+  options.add_options()("h,help", "Print usage")(
+      "o,output", "Merged Puffin file", cxxopts::value<std::string>())(
+      "drop-snapshot", "Drop blobs of a snapshot id (repeatable)",
+      cxxopts::value<std::vector<int64_t>>())(
+      "type", "Keep only blobs of a type (repeatable)",
+      cxxopts::value<std::vector<std::string>>())(
+      "created-by", "created-by property of the merged file",
+      cxxopts::value<std::string>()->default_value("puffin-tool"))(
+      "compress-footer", "Compress the merged footer with Zstd")(
+      "blob-index", "Write a binary blob index for fast opens")(
+      "inputs", "Puffin files to merge",
+      cxxopts::value<std::vector<std::string>>());
+  options.parse_positional({"inputs"});
+  options.positional_help("<input>...");
+
+  auto result = options.parse(argc, argv);
+  if (result.count("help") || !result.count("output") ||
+      !result.count("inputs")) {
+    std::cout << options.help() << std::endl;
+    return result.count("help") ? 0 : 1;
+  }
+
+  std::unordered_set<int64_t> dropped_snapshots;
+  if (result.count("drop-snapshot")) {
+    for (int64_t id : result["drop-snapshot"].as<std::vector<int64_t>>()) {
+      dropped_snapshots.insert(id);
+    }
+  }
+  std::unordered_set<std::string> kept_types;
+  if (result.count("type")) {
+    for (const auto& type : result["type"].as<std::vector<std::string>>()) {
+      kept_types.insert(type);
+    }
+  }
+
+  auto builder =
+      icypuff::Icypuff::merge(std::make_unique<icypuff::LocalOutputFile>(
+          result["output"].as<std::string>()));
+  for (const auto& input : result["inputs"].as<std::vector<std::string>>()) {
+    builder.add_input(std::make_unique<icypuff::LocalInputFile>(input));
+  }
+  builder.created_by(result["created-by"].as<std::string>());
+  if (result.count("compress-footer")) {
+    builder.compress_footer();
+  }
+  if (result.count("blob-index")) {
+    builder.write_blob_index();
+  }
+  if (!dropped_snapshots.empty() || !kept_types.empty()) {
+    builder.filter([&](const icypuff::BlobMetadata& blob) {
+      return !dropped_snapshots.contains(blob.snapshot_id()) &&
+             (kept_types.empty() || kept_types.contains(blob.type()));
+    });
+  }
+
+  auto merger_result = builder.build();
+  if (!merger_result.ok()) {
+    std::cerr << "Failed to create merger: " << merger_result.error().message
+              << std::endl;
+    return 1;
+  }
+  auto summary = merger_result.value()->merge();
+  if (!summary.ok()) {
+    std::cerr << "Failed to merge: " << summary.error().message << std::endl;
+    return 1;
+  }
+
+  std::cout << "Merged " << summary.value().input_files << " files: "
+            << summary.value().blobs_copied << " blobs copied, "
+            << summary.value().blobs_dropped << " dropped, "
+            << summary.value().bytes_copied << " blob bytes, "
+            << summary.value().file_size << " bytes written" << std::endl;
+  return 0;
+}
+
+// Writes a synthetic Puffin file of the requested shape
+int generate(int argc, char* argv[]) {
+  cxxopts::Options options("puffin-tool generate",
+                           "Write a synthetic Puffin file for benchmarks and "
+                           "scale tests");
+  options.add_options()("h,help", "Print usage")(
+      "o,output", "Puffin file to write", cxxopts::value<std::string>())(
+      "blobs", "Number of blobs (1 to 1000000)",
+      cxxopts::value<int64_t>()->default_value("1000"))(
+      "size-distribution", "Blob sizes: fixed, uniform or lognormal",
+      cxxopts::value<std::string>()->default_value("fixed"))(
+      "min-size", "Smallest blob size, and the size of fixed blobs",
+      cxxopts::value<size_t>()->default_value("64"))(
+      "max-size", "Largest blob size",
+      cxxopts::value<size_t>()->default_value("64"))(
+      "type", "Blob type, repeat to mix types",
+      cxxopts::value<std::vector<std::string>>())(
+      "codec", "Blob codec: none, lz4 or zstd, repeat to mix codecs",
+      cxxopts::value<std::vector<std::string>>())(
+      "properties", "Properties per blob",
+      cxxopts::value<int>()->default_value("1"))(
+      "property-cardinality", "Distinct values per property",
+      cxxopts::value<int64_t>()->default_value("1000"))(
+      "fields", "Distinct input field ids",
+      cxxopts::value<int64_t>()->default_value("100"))(
+      "snapshots", "Distinct snapshot ids",
+      cxxopts::value<int64_t>()->default_value("1"))(
+      "compress-footer", "Compress the footer")(
+      "blob-index", "Write a binary blob index for fast opens")(
+      "seed", "Random seed", cxxopts::value<uint32_t>()->default_value("42"));
+
+  auto result = options.parse(argc, argv);
+  if (result.count("help") || !result.count("output")) {
+    std::cout << options.help() << std::endl;
+    return result.count("help") ? 0 : 1;
+  }
+
+  icypuff::SyntheticDatasetOptions dataset;
+  dataset.blob_count = result["blobs"].as<int64_t>();
+  std::string distribution = result["size-distribution"].as<std::string>();
+  if (distribution == "fixed") {
+    dataset.size_distribution = icypuff::BlobSizeDistribution::kFixed;
+  } else if (distribution == "uniform") {
+    dataset.size_distribution = icypuff::BlobSizeDistribution::kUniform;
+  } else if (distribution == "lognormal") {
+    dataset.size_distribution = icypuff::BlobSizeDistribution::kLogNormal;
+  } else {
+    std::cerr << "Unknown size distribution: " << distribution << std::endl;
+    return 1;
+  }
+  dataset.min_blob_size = result["min-size"].as<size_t>();
+  dataset.max_blob_size = result["max-size"].as<size_t>();
+  if (result.count("type")) {
+    dataset.types = result["type"].as<std::vector<std::string>>();
+  }
+  if (result.count("codec")) {
+    dataset.codecs.clear();
+    for (const auto& name : result["codec"].as<std::vector<std::string>>()) {
+      auto codec = icypuff::GetCodecFromName(
+          name == "none" ? std::nullopt : std::optional<std::string>(name));
+      if (!codec.has_value()) {
+        std::cerr << "Unknown codec: " << name << std::endl;
+        return 1;
+      }
+      dataset.codecs.push_back(codec.value());
+    }
+  }
+  dataset.properties_per_blob = result["properties"].as<int>();
+  dataset.property_cardinality = result["property-cardinality"].as<int64_t>();
+  dataset.field_count = result["fields"].as<int64_t>();
+  dataset.snapshot_count = result["snapshots"].as<int64_t>();
+  dataset.compress_footer = result.count("compress-footer") > 0;
+  dataset.write_blob_index = result.count("blob-index") > 0;
+  dataset.seed = result["seed"].as<uint32_t>();
+
+  auto summary = icypuff::GenerateSyntheticDataset(
+      std::make_unique<icypuff::LocalOutputFile>(
+          result["output"].as<std::string>()),
+      dataset);
+  if (!summary.ok()) {
+    std::cerr << "Failed to generate: " << summary.error().message
+              << std::endl;
+    return 1;
+  }
+
+  std::cout << "Generated " << summary.value().blob_count << " blobs: "
+            << summary.value().data_bytes << " uncompressed blob bytes, "
+            << summary.value().footer_size << " footer bytes, "
+            << summary.value().file_size << " bytes written" << std::endl;
+  return 0;
+}
+
+// Verifies each file, printing its problems. Fails if any file has one.
+int verify(int argc, char* argv[]) {
+  cxxopts::Options options("puffin-tool verify",
+                           "Check the magics, footer, blob bounds and every "
+                           "compressed frame of Puffin files");
+  options.add_options()("h,help", "Print usage")(
+      "threads", "Worker threads per file, 0 for one per core",
+      cxxopts::value<int>()->default_value("0"))(
+      "inputs", "Puffin files to verify",
+      cxxopts::value<std::vector<std::string>>());
+  options.parse_positional({"inputs"});
+  options.positional_help("<input>...");
+
+  auto result = options.parse(argc, argv);
+  if (result.count("help") || !result.count("inputs")) {
+    std::cout << options.help() << std::endl;
+    return result.count("help") ? 0 : 1;
+  }
+
+  icypuff::IcypuffVerifierParams params;
+  params.threads = result["threads"].as<int>();
+
+  int status = 0;
+  for (const auto& input : result["inputs"].as<std::vector<std::string>>()) {
+    icypuff::IcypuffVerifier verifier(
+        std::make_unique<icypuff::LocalInputFile>(input), params);
+    auto report = verifier.verify();
+    if (!report.ok()) {
+      std::cerr << input << ": failed to read: " << report.error().message
+                << std::endl;
+      status = 1;
+      continue;
+    }
+    for (const auto& issue : report.value().issues) {
+      std::cout << input << ": ";
+      if (issue.blob_index >= 0) {
+        std::cout << "blob " << issue.blob_index << ": ";
+      }
+      std::cout << issue.message << std::endl;
+    }
+    std::cout << input << ": " << report.value().blobs_checked
+              << " blobs checked, " << report.value().bytes_read
+              << " bytes read, " << report.value().issues.size() << " issues"
+              << std::endl;
+    if (!report.value().ok()) {
+      status = 1;
+    }
+  }
+  return status;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    std::cout << USAGE;
+    return 1;
+  }
+
+  // Each command parses the remaining arguments with its own options
+  std::string command = argv[1];
+  try {
+    if (command == "merge") {
+      return merge(argc - 1, argv + 1);
+    }
+    if (command == "generate") {
+      return generate(argc - 1, argv + 1);
+    }
+    if (command == "verify") {
+      return verify(argc - 1, argv + 1);
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+
+  std::cout << USAGE;
+  return command == "-h" || command == "--help" ? 0 : 1;
+}
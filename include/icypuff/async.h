@@ -0,0 +1,99 @@
+#pragma once
+
+#include <coroutine>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <semaphore>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "icypuff/macros.h"
+
+namespace icypuff {
+
+// Runs work items on threads of its choosing. Adapt an event loop or
+// thread pool to this to use the awaitable reader and writer calls.
+class Executor {
+ public:
+  virtual ~Executor() = default;
+
+  // Run work soon. Must not run it inline, callers may hold locks.
+  virtual void post(std::function<void()> work) = 0;
+};
+
+// Fixed pool of threads for the blocking file I/O behind the awaitable
+// calls, so event loop threads never block on a read or write
+class ThreadPoolExecutor : public Executor {
+ public:
+  // 0 uses one thread per core
+  explicit ThreadPoolExecutor(int threads = 0);
+
+  ICYPUFF_DISALLOW_COPY_ASSIGN_AND_MOVE(ThreadPoolExecutor);
+
+  // Runs the work already posted, then joins the threads
+  ~ThreadPoolExecutor() override;
+
+  void post(std::function<void()> work) override;
+
+  int threads() const { return static_cast<int>(threads_.size()); }
+
+ private:
+  void run();
+
+  std::mutex mutex_;
+  std::deque<std::function<void()>> work_;
+  // One permit per posted work item, plus one per thread when stopping
+  std::counting_semaphore<> permits_{0};
+  std::vector<std::thread> threads_;
+};
+
+// Awaitable running a blocking operation on an executor. The awaiting
+// coroutine is suspended without blocking its thread and resumed on the
+// executor thread that ran the operation; co_await ResumeOn(loop) to
+// continue on another executor. Await it once, within the full expression
+// or statement that created it.
+template <typename T>
+class AsyncResult {
+ public:
+  AsyncResult(Executor& executor, std::function<T()> operation)
+      : executor_(executor), operation_(std::move(operation)) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend(std::coroutine_handle<> awaiting) {
+    executor_.post([this, awaiting]() {
+      result_.emplace(operation_());
+      // Resuming may destroy this awaitable, so nothing touches it after
+      awaiting.resume();
+    });
+  }
+
+  T await_resume() { return std::move(*result_); }
+
+ private:
+  Executor& executor_;
+  std::function<T()> operation_;
+  std::optional<T> result_;
+};
+
+// Awaitable moving the awaiting coroutine onto an executor
+class ResumeOn {
+ public:
+  explicit ResumeOn(Executor& executor) : executor_(executor) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend(std::coroutine_handle<> awaiting) {
+    executor_.post([awaiting]() { awaiting.resume(); });
+  }
+
+  void await_resume() const noexcept {}
+
+ private:
+  Executor& executor_;
+};
+
+}  // namespace icypuff
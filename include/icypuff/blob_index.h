@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "icypuff/blob_metadata.h"
+#include "icypuff/file_metadata.h"
+#include "icypuff/result.h"
+
+namespace icypuff {
+
+// Blob type of the binary blob index. The index is an ordinary, spec
+// compliant blob that other readers skip, written last before the footer so
+// this library's reader can find it from the footer position alone.
+static constexpr std::string_view BLOB_INDEX_BLOB_TYPE = "icypuff-index-v1";
+
+// The index blob's own footer entry is not tied to a snapshot. Its fields
+// are all fields of the indexed blobs, see BlobIndexFields.
+static constexpr int64_t BLOB_INDEX_SNAPSHOT_ID = -1;
+static constexpr int64_t BLOB_INDEX_SEQUENCE_NUMBER = -1;
+// Footer entries need at least one field, used when no blob has any
+static constexpr int BLOB_INDEX_DEFAULT_FIELD_ID = 0;
+
+// Fixed size trailer ending the index blob:
+//   0  int64   offset of the index blob in the file
+//   8  int64   length of the body preceding the trailer
+//   16 uint64  checksum of the body
+//   24 uint32  layout version
+//   28 4 bytes BLOB_INDEX_MAGIC
+// All integers are little-endian.
+static constexpr int BLOB_INDEX_TRAILER_LENGTH = 32;
+static constexpr uint32_t BLOB_INDEX_VERSION = 1;
+static constexpr uint8_t BLOB_INDEX_MAGIC[] = {'P', 'F', 'I', 'X'};
+
+// Sorted distinct field ids of the blobs, the index blob's own fields
+std::vector<int> BlobIndexFields(
+    const std::vector<std::unique_ptr<BlobMetadata>>& blobs);
+
+// Serializes the footer contents into an index blob that will be written at
+// index_offset. The body interns every string once, then lists each blob's
+// offset, length, snapshot id, sequence number, type id, codec id, field
+// ids and properties, and ends with the index blob's own fields. Fails for
+// blobs with a codec this library does not know, whose files are left
+// without an index.
+Result<std::vector<uint8_t>> EncodeBlobIndex(
+    const std::vector<std::unique_ptr<BlobMetadata>>& blobs,
+    const std::unordered_map<std::string, std::string>& properties,
+    int64_t index_offset);
+
+// Returns the offset and length of the index blob ending at data_end, given
+// the BLOB_INDEX_TRAILER_LENGTH bytes before data_end, or std::nullopt if
+// they are not an index trailer
+struct BlobIndexLocation {
+  int64_t offset;
+  int64_t length;
+};
+std::optional<BlobIndexLocation> ParseBlobIndexTrailer(const uint8_t* trailer,
+                                                       int64_t data_end);
+
+// Rebuilds the footer from a whole index blob, including the index blob's
+// own entry, so it matches what the JSON footer would give
+Result<std::unique_ptr<FileMetadata>> DecodeBlobIndex(
+    const std::vector<uint8_t>& data, const BlobIndexLocation& location);
+
+}  // namespace icypuff
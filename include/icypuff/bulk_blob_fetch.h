@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "icypuff/blob_metadata.h"
+#include "icypuff/icypuff_reader.h"
+#include "icypuff/result.h"
+
+namespace icypuff {
+
+struct BulkFetchParams {
+  // Worker threads reading and decoding blobs, 0 uses one per core
+  int threads = 0;
+  // Blob bytes read but not yet handed to the callback. A read is only
+  // started when it fits, except that one read is always allowed so blobs
+  // larger than the limit are still fetched.
+  int64_t max_in_flight_bytes = 256 << 20;
+  // Adjacent blobs of a file are read together up to this many bytes per
+  // read, capped at max_in_flight_bytes
+  int64_t max_read_size = 8 << 20;
+  // Blobs separated by at most this many unused bytes share a read
+  int64_t max_read_gap = 64 << 10;
+  // Hand blobs to the callback as stored instead of decompressed
+  bool raw = false;
+};
+
+// One blob to fetch. The reader must outlive the fetch and blob must be
+// metadata of a blob in the reader's file.
+struct BlobFetchRequest {
+  const IcypuffReader* reader;
+  const BlobMetadata* blob;
+};
+
+struct BulkFetchStats {
+  // Blobs handed to the callback, and how many of them with an error
+  int64_t blobs = 0;
+  int64_t failures = 0;
+  // Reads issued after coalescing and the bytes they returned
+  int64_t reads = 0;
+  int64_t bytes_read = 0;
+  // Tasks a worker took from another worker's queue
+  int64_t steals = 0;
+  // Highest number of blob bytes in flight at once
+  int64_t peak_in_flight_bytes = 0;
+};
+
+// Called once per request with its index in the request list and the
+// blob's data or the error fetching it. Called from the worker threads,
+// concurrently and in no particular order. A blob's bytes count against
+// the in-flight limit until the callback returns, so a slow consumer
+// throttles the reads.
+using BlobFetchCallback =
+    std::function<void(size_t request_index, Result<std::vector<uint8_t>>)>;
+
+// Fetches many blobs spread over many files. The requests of each file are
+// sorted and coalesced into large reads, and the reads and per-blob
+// decompression run as tasks on a work-stealing pool: each worker owns the
+// reads of some files and decodes what it read while the data is hot, and
+// idle workers steal queued reads and decodes from busy ones.
+//
+// Fails only for invalid requests, errors reading or decoding a blob are
+// passed to the callback.
+Result<BulkFetchStats> FetchBlobs(const std::vector<BlobFetchRequest>& requests,
+                                  const BlobFetchCallback& callback,
+                                  BulkFetchParams params = {});
+
+}  // namespace icypuff
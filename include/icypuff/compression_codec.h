@@ -9,6 +9,9 @@
 
 namespace icypuff {
 
+// Zstd level used for blobs and footers, matching the Java implementation
+static constexpr int DEFAULT_ZSTD_COMPRESSION_LEVEL = 3;
+
 // RAII wrapper for ZSTD_CCtx
 class ZstdContext {
  public:
@@ -45,6 +48,45 @@ class ZstdContext {
   ZSTD_CCtx* ctx_;
 };
 
+// RAII wrapper for ZSTD_DCtx
+class ZstdDecompressionContext {
+ public:
+  ZstdDecompressionContext() : ctx_(ZSTD_createDCtx()) {}
+  ~ZstdDecompressionContext() {
+    if (ctx_) {
+      ZSTD_freeDCtx(ctx_);
+    }
+  }
+
+  // Delete copy operations
+  ZstdDecompressionContext(const ZstdDecompressionContext&) = delete;
+  ZstdDecompressionContext& operator=(const ZstdDecompressionContext&) =
+      delete;
+
+  // Allow move operations
+  ZstdDecompressionContext(ZstdDecompressionContext&& other) noexcept
+      : ctx_(other.ctx_) {
+    other.ctx_ = nullptr;
+  }
+  ZstdDecompressionContext& operator=(
+      ZstdDecompressionContext&& other) noexcept {
+    if (this != &other) {
+      if (ctx_) {
+        ZSTD_freeDCtx(ctx_);
+      }
+      ctx_ = other.ctx_;
+      other.ctx_ = nullptr;
+    }
+    return *this;
+  }
+
+  ZSTD_DCtx* get() const { return ctx_; }
+  bool valid() const { return ctx_ != nullptr; }
+
+ private:
+  ZSTD_DCtx* ctx_;
+};
+
 enum class CompressionCodec {
   None,  // No compression
   Lz4,   // LZ4 single compression frame with content size present
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "icypuff/compression_codec.h"
+
+namespace icypuff {
+
+// Chooses the codec of each blob from a cheap compressibility estimate, so
+// already-compact data is not compressed for a marginal gain.
+struct AdaptiveCompressionPolicy {
+  // Codec used for blobs that compress well
+  CompressionCodec preferred = CompressionCodec::Zstd;
+  // Minimum expected size reduction, as a fraction, to compress at all
+  double min_gain = 0.05;
+  // Minimum expected size reduction to use Zstd instead of the cheaper LZ4
+  double min_zstd_gain = 0.15;
+  // Number of bytes sampled from each blob for the estimate
+  size_t sample_size = 64 * 1024;
+};
+
+// Estimated fraction of bytes saved by compressing a blob
+struct CompressibilityEstimate {
+  double lz4_gain;      // From LZ4-compressing the sample
+  double entropy_gain;  // From the order-0 byte entropy of the sample
+};
+
+// Estimates compressibility from evenly spaced chunks of the blob
+CompressibilityEstimate EstimateCompressibility(const uint8_t* data,
+                                                size_t length,
+                                                size_t sample_size);
+
+// Selects the codec for a blob according to the policy
+CompressionCodec SelectCompressionCodec(const AdaptiveCompressionPolicy& policy,
+                                        const uint8_t* data, size_t length);
+
+}  // namespace icypuff
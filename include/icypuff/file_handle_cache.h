@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "icypuff/macros.h"
+#include "icypuff/result.h"
+
+namespace icypuff {
+
+struct FileHandleCacheParams {
+  // Descriptors kept open, in use or idle. Handles in use are never
+  // closed, so the limit is exceeded while more files than this are read
+  // at once.
+  size_t max_open_handles = 256;
+  // Check with a stat on every acquire that the path still names the
+  // cached file, so deleted or replaced files are reopened. Still much
+  // cheaper than an open and close; turn off for files that are never
+  // replaced, such as Iceberg statistics files.
+  bool revalidate = true;
+};
+
+struct FileHandleCacheStats {
+  // Acquires served by an open descriptor, and those that opened one
+  int64_t hits = 0;
+  int64_t misses = 0;
+  // Idle descriptors closed to stay within the limit
+  int64_t evictions = 0;
+  // Descriptors currently open
+  int64_t open_handles = 0;
+};
+
+class FileHandleCache;
+
+// A lease on a cached read-only descriptor, returned to the cache when
+// destroyed. The descriptor is shared and must only be used for
+// positional reads.
+class FileHandle {
+ public:
+  FileHandle() = default;
+  FileHandle(FileHandle&& other) noexcept;
+  FileHandle& operator=(FileHandle&& other) noexcept;
+  ICYPUFF_DISALLOW_COPY_AND_ASSIGN(FileHandle);
+
+  ~FileHandle();
+
+  int fd() const;
+
+ private:
+  friend class FileHandleCache;
+  struct Entry;
+
+  FileHandle(FileHandleCache* cache, std::shared_ptr<Entry> entry);
+  void release();
+
+  FileHandleCache* cache_ = nullptr;
+  std::shared_ptr<Entry> entry_;
+};
+
+// Open descriptors keyed by path, shared by every LocalInputFile so
+// readers of recently used files skip the open and close syscalls.
+// Descriptors are reference counted and idle ones are closed least
+// recently used first once more than max_open_handles are open.
+class FileHandleCache {
+ public:
+  static Result<std::unique_ptr<FileHandleCache>> Create(
+      FileHandleCacheParams params = {});
+
+  // Process-wide cache used by LocalInputFile unless given another one.
+  // Never destroyed, so handles may outlive static destructors.
+  static FileHandleCache& Default();
+
+  ICYPUFF_DISALLOW_COPY_ASSIGN_AND_MOVE(FileHandleCache);
+
+  // All handles must have been released
+  ~FileHandleCache();
+
+  // Lease a descriptor for path, opening it if none is cached
+  Result<FileHandle> acquire(const std::filesystem::path& path);
+
+  // Drop the descriptor of a replaced or deleted file. Handles in use keep
+  // reading the old file and close it when released.
+  void invalidate(const std::filesystem::path& path);
+
+  // Change the limit, closing idle descriptors above it
+  void set_max_open_handles(size_t max_open_handles);
+
+  FileHandleCacheStats stats() const;
+
+ private:
+  friend class FileHandle;
+  using Entry = FileHandle::Entry;
+
+  explicit FileHandleCache(FileHandleCacheParams params);
+
+  void release(const std::shared_ptr<Entry>& entry);
+  // Close idle descriptors until within the limit, mutex_ held
+  void evict_idle();
+  // Forget a cached entry, closing it unless in use, mutex_ held
+  void detach(std::unordered_map<std::string,
+                                 std::shared_ptr<Entry>>::iterator it);
+
+  FileHandleCacheParams params_;
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, std::shared_ptr<Entry>> entries_;
+  // Idle entries, most recently released first
+  std::list<Entry*> idle_;
+  FileHandleCacheStats stats_;
+};
+
+}  // namespace icypuff
@@ -2,8 +2,12 @@
 
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
+#include "icypuff/blob_metadata.h"
 #include "icypuff/file_metadata.h"
+#include "icypuff/position_output_stream.h"
 #include "icypuff/result.h"
 
 namespace icypuff {
@@ -17,6 +21,20 @@ class FileMetadataParser {
   static Result<std::string> ToJson(const FileMetadata& metadata,
                                     bool pretty = false);
 
+  // Serialize footer JSON for the given blobs and properties by appending it
+  // to out. The output is byte-identical to ToJson.
+  static Result<void> AppendJson(
+      const std::vector<std::unique_ptr<BlobMetadata>>& blobs,
+      const std::unordered_map<std::string, std::string>& properties,
+      std::string& out, bool pretty = false);
+
+  // Serialize footer JSON straight into the stream in bounded chunks.
+  // Returns the number of bytes written.
+  static Result<int64_t> WriteJson(
+      const std::vector<std::unique_ptr<BlobMetadata>>& blobs,
+      const std::unordered_map<std::string, std::string>& properties,
+      PositionOutputStream& stream, bool pretty = false);
+
   // Parse FileMetadata from JSON string
   static Result<std::unique_ptr<FileMetadata>> FromJson(
       const std::string& json);
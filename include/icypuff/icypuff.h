@@ -2,9 +2,14 @@
 
 #include <memory>
 #include <string>
+#include <optional>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "icypuff/compression_codec.h"
+#include "icypuff/compression_policy.h"
+#include "icypuff/icypuff_merger.h"
 #include "icypuff/icypuff_reader.h"
 #include "icypuff/icypuff_writer.h"
 #include "icypuff/output_file.h"
@@ -37,14 +42,115 @@ class IcypuffWriteBuilder {
   // Configures the writer to compress the blobs
   IcypuffWriteBuilder& compress_blobs(CompressionCodec compression);
 
+  // Configures the writer to pick each blob's codec from a compressibility
+  // estimate, falling back to LZ4 or no compression when the gain is small
+  IcypuffWriteBuilder& compress_blobs_adaptive(
+      const AdaptiveCompressionPolicy& policy = {});
+
+  // Configures multi-threaded Zstd compression for very large blobs
+  IcypuffWriteBuilder& zstd_large_blobs(const ZstdLargeBlobOptions& options);
+
+  // Writes a binary index of the footer so this library's reader can open
+  // the file without parsing the JSON footer
+  IcypuffWriteBuilder& write_blob_index();
+
+  // Build and return the IcypuffWriter
+  Result<std::unique_ptr<IcypuffWriter>> build();
+
+ private:
+  std::unique_ptr<OutputFile> output_file_;
+  IcypuffWriterParams params_;
+};
+
+// Builder for an IcypuffWriter that appends to an existing file. The
+// existing footer is reused, only the footer region is truncated, and new
+// blobs are written after the last existing blob. Closing the writer without
+// writing blobs rewrites only the footer, e.g. to update file properties.
+//
+// build() leaves the file untouched. The footer is truncated on the
+// writer's first write or on close, so a writer abandoned after that point,
+// by an error or by destroying it without close(), leaves the file without
+// a footer and its existing blobs unreadable. Readers of the file must not
+// run concurrently with an append.
+class IcypuffAppendBuilder {
+ public:
+  IcypuffAppendBuilder(std::unique_ptr<InputFile> input_file,
+                       std::unique_ptr<OutputFile> output_file);
+
+  // Sets or replaces a file-level property
+  IcypuffAppendBuilder& set(const std::string& property,
+                            const std::string& value);
+
+  // Sets or replaces file-level properties
+  IcypuffAppendBuilder& set_all(
+      const std::unordered_map<std::string, std::string>& props);
+
+  // Removes a file-level property
+  IcypuffAppendBuilder& remove(const std::string& property);
+
+  // Configures the writer to compress the footer
+  IcypuffAppendBuilder& compress_footer();
+
+  // Configures the writer to compress the appended blobs
+  IcypuffAppendBuilder& compress_blobs(CompressionCodec compression);
+
+  // Configures adaptive codec selection for the appended blobs
+  IcypuffAppendBuilder& compress_blobs_adaptive(
+      const AdaptiveCompressionPolicy& policy = {});
+
+  // Writes a binary index of the footer. The existing index, if any, is
+  // always dropped and replaced with one that covers the appended blobs.
+  IcypuffAppendBuilder& write_blob_index();
+
   // Build and return the IcypuffWriter
   Result<std::unique_ptr<IcypuffWriter>> build();
 
  private:
+  std::unique_ptr<InputFile> input_file_;
   std::unique_ptr<OutputFile> output_file_;
-  std::unordered_map<std::string, std::string> properties_;
-  bool compress_footer_ = false;
-  CompressionCodec default_blob_compression_ = CompressionCodec::None;
+  // Property updates in call order, std::nullopt removes the property
+  std::vector<std::pair<std::string, std::optional<std::string>>>
+      property_updates_;
+  IcypuffWriterParams params_;
+};
+
+// Builder for an IcypuffMerger that compacts Puffin files into one
+class IcypuffMergeBuilder {
+ public:
+  explicit IcypuffMergeBuilder(std::unique_ptr<OutputFile> output_file);
+
+  // Adds an input file, blobs are copied in input order
+  IcypuffMergeBuilder& add_input(std::unique_ptr<InputFile> input_file);
+
+  // Sets file-level property to be written
+  IcypuffMergeBuilder& set(const std::string& property,
+                           const std::string& value);
+
+  // Sets file-level properties to be written
+  IcypuffMergeBuilder& set_all(
+      const std::unordered_map<std::string, std::string>& props);
+
+  // Sets file-level created_by property
+  IcypuffMergeBuilder& created_by(const std::string& application_identifier);
+
+  // Configures the merger to compress the footer
+  IcypuffMergeBuilder& compress_footer();
+
+  // Writes a binary index of the merged footer. Index blobs of the inputs
+  // are never copied.
+  IcypuffMergeBuilder& write_blob_index();
+
+  // Keeps only the blobs accepted by the filter, e.g. to drop blobs of
+  // expired snapshots
+  IcypuffMergeBuilder& filter(BlobFilter filter);
+
+  // Build and return the IcypuffMerger
+  Result<std::unique_ptr<IcypuffMerger>> build();
+
+ private:
+  std::unique_ptr<OutputFile> output_file_;
+  std::vector<std::unique_ptr<InputFile>> input_files_;
+  IcypuffMergerParams params_;
 };
 
 // Builder for IcypuffReader
@@ -76,6 +182,14 @@ class Icypuff {
   // Factory methods
   static IcypuffWriteBuilder write(std::unique_ptr<OutputFile> output_file);
   static IcypuffReadBuilder read(std::unique_ptr<InputFile> input_file);
+
+  // Appends to the existing file read through input_file and written through
+  // output_file, which must refer to the same location
+  static IcypuffAppendBuilder append(std::unique_ptr<InputFile> input_file,
+                                     std::unique_ptr<OutputFile> output_file);
+
+  // Merges Puffin files into output_file without decoding their blobs
+  static IcypuffMergeBuilder merge(std::unique_ptr<OutputFile> output_file);
 };
 
 }  // namespace icypuff
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "icypuff/blob_metadata.h"
+#include "icypuff/input_file.h"
+#include "icypuff/macros.h"
+#include "icypuff/output_file.h"
+#include "icypuff/result.h"
+
+namespace icypuff {
+
+// Decides whether a blob of an input file is kept in the merged file
+using BlobFilter = std::function<bool(const BlobMetadata&)>;
+
+struct IcypuffMergerParams {
+  // File-level properties of the merged file
+  std::unordered_map<std::string, std::string> properties;
+  bool compress_footer = false;
+  bool write_blob_index = false;
+  // Keeps every blob when empty
+  BlobFilter filter;
+};
+
+struct MergeSummary {
+  int64_t input_files = 0;
+  int64_t blobs_copied = 0;
+  int64_t blobs_dropped = 0;
+  int64_t bytes_copied = 0;
+  int64_t file_size = 0;
+};
+
+// Merges Puffin files into one without decoding their blobs. Blob bytes are
+// copied verbatim, through the output stream's zero-copy transfer when the
+// files allow it, and the merged footer records their new offsets.
+//
+// Zstd dictionary blobs are not subject to the filter: each is kept exactly
+// when a kept blob references it, and only once across inputs. Blob index
+// blobs of the inputs would be stale and are always dropped.
+class IcypuffMerger {
+ public:
+  IcypuffMerger(std::vector<std::unique_ptr<InputFile>> input_files,
+                std::unique_ptr<OutputFile> output_file,
+                IcypuffMergerParams params);
+
+  ICYPUFF_DISALLOW_COPY_ASSIGN_AND_MOVE(IcypuffMerger);
+
+  ~IcypuffMerger() = default;
+
+  // Write the merged file
+  Result<MergeSummary> merge();
+
+ private:
+  std::vector<std::unique_ptr<InputFile>> input_files_;
+  std::unique_ptr<OutputFile> output_file_;
+  IcypuffMergerParams params_;
+};
+
+}  // namespace icypuff
@@ -1,22 +1,38 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "icypuff/async.h"
 #include "icypuff/blob_metadata.h"
+#include "icypuff/compression_codec.h"
 #include "icypuff/file_metadata.h"
 #include "icypuff/input_file.h"
 #include "icypuff/result.h"
-#include "icypuff/seekable_input_stream.h"
+#include "icypuff/stats.h"
+#include "icypuff/zstd_dictionary.h"
 
 namespace icypuff {
 
 // Forward declarations
 class BlobMetadata;
 
+// A blob's bytes exactly as stored in the file
+struct RawBlob {
+  std::vector<uint8_t> data;
+  CompressionCodec codec;
+};
+
+// Reads a Puffin file through positional reads on its InputFile. The
+// footer is loaded once, on first use, and shared by all callers; a failed
+// load is reported to every later call. All const methods may be called
+// from any number of threads at once, so one reader per file can serve a
+// whole process.
 class IcypuffReader {
  public:
   // Constructor
@@ -25,15 +41,61 @@ class IcypuffReader {
                 std::optional<int64_t> footer_size = std::nullopt);
 
   // Get all blob metadata from the file
-  Result<std::vector<std::unique_ptr<BlobMetadata>>> get_blobs();
+  Result<std::vector<std::unique_ptr<BlobMetadata>>> get_blobs() const;
 
-  // Get file properties
+  // The parsed footer, shared without copying its blobs. Valid for the
+  // lifetime of the reader.
+  Result<const FileMetadata*> file_metadata() const;
+
+  // Get file properties, loading the footer if needed. Empty if the footer
+  // cannot be loaded.
   const std::unordered_map<std::string, std::string>& properties() const;
 
+  // Get the footer size in bytes, including magics and the footer struct
+  Result<int64_t> footer_size() const;
+
+  // Get the file being read
+  const InputFile& input_file() const { return *input_file_; }
+
   // Read a blob's data
-  Result<std::vector<uint8_t>> read_blob(const BlobMetadata& blob);
+  Result<std::vector<uint8_t>> read_blob(const BlobMetadata& blob) const;
+
+  // Read several blobs with one batch of reads, so input files that keep
+  // many reads in flight fetch them concurrently. Results are in the order
+  // of blobs.
+  std::vector<Result<std::vector<uint8_t>>> read_blobs(
+      const std::vector<const BlobMetadata*>& blobs) const;
+
+  // Read a byte range holding blob_count whole blobs with one positional
+  // read, counted in the reader's stats like the blob reads it replaces.
+  // Callers coalescing the reads of neighbouring blobs decode them from the
+  // buffer with decode_blob.
+  Result<void> read_blob_range(int64_t offset, uint8_t* buffer, size_t length,
+                               size_t blob_count) const;
 
-  // Close the reader
+  // Decompress a blob's stored bytes, read by the caller, loading its Zstd
+  // dictionary if it has one
+  Result<std::vector<uint8_t>> decode_blob(const BlobMetadata& blob,
+                                           const uint8_t* data,
+                                           size_t length) const;
+
+  // Read a blob's bytes without decompressing them. Blobs compressed with a
+  // Zstd dictionary reference it through their properties and need the
+  // dictionary blob to be decoded.
+  Result<RawBlob> read_blob_raw(const BlobMetadata& blob) const;
+
+  // Awaitable versions of get_blobs and read_blob, running the blocking
+  // reads on the executor. The blob must stay valid until the read
+  // completes.
+  AsyncResult<Result<std::vector<std::unique_ptr<BlobMetadata>>>>
+  get_blobs_async(Executor& executor) const;
+  AsyncResult<Result<std::vector<uint8_t>>> read_blob_async(
+      Executor& executor, const BlobMetadata& blob) const;
+
+  // Snapshot of the I/O and decompression counters
+  ReaderStats stats() const { return stats_.snapshot(); }
+
+  // Close the reader, later reads fail. Must not race with other calls.
   Result<void> close();
 
   ICYPUFF_DISALLOW_COPY_ASSIGN_AND_MOVE(IcypuffReader);
@@ -41,28 +103,59 @@ class IcypuffReader {
   ~IcypuffReader() = default;
 
  private:
+  // A Zstd dictionary blob, loaded on the first read that needs it
+  struct ZstdDictionarySlot {
+    const BlobMetadata* blob;
+    std::once_flag once;
+    std::unique_ptr<ZstdDecompressionDictionary> dictionary;
+    ErrorCode error_code = ErrorCode::kOk;
+    std::string error_message;
+  };
+
   // Helper methods
-  Result<void> read_file_metadata();
-  Result<int> get_footer_size();
-  Result<std::vector<uint8_t>> read_input(int64_t offset, int length);
-  Result<void> check_magic(const std::vector<uint8_t>& data, int offset);
+  Result<void> read_file_metadata(bool count_cache_hit = true) const;
+  Result<void> load_file_metadata() const;
+  Result<bool> read_blob_index(int64_t data_end) const;
+  void register_zstd_dictionaries() const;
+  Result<int> get_footer_size() const;
+  Result<int> load_footer_size() const;
+  Result<std::vector<uint8_t>> read_blob_data(const BlobMetadata& blob) const;
+  Result<std::vector<uint8_t>> read_input(int64_t offset, int length) const;
+  Result<void> check_magic(const std::vector<uint8_t>& data, int offset) const;
   Result<std::vector<uint8_t>> decompress_data(
-      const std::vector<uint8_t>& data,
-      const std::optional<std::string>& codec_name);
-  Result<std::string> decompress_footer(const std::vector<uint8_t>& footer_data,
-                                        int footer_struct_offset,
-                                        int footer_payload_size);
+      const uint8_t* data, size_t length,
+      const std::optional<std::string>& codec_name,
+      const ZstdDecompressionDictionary* dictionary = nullptr) const;
+  Result<std::vector<uint8_t>> decompress_codec(
+      const uint8_t* data, size_t length, CompressionCodec codec,
+      const ZstdDecompressionDictionary* dictionary) const;
+  Result<const ZstdDecompressionDictionary*> get_zstd_dictionary(
+      const std::string& id) const;
 
   // Member variables
+  mutable internal::ReaderCounters stats_;
   std::unique_ptr<InputFile> input_file_;
-  std::unique_ptr<SeekableInputStream> input_stream_;
   int64_t file_size_;
-  std::optional<int> known_footer_size_;
-  std::unique_ptr<FileMetadata> known_file_metadata_;
+  std::atomic<bool> closed_{false};
+
+  // Footer size and parsed footer, each written once under its flag. Load
+  // errors are kept so every caller sees them.
+  mutable std::once_flag footer_size_once_;
+  mutable std::optional<int> known_footer_size_;
+  mutable ErrorCode footer_size_error_code_ = ErrorCode::kOk;
+  mutable std::string footer_size_error_message_;
+  mutable std::once_flag metadata_once_;
+  mutable std::unique_ptr<FileMetadata> known_file_metadata_;
+  mutable ErrorCode metadata_error_code_ = ErrorCode::kOk;
+  mutable std::string metadata_error_message_;
+
+  // Zstd dictionary blobs by id, registered when the footer is loaded
+  mutable std::unordered_map<uint32_t, std::unique_ptr<ZstdDictionarySlot>>
+      zstd_dictionaries_;
 
   // Error state
   ErrorCode error_code_ = ErrorCode::kOk;
   std::string error_message_;
 };
 
-}  // namespace icypuff
\ No newline at end of file
+}  // namespace icypuff
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "icypuff/input_file.h"
+#include "icypuff/macros.h"
+#include "icypuff/result.h"
+
+namespace icypuff {
+
+struct IcypuffVerifierParams {
+  // Worker threads decoding blobs, 0 uses one per core
+  int threads = 0;
+  // Adjacent blobs are read together up to this many bytes per read
+  int64_t max_read_size = 8 << 20;
+  // Blobs separated by at most this many unused bytes share a read
+  int64_t max_read_gap = 64 << 10;
+};
+
+// A problem found in the file. blob_index is the position of the blob in
+// the footer, or -1 for problems with the file structure.
+struct VerificationIssue {
+  int64_t blob_index;
+  std::string message;
+};
+
+struct VerificationReport {
+  int64_t blobs_checked = 0;
+  // Blob bytes read from the file and their decoded size
+  int64_t bytes_read = 0;
+  int64_t uncompressed_bytes = 0;
+  // Reads issued for blob data after coalescing
+  int64_t reads = 0;
+  // Sorted by blob index
+  std::vector<VerificationIssue> issues;
+
+  bool ok() const { return issues.empty(); }
+};
+
+// Validates a Puffin file end to end: the header and footer magics, footer
+// bounds, that every blob lies inside the data region without overlapping
+// another, and that every LZ4 and Zstd frame decodes completely to its
+// declared content size. Decoding checks the content and block checksums
+// the frames carry, and blobs compressed with a Zstd dictionary are decoded
+// with it.
+//
+// Blobs are read in coalesced ranges and verified in parallel. Problems
+// with the file are reported as issues, verify() only fails when the file
+// cannot be read at all.
+class IcypuffVerifier {
+ public:
+  explicit IcypuffVerifier(std::unique_ptr<InputFile> input_file,
+                           IcypuffVerifierParams params = {});
+
+  ICYPUFF_DISALLOW_COPY_ASSIGN_AND_MOVE(IcypuffVerifier);
+
+  ~IcypuffVerifier() = default;
+
+  Result<VerificationReport> verify();
+
+ private:
+  std::unique_ptr<InputFile> input_file_;
+  IcypuffVerifierParams params_;
+};
+
+}  // namespace icypuff
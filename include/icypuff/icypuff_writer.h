@@ -1,18 +1,56 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "icypuff/async.h"
 #include "icypuff/blob_metadata.h"
 #include "icypuff/compression_codec.h"
+#include "icypuff/compression_policy.h"
 #include "icypuff/output_file.h"
 #include "icypuff/position_output_stream.h"
 #include "icypuff/result.h"
+#include "icypuff/stats.h"
+#include "icypuff/zstd_dictionary.h"
 
 namespace icypuff {
 
+// Zstd tuning for single very large blobs, where parallelism across blobs
+// does not help. The output is still one frame with the content size set.
+struct ZstdLargeBlobOptions {
+  // Number of Zstd worker threads (ZSTD_c_nbWorkers), 0 disables
+  int workers = 0;
+  // Blobs smaller than this are compressed on the calling thread
+  int64_t min_blob_size = 32 * 1024 * 1024;
+  // Size of each worker job (ZSTD_c_jobSize), 0 lets Zstd choose
+  size_t job_size = 0;
+  // Enables long-distance matching within the default window size, so
+  // readers need no extra window configuration
+  bool long_distance_matching = false;
+};
+
+struct IcypuffWriterParams {
+  std::unordered_map<std::string, std::string> properties;
+  bool compress_footer = false;
+  CompressionCodec default_blob_compression = CompressionCodec::None;
+  // When set, replaces default_blob_compression with a per-blob choice
+  std::optional<AdaptiveCompressionPolicy> compression_policy;
+  ZstdLargeBlobOptions zstd_large_blobs;
+  // Writes a binary index of the footer as the last blob, see blob_index.h
+  bool write_blob_index = false;
+};
+
+// Blob compressed by IcypuffWriter::compress_blob
+struct CompressedBlob {
+  std::vector<uint8_t> data;
+  CompressionCodec codec = CompressionCodec::None;
+  // Properties the blob must be written with, e.g. its Zstd dictionary id
+  std::unordered_map<std::string, std::string> properties;
+};
+
 class IcypuffWriter {
  public:
   // Constructor
@@ -21,6 +59,16 @@ class IcypuffWriter {
                 bool compress_footer,
                 CompressionCodec default_blob_compression);
 
+  IcypuffWriter(std::unique_ptr<OutputFile> output_file,
+                IcypuffWriterParams params);
+
+  // Constructor for appending to an existing file. The file is opened with
+  // append_at(append_offset), which truncates the footer, on the first write
+  // or on close. The existing blobs are kept in the footer.
+  IcypuffWriter(std::unique_ptr<OutputFile> output_file, int64_t append_offset,
+                std::vector<std::unique_ptr<BlobMetadata>> existing_blobs,
+                IcypuffWriterParams params);
+
   virtual ~IcypuffWriter() = default;
 
   // Write a blob to the file
@@ -31,6 +79,53 @@ class IcypuffWriter {
       std::optional<CompressionCodec> compression = std::nullopt,
       const std::unordered_map<std::string, std::string>& properties = {});
 
+  // Awaitable versions of write_blob and close, running the compression
+  // and blocking writes on the executor. The data must stay valid and the
+  // writer unused until the call completes.
+  AsyncResult<Result<std::unique_ptr<BlobMetadata>>> write_blob_async(
+      Executor& executor, const uint8_t* data, size_t length, std::string type,
+      std::vector<int> fields, int64_t snapshot_id = 0,
+      int64_t sequence_number = 0,
+      std::optional<CompressionCodec> compression = std::nullopt,
+      std::unordered_map<std::string, std::string> properties = {});
+  AsyncResult<Result<void>> close_async(Executor& executor);
+
+  // Write a blob that is already compressed, e.g. bytes returned by
+  // IcypuffReader::read_blob_raw. The data must be a single frame of the
+  // codec with the content size present and is written unchanged.
+  Result<std::unique_ptr<BlobMetadata>> write_blob_precompressed(
+      const uint8_t* data, size_t length, CompressionCodec codec,
+      const std::string& type, const std::vector<int>& fields,
+      int64_t snapshot_id = 0, int64_t sequence_number = 0,
+      const std::unordered_map<std::string, std::string>& properties = {});
+
+  // Compress a blob as write_blob would, without writing it. Write the
+  // result with write_blob_precompressed, adding its properties. May run on
+  // several threads alongside writes, as long as no dictionary is added.
+  Result<CompressedBlob> compress_blob(
+      const uint8_t* data, size_t length, const std::string& type,
+      std::optional<CompressionCodec> compression = std::nullopt) const;
+
+  // Copy blobs of another Puffin file without decompressing them. The
+  // compressed bytes are transferred verbatim, adjacent blobs in a single
+  // transfer, and the copies keep their codec and properties at new offsets.
+  Result<std::vector<std::unique_ptr<BlobMetadata>>> copy_blobs(
+      const InputFile& source, const std::vector<const BlobMetadata*>& blobs);
+
+  // Train a Zstd dictionary from sample blobs of the given type and write it
+  // as a dictionary blob. Later Zstd-compressed blobs of that type are
+  // compressed with the dictionary and reference it through a property.
+  Result<std::unique_ptr<BlobMetadata>> train_zstd_dictionary(
+      const std::string& type,
+      const std::vector<std::vector<uint8_t>>& samples,
+      const std::vector<int>& fields,
+      size_t capacity = DEFAULT_ZSTD_DICTIONARY_CAPACITY);
+
+  // Write an already trained Zstd dictionary for blobs of the given type
+  Result<std::unique_ptr<BlobMetadata>> add_zstd_dictionary(
+      const std::string& type, const std::vector<uint8_t>& dictionary,
+      const std::vector<int>& fields);
+
   // Get the current file size
   Result<int64_t> file_size() const;
 
@@ -41,6 +136,9 @@ class IcypuffWriter {
   const std::vector<std::unique_ptr<BlobMetadata>>& written_blobs_metadata()
       const;
 
+  // Snapshot of the I/O and compression counters
+  WriterStats stats() const { return stats_.snapshot(); }
+
   // Close the file and write the footer
   Result<void> close();
 
@@ -48,19 +146,40 @@ class IcypuffWriter {
 
  private:
   // Helper methods
+  CompressionCodec select_codec(const uint8_t* data, size_t length,
+                                const std::string& type) const;
+  Result<std::unique_ptr<BlobMetadata>> append_blob(
+      const uint8_t* data, size_t length, CompressionCodec codec,
+      const std::string& type, const std::vector<int>& fields,
+      int64_t snapshot_id, int64_t sequence_number,
+      const std::unordered_map<std::string, std::string>& properties);
+  Result<void> open_stream_if_needed();
   Result<void> write_header_if_needed();
+  Result<void> write_blob_index();
   Result<void> write_footer();
   Result<void> write_flags();
-  Result<std::vector<uint8_t>> compress_data(const uint8_t* data, size_t length,
-                                             CompressionCodec codec);
+  Result<void> copy_range(const InputFile& source, int64_t offset,
+                          int64_t length);
+  Result<void> configure_large_blob_compression(const ZstdContext& ctx) const;
+  Result<std::vector<uint8_t>> compress_data(
+      const uint8_t* data, size_t length, CompressionCodec codec,
+      const ZstdCompressionDictionary* dictionary = nullptr) const;
 
   // Member variables
+  mutable internal::WriterCounters stats_;
   std::unique_ptr<OutputFile> output_file_;
   std::unique_ptr<PositionOutputStream> output_stream_;
+  // Where an appending writer opens the file, until it is opened
+  std::optional<int64_t> append_offset_;
   std::unordered_map<std::string, std::string> properties_;
   CompressionCodec footer_compression_;
   CompressionCodec default_blob_compression_;
+  std::optional<AdaptiveCompressionPolicy> compression_policy_;
+  ZstdLargeBlobOptions zstd_large_blobs_;
+  bool write_blob_index_;
   std::vector<std::unique_ptr<BlobMetadata>> written_blobs_metadata_;
+  std::unordered_map<std::string, std::unique_ptr<ZstdCompressionDictionary>>
+      zstd_dictionaries_;
   bool header_written_ = false;
   bool finished_ = false;
   std::optional<int64_t> footer_size_;
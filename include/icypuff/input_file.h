@@ -1,6 +1,10 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <span>
 #include <string>
 
 #include "icypuff/result.h"
@@ -8,6 +12,16 @@
 
 namespace icypuff {
 
+// One read of a batch, see InputFile::read_batch
+struct PositionalRead {
+  int64_t position;
+  uint8_t* buffer;
+  size_t length;
+};
+
+// Called with the index of a finished read in its batch and its outcome
+using ReadCompletion = std::function<void(size_t index, Result<void> result)>;
+
 class InputFile {
  public:
   virtual ~InputFile() = default;
@@ -18,6 +32,20 @@ class InputFile {
   // Opens a new SeekableInputStream for the underlying data file
   virtual Result<std::unique_ptr<SeekableInputStream>> new_stream() const = 0;
 
+  // Reads exactly length bytes starting at position without moving any
+  // stream, so it can be called from several threads at once. The default
+  // opens a stream per call, implementations override it with positional
+  // reads.
+  virtual Result<void> read_fully(int64_t position, uint8_t* buffer,
+                                  size_t length) const;
+
+  // Issues several reads together and calls on_complete once per read as
+  // it finishes, in any order, on the calling thread. Returns once every
+  // read has completed. The default runs them one by one with read_fully,
+  // implementations override it to keep many reads in flight.
+  virtual void read_batch(std::span<const PositionalRead> reads,
+                          const ReadCompletion& on_complete) const;
+
   // The fully-qualified location of the input file as a string
   virtual std::string location() const = 0;
 
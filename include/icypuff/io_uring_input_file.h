@@ -0,0 +1,90 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "icypuff/input_file.h"
+#include "icypuff/local_input_file.h"
+#include "icypuff/macros.h"
+#include "icypuff/result.h"
+
+namespace icypuff {
+
+struct IoUringInputFileParams {
+  // Reads kept in flight by one batch, the size of each submission queue
+  unsigned queue_depth = 64;
+  // Read with O_DIRECT, bypassing the page cache, through aligned bounce
+  // buffers. Ignored where the file system does not support it.
+  bool direct_io = false;
+  // Use pread even when io_uring is available
+  bool disable_io_uring = false;
+  // For tests: each ring fails its submissions after this many, as a
+  // broken kernel would, so batches fall back to pread. Negative never
+  // fails.
+  int fail_submissions_after = -1;
+};
+
+// Local file read through io_uring, so one thread can keep many small
+// positional reads in flight, e.g. sketch reads on NVMe. read_batch submits
+// up to queue_depth reads at a time and reaps their completions as they
+// arrive; read_fully is a batch of one.
+//
+// io_uring is used through its system calls directly. Where it is not
+// available (other platforms, old kernels, sandboxes that block it, or a
+// build with ICYPUFF_ENABLE_IO_URING off), the same calls fall back to
+// pread. Streams are those of LocalInputFile. Concurrent batches each use
+// their own ring, taken from a pool owned by the file.
+class IoUringInputFile : public InputFile {
+ public:
+  // Fails if the file cannot be opened. A missing io_uring is not an
+  // error, see uses_io_uring().
+  static Result<std::unique_ptr<IoUringInputFile>> Create(
+      const std::filesystem::path& path, IoUringInputFileParams params = {});
+
+  ICYPUFF_DISALLOW_COPY_ASSIGN_AND_MOVE(IoUringInputFile);
+
+  ~IoUringInputFile() override;
+
+  // InputFile implementation
+  Result<int64_t> length() const override;
+  Result<std::unique_ptr<SeekableInputStream>> new_stream() const override;
+  Result<void> read_fully(int64_t position, uint8_t* buffer,
+                          size_t length) const override;
+  void read_batch(std::span<const PositionalRead> reads,
+                  const ReadCompletion& on_complete) const override;
+  std::string location() const override;
+  bool exists() const override;
+
+  // Whether reads go through io_uring rather than pread
+  bool uses_io_uring() const { return io_uring_available_; }
+  // Whether reads bypass the page cache
+  bool uses_direct_io() const { return direct_io_; }
+
+ private:
+  class Ring;
+  struct ReadState;
+
+  IoUringInputFile(const std::filesystem::path& path,
+                   IoUringInputFileParams params);
+
+  std::unique_ptr<Ring> acquire_ring() const;
+  void release_ring(std::unique_ptr<Ring> ring) const;
+  // Returns false if the ring failed and must not be reused
+  bool read_with_ring(Ring& ring, std::vector<ReadState>& states,
+                      const ReadCompletion& on_complete) const;
+  void read_with_pread(std::vector<ReadState>& states,
+                       const ReadCompletion& on_complete) const;
+
+  LocalInputFile local_;
+  IoUringInputFileParams params_;
+  int fd_ = -1;
+  bool direct_io_ = false;
+  bool io_uring_available_ = false;
+  mutable std::mutex rings_mutex_;
+  mutable std::vector<std::unique_ptr<Ring>> idle_rings_;
+};
+
+}  // namespace icypuff
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "icypuff/macros.h"
+
+namespace icypuff {
+
+// Operations whose latency is recorded by readers and writers
+enum class LatencyOp {
+  kReadFileMetadata,    // Loading and parsing the footer
+  kReadBlobIo,          // Reading a blob's stored bytes
+  kReadBlobDecompress,  // Decompressing a blob
+  kWriteBlob,           // Compressing and writing a blob
+  kClose                // Writing the footer and closing the file
+};
+
+constexpr size_t LATENCY_OP_COUNT = 5;
+
+std::string_view GetLatencyOpName(LatencyOp op);
+
+// Point-in-time copy of a LatencyHistogram
+struct LatencySnapshot {
+  int64_t count = 0;
+  int64_t sum_nanos = 0;
+  std::vector<int64_t> bucket_counts;
+
+  // Upper bound in nanoseconds of the bucket holding the q-th quantile,
+  // q in [0, 1]. 0 when nothing was recorded.
+  int64_t percentile(double q) const;
+};
+
+// HDR-style log-linear histogram of nanosecond latencies. Values below 16ns
+// get a bucket each, and every power of two above is split into 8 linear
+// buckets, so a bucket bound is within 12.5% of any value it holds.
+// Recording is a few relaxed atomic adds and never allocates.
+class LatencyHistogram {
+ public:
+  static constexpr int kSubBucketBits = 3;
+  static constexpr int kSubBucketCount = 1 << kSubBucketBits;
+  // Values of 2^40ns (about 18 minutes) and more share the last bucket
+  static constexpr int kMaxExponent = 40;
+  static constexpr size_t kBucketCount =
+      (kMaxExponent - kSubBucketBits + 1) * kSubBucketCount;
+
+  LatencyHistogram() = default;
+
+  ICYPUFF_DISALLOW_COPY_ASSIGN_AND_MOVE(LatencyHistogram);
+
+  void record(int64_t nanos);
+  LatencySnapshot snapshot() const;
+  void reset();
+
+  static size_t BucketIndex(int64_t nanos);
+  // Largest value in nanoseconds that falls into the bucket
+  static int64_t BucketUpperBound(size_t index);
+
+ private:
+  std::array<std::atomic<int64_t>, kBucketCount> buckets_{};
+  std::atomic<int64_t> sum_nanos_{0};
+};
+
+// Process-wide histogram of an operation, shared by all readers and writers
+LatencyHistogram& GetLatencyHistogram(LatencyOp op);
+
+void ResetLatencyHistograms();
+
+// Renders all operation histograms in the Prometheus text exposition format,
+// as the histogram icypuff_operation_latency_seconds labelled by op. Bucket
+// bounds are histogram bucket boundaries, four per power of two from about
+// 1us to 17s, so no bucket is split when they are aggregated.
+std::string RenderLatencyPrometheus();
+
+namespace internal {
+
+// Records the time from construction to destruction, on every return path
+class LatencyTimer {
+ public:
+  explicit LatencyTimer(LatencyOp op);
+  ~LatencyTimer();
+
+  ICYPUFF_DISALLOW_COPY_ASSIGN_AND_MOVE(LatencyTimer);
+
+ private:
+  LatencyOp op_;
+  int64_t start_;
+};
+
+}  // namespace internal
+
+}  // namespace icypuff
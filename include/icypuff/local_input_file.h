@@ -1,22 +1,40 @@
 #pragma once
 
+#include <atomic>
 #include <filesystem>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
+#include "icypuff/file_handle_cache.h"
 #include "icypuff/input_file.h"
+#include "icypuff/macros.h"
 
 namespace icypuff {
 
 class LocalInputFile : public InputFile {
  public:
-  explicit LocalInputFile(const std::string& path);
-  explicit LocalInputFile(const std::filesystem::path& path);
+  // Descriptors come from handle_cache, FileHandleCache::Default() if null.
+  // The cache must outlive the file and its streams.
+  explicit LocalInputFile(const std::string& path,
+                          FileHandleCache* handle_cache = nullptr);
+  explicit LocalInputFile(const std::filesystem::path& path,
+                          FileHandleCache* handle_cache = nullptr);
+
+  ICYPUFF_DISALLOW_COPY_ASSIGN_AND_MOVE(LocalInputFile);
+
+  ~LocalInputFile() override = default;
 
   // InputFile implementation
   Result<int64_t> length() const override;
   Result<std::unique_ptr<SeekableInputStream>> new_stream() const override;
+  // The file leases a cached descriptor on its first read and keeps it
+  // until destroyed, so reopening a recently read file costs no open or
+  // close and every stream and read of this file sees the same inode, even
+  // if the path is replaced meanwhile
+  Result<void> read_fully(int64_t position, uint8_t* buffer,
+                          size_t length) const override;
   std::string location() const override;
   bool exists() const override;
 
@@ -24,7 +42,15 @@ class LocalInputFile : public InputFile {
   Result<std::vector<uint8_t>> read_at(int64_t offset, int64_t length) const;
 
  private:
+  // The leased descriptor, acquired on first use
+  Result<std::shared_ptr<const FileHandle>> lease() const;
+
   std::filesystem::path path_;
+  FileHandleCache* handle_cache_;
+  mutable std::mutex lease_mutex_;
+  mutable std::shared_ptr<const FileHandle> handle_;
+  // handle_'s descriptor once leased, read without the mutex
+  mutable std::atomic<int> fd_{-1};
 };
 
 }  // namespace icypuff
\ No newline at end of file
@@ -1,26 +1,101 @@
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
+#include "icypuff/macros.h"
 #include "icypuff/output_file.h"
 
 namespace icypuff {
 
+// When a closed local file is flushed to stable storage
+enum class FsyncPolicy {
+  kNone,             // Leave it to the OS
+  kFile,             // fsync the file
+  kFileAndDirectory  // fsync the file and its directory entry
+};
+
+class FsyncGroup;
+
+struct LocalOutputFileOptions {
+  // Write to a temporary file in the same directory and rename it to the
+  // path when the stream is closed, so the path never holds a torn file
+  bool atomic = false;
+  FsyncPolicy fsync = FsyncPolicy::kNone;
+  // Expected file size, preallocated without changing the file size where
+  // the filesystem supports it. Unused space is released on close.
+  int64_t preallocate_size = 0;
+  // Defers the fsync and rename of closed atomic files to the group commit
+  std::shared_ptr<FsyncGroup> fsync_group;
+};
+
+// Commits many closed atomic files at once. File fsyncs are issued in
+// parallel and each directory is synced once. No file appears at its path
+// unless every file synced. The renames are not all or nothing, though: if
+// one fails, commit() returns the error, the files renamed before it stay
+// at their paths and the rest are discarded.
+class FsyncGroup {
+ public:
+  explicit FsyncGroup(int threads = 4);
+
+  ICYPUFF_DISALLOW_COPY_ASSIGN_AND_MOVE(FsyncGroup);
+
+  // Removes the temporary files of uncommitted files
+  ~FsyncGroup();
+
+  // Sync and rename all files closed since the last commit
+  Result<void> commit();
+
+  // Number of closed files waiting for commit
+  size_t pending() const;
+
+  // A closed file waiting for its fsync and rename
+  struct PendingFile {
+    std::filesystem::path temp_path;
+    std::filesystem::path path;
+    FsyncPolicy fsync;
+    bool overwrite;
+  };
+
+  // Called by streams of atomic files when they are closed
+  void add(PendingFile file);
+
+ private:
+  int threads_;
+  mutable std::mutex mutex_;
+  std::vector<PendingFile> pending_;
+};
+
 class LocalOutputFile : public OutputFile {
  public:
   explicit LocalOutputFile(const std::string& path);
   explicit LocalOutputFile(const std::filesystem::path& path);
+  LocalOutputFile(const std::filesystem::path& path,
+                  LocalOutputFileOptions options);
 
   // OutputFile implementation
   Result<std::unique_ptr<PositionOutputStream>> create() override;
   Result<std::unique_ptr<PositionOutputStream>> create_or_overwrite() override;
+  // Atomic files stage appends in a temporary copy of the kept bytes, which
+  // replaces the path on close like other atomic writes. Other appends
+  // modify the file in place and only the fsync policy applies.
+  Result<std::unique_ptr<PositionOutputStream>> append_at(
+      int64_t position) override;
   std::string location() const override;
   Result<std::unique_ptr<InputFile>> to_input_file() const override;
 
  private:
+  bool is_durable() const;
+  Result<std::unique_ptr<PositionOutputStream>> open_durable(bool overwrite);
+  Result<std::unique_ptr<PositionOutputStream>> append_staged(
+      int64_t position);
+
   std::filesystem::path path_;
+  LocalOutputFileOptions options_;
 };
 
-}  // namespace icypuff
\ No newline at end of file
+}  // namespace icypuff
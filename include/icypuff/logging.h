@@ -0,0 +1,85 @@
+#pragma once
+
+#include <fmt/format.h>
+
+#include <string_view>
+
+// Compile-time log levels. Log statements below ICYPUFF_LOG_LEVEL are
+// removed by the preprocessor, arguments included. The library's level is
+// set with the ICYPUFF_LOG_LEVEL CMake option.
+#define ICYPUFF_LOG_LEVEL_TRACE 0
+#define ICYPUFF_LOG_LEVEL_DEBUG 1
+#define ICYPUFF_LOG_LEVEL_INFO 2
+#define ICYPUFF_LOG_LEVEL_WARN 3
+#define ICYPUFF_LOG_LEVEL_ERROR 4
+#define ICYPUFF_LOG_LEVEL_OFF 5
+
+#ifndef ICYPUFF_LOG_LEVEL
+#define ICYPUFF_LOG_LEVEL ICYPUFF_LOG_LEVEL_INFO
+#endif
+
+namespace icypuff {
+
+enum class LogLevel { kTrace, kDebug, kInfo, kWarn, kError };
+
+// Receives the library's log messages. Called on the thread that logs.
+class LogSink {
+ public:
+  virtual ~LogSink() = default;
+
+  // Checked before the message is formatted
+  virtual bool enabled(LogLevel level) const = 0;
+
+  virtual void log(LogLevel level, std::string_view message) = 0;
+};
+
+// Installs the process-wide sink, nullptr discards all messages. The sink
+// must outlive all library calls. The default sink forwards to spdlog's
+// default logger and honors its level.
+void SetLogSink(LogSink* sink);
+LogSink* GetLogSink();
+
+}  // namespace icypuff
+
+#define ICYPUFF_LOG(level, ...)                                        \
+  do {                                                                 \
+    ::icypuff::LogSink* icypuff_log_sink = ::icypuff::GetLogSink();    \
+    if (icypuff_log_sink && icypuff_log_sink->enabled(level)) {        \
+      icypuff_log_sink->log(level, ::fmt::format(__VA_ARGS__));        \
+    }                                                                  \
+  } while (0)
+
+#if ICYPUFF_LOG_LEVEL <= ICYPUFF_LOG_LEVEL_TRACE
+#define ICYPUFF_LOG_TRACE(...) \
+  ICYPUFF_LOG(::icypuff::LogLevel::kTrace, __VA_ARGS__)
+#else
+#define ICYPUFF_LOG_TRACE(...) static_cast<void>(0)
+#endif
+
+#if ICYPUFF_LOG_LEVEL <= ICYPUFF_LOG_LEVEL_DEBUG
+#define ICYPUFF_LOG_DEBUG(...) \
+  ICYPUFF_LOG(::icypuff::LogLevel::kDebug, __VA_ARGS__)
+#else
+#define ICYPUFF_LOG_DEBUG(...) static_cast<void>(0)
+#endif
+
+#if ICYPUFF_LOG_LEVEL <= ICYPUFF_LOG_LEVEL_INFO
+#define ICYPUFF_LOG_INFO(...) \
+  ICYPUFF_LOG(::icypuff::LogLevel::kInfo, __VA_ARGS__)
+#else
+#define ICYPUFF_LOG_INFO(...) static_cast<void>(0)
+#endif
+
+#if ICYPUFF_LOG_LEVEL <= ICYPUFF_LOG_LEVEL_WARN
+#define ICYPUFF_LOG_WARN(...) \
+  ICYPUFF_LOG(::icypuff::LogLevel::kWarn, __VA_ARGS__)
+#else
+#define ICYPUFF_LOG_WARN(...) static_cast<void>(0)
+#endif
+
+#if ICYPUFF_LOG_LEVEL <= ICYPUFF_LOG_LEVEL_ERROR
+#define ICYPUFF_LOG_ERROR(...) \
+  ICYPUFF_LOG(::icypuff::LogLevel::kError, __VA_ARGS__)
+#else
+#define ICYPUFF_LOG_ERROR(...) static_cast<void>(0)
+#endif
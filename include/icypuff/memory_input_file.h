@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "icypuff/input_file.h"
+
+namespace icypuff {
+
+// InputFile over bytes in memory, e.g. a Puffin file received over RPC.
+// Streams read straight from the span without copying the file.
+class MemoryInputFile : public InputFile {
+ public:
+  // The bytes must outlive the file and every stream opened from it
+  explicit MemoryInputFile(std::span<const uint8_t> data,
+                           std::string location = "memory");
+
+  // Shares ownership of the buffer, which must not be modified while read
+  explicit MemoryInputFile(std::shared_ptr<const std::vector<uint8_t>> buffer,
+                           std::string location = "memory");
+
+  // InputFile implementation
+  Result<int64_t> length() const override;
+  Result<std::unique_ptr<SeekableInputStream>> new_stream() const override;
+  Result<void> read_fully(int64_t position, uint8_t* buffer,
+                          size_t length) const override;
+  std::string location() const override;
+  bool exists() const override;
+
+  // The file contents
+  std::span<const uint8_t> data() const { return data_; }
+
+ private:
+  std::shared_ptr<const std::vector<uint8_t>> buffer_;
+  std::span<const uint8_t> data_;
+  std::string location_;
+};
+
+}  // namespace icypuff
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "icypuff/output_file.h"
+
+namespace icypuff {
+
+// OutputFile that writes into a growable buffer, e.g. to build a Puffin file
+// for an RPC or an upload without going through the filesystem
+class MemoryOutputFile : public OutputFile {
+ public:
+  explicit MemoryOutputFile(std::string location = "memory");
+
+  // Writes into the caller's buffer, which stays usable after the writer
+  // that owns this file is gone
+  explicit MemoryOutputFile(std::shared_ptr<std::vector<uint8_t>> buffer,
+                            std::string location = "memory");
+
+  // OutputFile implementation
+  Result<std::unique_ptr<PositionOutputStream>> create() override;
+  Result<std::unique_ptr<PositionOutputStream>> create_or_overwrite() override;
+  Result<std::unique_ptr<PositionOutputStream>> append_at(
+      int64_t position) override;
+  std::string location() const override;
+  // Returns a MemoryInputFile sharing the buffer without copying it. The
+  // output file must not be written while the input file is in use.
+  Result<std::unique_ptr<InputFile>> to_input_file() const override;
+
+  // The written bytes, shared with input files returned by to_input_file()
+  std::shared_ptr<const std::vector<uint8_t>> buffer() const {
+    return buffer_;
+  }
+
+ private:
+  std::shared_ptr<std::vector<uint8_t>> buffer_;
+  std::string location_;
+};
+
+}  // namespace icypuff
@@ -21,6 +21,14 @@ class OutputFile {
   virtual Result<std::unique_ptr<PositionOutputStream>>
   create_or_overwrite() = 0;
 
+  // Open the existing file for writing, truncated to position, with the
+  // returned stream positioned at its end. Used to append to a file without
+  // rewriting its contents.
+  virtual Result<std::unique_ptr<PositionOutputStream>> append_at(
+      int64_t /*position*/) {
+    return {ErrorCode::kUnimplemented, "Append is not supported"};
+  }
+
   // Return the location this output file will create
   virtual std::string location() const = 0;
 
@@ -8,6 +8,8 @@
 
 namespace icypuff {
 
+class InputFile;
+
 class PositionOutputStream {
  public:
   virtual ~PositionOutputStream() = default;
@@ -18,6 +20,15 @@ class PositionOutputStream {
   // Get the current position in the stream
   virtual Result<int64_t> position() const = 0;
 
+  // Append length bytes starting at offset of the source file without
+  // copying them through user space. Returns kUnimplemented when the stream
+  // has no such path for this source, in which case callers read and write
+  // the bytes instead.
+  virtual Result<void> transfer_from(const InputFile& /*source*/,
+                                     int64_t /*offset*/, int64_t /*length*/) {
+    return {ErrorCode::kUnimplemented, "Transfer is not supported"};
+  }
+
   // Flush any buffered data
   virtual Result<void> flush() = 0;
 
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "icypuff/blob_metadata.h"
+#include "icypuff/bulk_blob_fetch.h"
+#include "icypuff/file_metadata.h"
+#include "icypuff/icypuff_reader.h"
+#include "icypuff/input_file.h"
+#include "icypuff/macros.h"
+#include "icypuff/result.h"
+
+namespace icypuff {
+
+struct PuffinTableIndexParams {
+  // Footers read and parsed concurrently, 0 uses one thread per core
+  int threads = 0;
+};
+
+// Where a blob lives among the indexed files
+struct IndexedBlob {
+  // Position of the file in the list the index was created from
+  size_t file_index;
+  // Position of the blob in its file's footer
+  size_t blob_index;
+  const BlobMetadata* metadata;
+};
+
+// Index over all statistics files of a table, answering which blob holds a
+// given statistic without opening the files one by one. Blobs are indexed
+// by (snapshot id, field id, type), once for each of their input fields.
+//
+// The footers are loaded concurrently when the index is created. The index
+// keeps a reader per file for fetching blob data, so lookups and reads may
+// be issued from several threads at once.
+class PuffinTableIndex {
+ public:
+  // Fails if any file cannot be opened or its footer is invalid. The error
+  // names the file and stays valid until the next failed Create on the
+  // calling thread.
+  static Result<std::unique_ptr<PuffinTableIndex>> Create(
+      std::vector<std::unique_ptr<InputFile>> input_files,
+      PuffinTableIndexParams params = {});
+
+  ICYPUFF_DISALLOW_COPY_ASSIGN_AND_MOVE(PuffinTableIndex);
+
+  ~PuffinTableIndex() = default;
+
+  size_t file_count() const { return files_.size(); }
+  size_t blob_count() const { return blob_count_; }
+
+  // Blobs of a type written for a snapshot that cover a field, in file and
+  // footer order
+  std::vector<IndexedBlob> find(int64_t snapshot_id, int field_id,
+                                std::string_view type) const;
+
+  // The blob of a type covering a field with the highest sequence number.
+  // Ties go to the higher snapshot id, then to the later file and blob.
+  std::optional<IndexedBlob> find_latest(int field_id,
+                                         std::string_view type) const;
+
+  // Blob metadata of one file, in footer order
+  const std::vector<std::unique_ptr<BlobMetadata>>& blobs(
+      size_t file_index) const {
+    return files_[file_index].metadata->blobs();
+  }
+
+  // The reader of one file, shared by all callers
+  const IcypuffReader& reader(size_t file_index) const {
+    return *files_[file_index].reader;
+  }
+
+  // Read an indexed blob's data
+  Result<std::vector<uint8_t>> read_blob(const IndexedBlob& blob) const;
+
+  // Read many indexed blobs across files at once, see FetchBlobs. The
+  // callback gets each blob's position in blobs.
+  Result<BulkFetchStats> fetch_blobs(const std::vector<IndexedBlob>& blobs,
+                                     const BlobFetchCallback& callback,
+                                     BulkFetchParams params = {}) const;
+
+ private:
+  struct IndexedFile {
+    std::unique_ptr<IcypuffReader> reader;
+    // Parsed footer, owned by the reader
+    const FileMetadata* metadata = nullptr;
+  };
+
+  struct SnapshotKey {
+    int64_t snapshot_id;
+    int field_id;
+    std::string type;
+
+    bool operator==(const SnapshotKey&) const = default;
+  };
+
+  struct FieldKey {
+    int field_id;
+    std::string type;
+
+    bool operator==(const FieldKey&) const = default;
+  };
+
+  struct KeyHash {
+    size_t operator()(const SnapshotKey& key) const;
+    size_t operator()(const FieldKey& key) const;
+  };
+
+  PuffinTableIndex() = default;
+
+  void add_file(size_t file_index);
+
+  std::vector<IndexedFile> files_;
+  size_t blob_count_ = 0;
+  std::unordered_map<SnapshotKey, std::vector<IndexedBlob>, KeyHash>
+      by_snapshot_;
+  std::unordered_map<FieldKey, IndexedBlob, KeyHash> latest_;
+};
+
+}  // namespace icypuff
@@ -32,6 +32,7 @@ enum class ErrorCode {
   kUnimplemented,  // Feature not implemented
   kInternalError,  // Unexpected internal error
   kInvalidState,   // Invalid state
+  kWouldBlock,     // Operation would have to wait
 };
 
 struct ResultError {
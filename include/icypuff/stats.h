@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "icypuff/compression_codec.h"
+
+namespace icypuff {
+
+// Compression or decompression work done with one codec
+struct CodecStats {
+  int64_t calls = 0;
+  int64_t uncompressed_bytes = 0;
+  int64_t compressed_bytes = 0;
+  int64_t nanos = 0;
+
+  // Uncompressed size divided by compressed size, 0 before any call
+  double ratio() const {
+    return compressed_bytes == 0 ? 0.0
+                                 : static_cast<double>(uncompressed_bytes) /
+                                       static_cast<double>(compressed_bytes);
+  }
+};
+
+// Per-codec stats, indexed by CompressionCodec
+using CodecStatsArray = std::array<CodecStats, 3>;
+
+inline const CodecStats& GetCodecStats(const CodecStatsArray& stats,
+                                       CompressionCodec codec) {
+  return stats[static_cast<size_t>(codec)];
+}
+
+// Snapshot of an IcypuffReader's counters
+struct ReaderStats {
+  // I/O on the input file, including footer reads. Reads are positional,
+  // so each read also counts as a seek.
+  int64_t bytes_read = 0;
+  int64_t read_calls = 0;
+  int64_t seeks = 0;
+  // Footer loads, and the time spent reading and parsing them
+  int64_t footer_reads = 0;
+  int64_t footer_read_nanos = 0;
+  int64_t footer_parse_nanos = 0;
+  // Footer loads answered by a blob index instead of the JSON footer
+  int64_t footer_index_loads = 0;
+  // Footer lookups answered from the already parsed footer
+  int64_t metadata_cache_hits = 0;
+  // Zstd dictionary lookups answered from already loaded dictionaries
+  int64_t dictionary_cache_hits = 0;
+  int64_t blobs_read = 0;
+  CodecStatsArray decompression;
+};
+
+// Snapshot of an IcypuffWriter's counters
+struct WriterStats {
+  // I/O on the output stream, including header and footer
+  int64_t bytes_written = 0;
+  int64_t write_calls = 0;
+  int64_t blobs_written = 0;
+  // Blob compression only, precompressed and copied blobs are not included
+  CodecStatsArray compression;
+};
+
+namespace internal {
+
+// Monotonic clock reading for the stats and latency counters
+int64_t NowNanos();
+
+// Relaxed atomic counters behind the stats snapshots, so stats can be read
+// while the reader or writer is in use
+struct AtomicCodecStats {
+  std::atomic<int64_t> calls{0};
+  std::atomic<int64_t> uncompressed_bytes{0};
+  std::atomic<int64_t> compressed_bytes{0};
+  std::atomic<int64_t> nanos{0};
+
+  void record(int64_t uncompressed, int64_t compressed, int64_t elapsed);
+  CodecStats snapshot() const;
+};
+
+struct ReaderCounters {
+  std::atomic<int64_t> bytes_read{0};
+  std::atomic<int64_t> read_calls{0};
+  std::atomic<int64_t> seeks{0};
+  std::atomic<int64_t> footer_reads{0};
+  std::atomic<int64_t> footer_read_nanos{0};
+  std::atomic<int64_t> footer_parse_nanos{0};
+  std::atomic<int64_t> footer_index_loads{0};
+  std::atomic<int64_t> metadata_cache_hits{0};
+  std::atomic<int64_t> dictionary_cache_hits{0};
+  std::atomic<int64_t> blobs_read{0};
+  std::array<AtomicCodecStats, 3> decompression;
+
+  ReaderStats snapshot() const;
+};
+
+struct WriterCounters {
+  std::atomic<int64_t> bytes_written{0};
+  std::atomic<int64_t> write_calls{0};
+  std::atomic<int64_t> blobs_written{0};
+  std::array<AtomicCodecStats, 3> compression;
+
+  WriterStats snapshot() const;
+};
+
+}  // namespace internal
+
+}  // namespace icypuff
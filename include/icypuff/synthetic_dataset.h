@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "icypuff/compression_codec.h"
+#include "icypuff/output_file.h"
+#include "icypuff/result.h"
+
+namespace icypuff {
+
+// Largest blob count GenerateSyntheticDataset accepts
+constexpr int64_t MAX_SYNTHETIC_BLOB_COUNT = 1000000;
+
+// How uncompressed blob sizes are drawn
+enum class BlobSizeDistribution {
+  kFixed,     // Every blob is min_blob_size bytes
+  kUniform,   // Uniform between min_blob_size and max_blob_size
+  kLogNormal  // Mostly near min_blob_size with a long tail to max_blob_size
+};
+
+// Shape of a generated Puffin file. Types and codecs are drawn uniformly
+// from their lists, so repeating an entry weights it.
+struct SyntheticDatasetOptions {
+  int64_t blob_count = 1000;
+  BlobSizeDistribution size_distribution = BlobSizeDistribution::kFixed;
+  size_t min_blob_size = 64;
+  size_t max_blob_size = 64;
+  std::vector<std::string> types = {"apache-datasketches-theta-v1"};
+  std::vector<CompressionCodec> codecs = {CompressionCodec::None};
+  // Each blob has properties_per_blob properties whose values are drawn from
+  // property_cardinality distinct values
+  int properties_per_blob = 1;
+  int64_t property_cardinality = 1000;
+  // Each blob has fields_per_blob distinct input field ids drawn from 1 to
+  // field_count
+  int fields_per_blob = 1;
+  int64_t field_count = 100;
+  // Snapshot ids are drawn from snapshot_count consecutive ids
+  int64_t snapshot_count = 1;
+  bool compress_footer = false;
+  // Adds a blob index, which is not counted in blob_count
+  bool write_blob_index = false;
+  // Equal seeds and options generate identical files
+  uint32_t seed = 42;
+};
+
+struct SyntheticDatasetSummary {
+  int64_t blob_count = 0;
+  // Uncompressed blob bytes
+  int64_t data_bytes = 0;
+  int64_t footer_size = 0;
+  int64_t file_size = 0;
+};
+
+// Writes a Puffin file of the given shape, with moderately compressible blob
+// contents resembling serialized statistics. Meant for benchmarks and
+// scale tests.
+Result<SyntheticDatasetSummary> GenerateSyntheticDataset(
+    std::unique_ptr<OutputFile> output_file,
+    const SyntheticDatasetOptions& options);
+
+}  // namespace icypuff
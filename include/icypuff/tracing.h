@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#include "icypuff/macros.h"
+
+// Span hooks are compiled in by default and cost one atomic load per span
+// while no tracer is installed. Building with ICYPUFF_ENABLE_TRACING=0
+// removes them, the span macros then expand to nothing.
+#ifndef ICYPUFF_ENABLE_TRACING
+#define ICYPUFF_ENABLE_TRACING 1
+#endif
+
+namespace icypuff {
+
+// Operations reported as spans
+enum class SpanKind {
+  kFooterRead,   // Locating and reading the footer
+  kFooterParse,  // Parsing the footer JSON
+  kBlobRead,     // Reading a blob's stored bytes
+  kDecompress,   // Decompressing a blob
+  kCompress,     // Compressing a blob
+  kBlobWrite,    // Writing a blob's stored bytes
+  kClose         // Writing the footer and closing the file
+};
+
+std::string_view GetSpanName(SpanKind kind);
+
+// Receives span boundaries from readers and writers, e.g. to forward them
+// to a distributed tracing system. Called on the thread doing the work.
+class Tracer {
+ public:
+  virtual ~Tracer() = default;
+
+  // Returns a value passed back to end_span, e.g. a span id
+  virtual uint64_t begin_span(SpanKind kind) = 0;
+
+  // bytes is the amount of data the operation produced or consumed, and ok
+  // is false when it failed
+  virtual void end_span(SpanKind kind, uint64_t token, int64_t bytes,
+                        bool ok) = 0;
+};
+
+// Installs the process-wide tracer, nullptr (the default) disables tracing.
+// The tracer must outlive all readers and writers using it. Has no effect
+// in builds with ICYPUFF_ENABLE_TRACING=0.
+void SetTracer(Tracer* tracer);
+Tracer* GetTracer();
+
+// Reports one span from construction to destruction. Spans that end without
+// being marked done are reported as failed.
+class ScopedSpan {
+ public:
+  explicit ScopedSpan(SpanKind kind) : tracer_(GetTracer()), kind_(kind) {
+    if (tracer_) {
+      token_ = tracer_->begin_span(kind);
+    }
+  }
+
+  ~ScopedSpan() {
+    if (tracer_) {
+      tracer_->end_span(kind_, token_, bytes_, ok_);
+    }
+  }
+
+  ICYPUFF_DISALLOW_COPY_ASSIGN_AND_MOVE(ScopedSpan);
+
+  void set_done(int64_t bytes) {
+    bytes_ = bytes;
+    ok_ = true;
+  }
+
+ private:
+  Tracer* tracer_;
+  SpanKind kind_;
+  uint64_t token_ = 0;
+  int64_t bytes_ = 0;
+  bool ok_ = false;
+};
+
+}  // namespace icypuff
+
+#if ICYPUFF_ENABLE_TRACING
+#define ICYPUFF_TRACE_SPAN(name, kind) ::icypuff::ScopedSpan name(kind)
+#define ICYPUFF_TRACE_DONE(name, bytes) name.set_done(bytes)
+#else
+#define ICYPUFF_TRACE_SPAN(name, kind) static_cast<void>(0)
+#define ICYPUFF_TRACE_DONE(name, bytes) static_cast<void>(0)
+#endif
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "icypuff/compression_codec.h"
+#include "icypuff/icypuff_writer.h"
+#include "icypuff/macros.h"
+#include "icypuff/result.h"
+
+namespace icypuff {
+
+struct WritePipelineParams {
+  // Compression threads, 0 uses one per core
+  int threads = 0;
+  // Bytes of blobs accepted but not yet written. Blobs count their
+  // uncompressed size until compressed, then their compressed size. A blob
+  // is only accepted when it fits, except that one blob is always accepted
+  // so blobs larger than the limit are still written.
+  int64_t max_buffered_bytes = 256 << 20;
+};
+
+// One blob for the pipeline, with the arguments of IcypuffWriter::write_blob
+struct PipelineBlob {
+  std::vector<uint8_t> data;
+  std::string type;
+  std::vector<int> fields;
+  int64_t snapshot_id = 0;
+  int64_t sequence_number = 0;
+  std::optional<CompressionCodec> compression;
+  std::unordered_map<std::string, std::string> properties;
+};
+
+struct WritePipelineStats {
+  // Blobs accepted and written
+  int64_t blobs_submitted = 0;
+  int64_t blobs_written = 0;
+  // Submits that waited for buffer space, and try_submit calls refused
+  int64_t blocked_submits = 0;
+  int64_t would_block = 0;
+  // Highest number of bytes buffered at once
+  int64_t peak_buffered_bytes = 0;
+};
+
+// Front end of an IcypuffWriter for many producer threads. Submitted blobs
+// are compressed in parallel on the pipeline's threads and written in
+// submission order through write_blob_precompressed, so the file is the
+// same as with serial write_blob calls in that order.
+//
+// Memory is bounded by max_buffered_bytes: when it is reached, submit
+// blocks until written blobs free space and try_submit fails with
+// kWouldBlock. After an error the remaining blobs are dropped and submit
+// and finish return the error.
+//
+// The writer must outlive the pipeline and must not be used directly until
+// finish returns.
+class WritePipeline {
+ public:
+  static Result<std::unique_ptr<WritePipeline>> Create(
+      IcypuffWriter& writer, WritePipelineParams params = {});
+
+  ICYPUFF_DISALLOW_COPY_ASSIGN_AND_MOVE(WritePipeline);
+
+  // Finishes the pipeline if finish was not called
+  ~WritePipeline();
+
+  // Queue a blob, waiting while the buffer is full
+  Result<void> submit(PipelineBlob blob);
+
+  // Queue a blob if it fits without waiting. The blob is only moved from
+  // when accepted.
+  Result<void> try_submit(PipelineBlob&& blob);
+
+  // Waits until every accepted blob is written and stops the threads. The
+  // writer is then usable again, e.g. to close it.
+  Result<void> finish();
+
+  WritePipelineStats stats() const;
+
+ private:
+  struct Entry;
+
+  WritePipeline(IcypuffWriter& writer, WritePipelineParams params);
+
+  Result<void> accept(PipelineBlob& blob, bool wait);
+  bool fits(int64_t bytes) const;
+  void run();
+  void commit_ready(std::unique_lock<std::mutex>& lock);
+  void fail(const ResultError& error);
+
+  IcypuffWriter& writer_;
+  WritePipelineParams params_;
+  mutable std::mutex mutex_;
+  // Signalled when blobs are queued or the pipeline stops
+  std::condition_variable work_available_;
+  // Signalled when buffered bytes are freed
+  std::condition_variable space_available_;
+  // Blobs waiting for compression, in submission order
+  std::deque<std::unique_ptr<Entry>> queue_;
+  // Compressed blobs waiting for the blobs before them, by position
+  std::map<uint64_t, std::unique_ptr<Entry>> compressed_;
+  uint64_t next_position_ = 0;
+  uint64_t next_commit_ = 0;
+  int64_t buffered_bytes_ = 0;
+  // Whether a thread is writing compressed blobs
+  bool committing_ = false;
+  bool stopping_ = false;
+  std::optional<ResultError> error_;
+  WritePipelineStats stats_;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace icypuff
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <zstd.h>
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "icypuff/macros.h"
+#include "icypuff/result.h"
+
+namespace icypuff {
+
+// Blob type of a trained Zstd dictionary stored inside a Puffin file. The
+// dictionary blob itself is stored uncompressed.
+static constexpr std::string_view ZSTD_DICTIONARY_BLOB_TYPE =
+    "icypuff-zstd-dictionary-v1";
+
+// Blob property holding the Zstd dictionary id. Set on the dictionary blob
+// and on every blob that was compressed with that dictionary.
+static constexpr std::string_view ZSTD_DICTIONARY_ID_PROPERTY =
+    "icypuff.zstd-dictionary-id";
+
+// Default maximum size of a trained dictionary
+static constexpr size_t DEFAULT_ZSTD_DICTIONARY_CAPACITY = 16 * 1024;
+
+// Trains a Zstd dictionary from a sample of blobs with similar structure
+Result<std::vector<uint8_t>> TrainZstdDictionary(
+    const std::vector<std::vector<uint8_t>>& samples,
+    size_t capacity = DEFAULT_ZSTD_DICTIONARY_CAPACITY);
+
+// Returns the dictionary id embedded in a Zstd dictionary, or 0 if the
+// buffer is not a valid dictionary
+uint32_t GetZstdDictionaryId(const std::vector<uint8_t>& dictionary);
+
+// RAII wrapper for a digested ZSTD_CDict, prepared once and shared by all
+// blobs compressed with the same dictionary
+class ZstdCompressionDictionary {
+ public:
+  static Result<std::unique_ptr<ZstdCompressionDictionary>> Create(
+      const std::vector<uint8_t>& dictionary, int compression_level);
+
+  ZstdCompressionDictionary(ZSTD_CDict* dict, uint32_t id)
+      : dict_(dict), id_(id) {}
+  ~ZstdCompressionDictionary() { ZSTD_freeCDict(dict_); }
+
+  ICYPUFF_DISALLOW_COPY_ASSIGN_AND_MOVE(ZstdCompressionDictionary);
+
+  const ZSTD_CDict* get() const { return dict_; }
+  uint32_t id() const { return id_; }
+
+ private:
+  ZSTD_CDict* dict_;
+  uint32_t id_;
+};
+
+// RAII wrapper for a digested ZSTD_DDict, loaded once per reader
+class ZstdDecompressionDictionary {
+ public:
+  static Result<std::unique_ptr<ZstdDecompressionDictionary>> Create(
+      const std::vector<uint8_t>& dictionary);
+
+  ZstdDecompressionDictionary(ZSTD_DDict* dict, uint32_t id)
+      : dict_(dict), id_(id) {}
+  ~ZstdDecompressionDictionary() { ZSTD_freeDDict(dict_); }
+
+  ICYPUFF_DISALLOW_COPY_ASSIGN_AND_MOVE(ZstdDecompressionDictionary);
+
+  const ZSTD_DDict* get() const { return dict_; }
+  uint32_t id() const { return id_; }
+
+ private:
+  ZSTD_DDict* dict_;
+  uint32_t id_;
+};
+
+}  // namespace icypuff
@@ -0,0 +1,50 @@
+#include "icypuff/async.h"
+
+#include <algorithm>
+
+namespace icypuff {
+
+ThreadPoolExecutor::ThreadPoolExecutor(int threads) {
+  int count = threads > 0
+                  ? threads
+                  : static_cast<int>(std::thread::hardware_concurrency());
+  count = std::max(count, 1);
+  threads_.reserve(count);
+  for (int i = 0; i < count; i++) {
+    threads_.emplace_back([this]() { run(); });
+  }
+}
+
+ThreadPoolExecutor::~ThreadPoolExecutor() {
+  permits_.release(static_cast<std::ptrdiff_t>(threads_.size()));
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void ThreadPoolExecutor::post(std::function<void()> work) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    work_.push_back(std::move(work));
+  }
+  permits_.release();
+}
+
+void ThreadPoolExecutor::run() {
+  while (true) {
+    permits_.acquire();
+    std::function<void()> work;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      // Work is drained before the stop permits are honoured
+      if (work_.empty()) {
+        return;
+      }
+      work = std::move(work_.front());
+      work_.pop_front();
+    }
+    work();
+  }
+}
+
+}  // namespace icypuff
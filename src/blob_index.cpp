@@ -0,0 +1,337 @@
+#include "icypuff/blob_index.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "icypuff/compression_codec.h"
+#include "icypuff/format_constants.h"
+
+namespace icypuff {
+
+namespace {
+
+constexpr uint8_t MAX_CODEC_ID = static_cast<uint8_t>(CompressionCodec::Zstd);
+
+// Offsets within the trailer
+constexpr int TRAILER_OFFSET_OFFSET = 0;
+constexpr int TRAILER_BODY_LENGTH_OFFSET = 8;
+constexpr int TRAILER_CHECKSUM_OFFSET = 16;
+constexpr int TRAILER_VERSION_OFFSET = 24;
+constexpr int TRAILER_MAGIC_OFFSET = 28;
+
+void PutU32(std::vector<uint8_t>& out, uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+  }
+}
+
+void PutU64(std::vector<uint8_t>& out, uint64_t value) {
+  for (int i = 0; i < 8; i++) {
+    out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+  }
+}
+
+uint64_t GetU64(const uint8_t* data) {
+  uint64_t value = 0;
+  for (int i = 0; i < 8; i++) {
+    value |= static_cast<uint64_t>(data[i]) << (8 * i);
+  }
+  return value;
+}
+
+// FNV-1a over little-endian 64-bit words, then the remaining bytes. Not
+// cryptographic, it only tells an index trailer from blob bytes that
+// happen to look like one and catches torn writes.
+uint64_t Checksum(const uint8_t* data, size_t length) {
+  constexpr uint64_t kPrime = 0x100000001b3ULL;
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    hash = (hash ^ GetU64(data + i)) * kPrime;
+  }
+  for (; i < length; i++) {
+    hash = (hash ^ data[i]) * kPrime;
+  }
+  return hash;
+}
+
+// Bounds-checked cursor over the index body
+class Cursor {
+ public:
+  Cursor(const uint8_t* data, size_t length) : data_(data), length_(length) {}
+
+  bool u8(uint8_t& value) {
+    if (length_ - pos_ < 1) {
+      return false;
+    }
+    value = data_[pos_++];
+    return true;
+  }
+
+  bool u32(uint32_t& value) {
+    if (length_ - pos_ < 4) {
+      return false;
+    }
+    value = read_integer_little_endian(data_ + pos_, 0);
+    pos_ += 4;
+    return true;
+  }
+
+  bool i64(int64_t& value) {
+    if (length_ - pos_ < 8) {
+      return false;
+    }
+    value = static_cast<int64_t>(GetU64(data_ + pos_));
+    pos_ += 8;
+    return true;
+  }
+
+  bool bytes(std::string& value, uint32_t length) {
+    if (length_ - pos_ < length) {
+      return false;
+    }
+    value.assign(reinterpret_cast<const char*>(data_ + pos_), length);
+    pos_ += length;
+    return true;
+  }
+
+  size_t remaining() const { return length_ - pos_; }
+
+ private:
+  const uint8_t* data_;
+  size_t length_;
+  size_t pos_ = 0;
+};
+
+// Assigns each distinct string an id in first-seen order
+class StringTable {
+ public:
+  uint32_t intern(const std::string& value) {
+    auto [it, inserted] =
+        ids_.try_emplace(value, static_cast<uint32_t>(strings_.size()));
+    if (inserted) {
+      strings_.push_back(&it->first);
+    }
+    return it->second;
+  }
+
+  const std::vector<const std::string*>& strings() const { return strings_; }
+
+ private:
+  std::unordered_map<std::string, uint32_t> ids_;
+  std::vector<const std::string*> strings_;
+};
+
+void PutProperties(
+    std::vector<uint8_t>& out, StringTable& strings,
+    const std::unordered_map<std::string, std::string>& properties) {
+  PutU32(out, static_cast<uint32_t>(properties.size()));
+  for (const auto& [key, value] : properties) {
+    PutU32(out, strings.intern(key));
+    PutU32(out, strings.intern(value));
+  }
+}
+
+bool GetProperties(Cursor& cursor, const std::vector<std::string>& strings,
+                   std::unordered_map<std::string, std::string>& properties) {
+  uint32_t count = 0;
+  if (!cursor.u32(count) || count > cursor.remaining() / 8) {
+    return false;
+  }
+  properties.reserve(count);
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t key = 0;
+    uint32_t value = 0;
+    if (!cursor.u32(key) || !cursor.u32(value) || key >= strings.size() ||
+        value >= strings.size()) {
+      return false;
+    }
+    properties.emplace(strings[key], strings[value]);
+  }
+  return true;
+}
+
+}  // namespace
+
+std::vector<int> BlobIndexFields(
+    const std::vector<std::unique_ptr<BlobMetadata>>& blobs) {
+  std::vector<int> fields;
+  for (const auto& blob : blobs) {
+    fields.insert(fields.end(), blob->input_fields().begin(),
+                  blob->input_fields().end());
+  }
+  std::sort(fields.begin(), fields.end());
+  fields.erase(std::unique(fields.begin(), fields.end()), fields.end());
+  if (fields.empty()) {
+    fields.push_back(BLOB_INDEX_DEFAULT_FIELD_ID);
+  }
+  return fields;
+}
+
+Result<std::vector<uint8_t>> EncodeBlobIndex(
+    const std::vector<std::unique_ptr<BlobMetadata>>& blobs,
+    const std::unordered_map<std::string, std::string>& properties,
+    int64_t index_offset) {
+  // Blob entries are encoded first to collect the strings, then the string
+  // table is written ahead of them
+  StringTable strings;
+  std::vector<uint8_t> entries;
+  entries.reserve(blobs.size() * 48);
+  PutProperties(entries, strings, properties);
+  PutU64(entries, blobs.size());
+  for (const auto& blob : blobs) {
+    auto codec = GetCodecFromName(blob->compression_codec());
+    if (!codec.has_value()) {
+      return {ErrorCode::kUnknownCodec,
+              "Blob index cannot record an unknown compression codec"};
+    }
+    PutU64(entries, static_cast<uint64_t>(blob->offset()));
+    PutU64(entries, static_cast<uint64_t>(blob->length()));
+    PutU64(entries, static_cast<uint64_t>(blob->snapshot_id()));
+    PutU64(entries, static_cast<uint64_t>(blob->sequence_number()));
+    PutU32(entries, strings.intern(blob->type()));
+    entries.push_back(static_cast<uint8_t>(codec.value()));
+    PutU32(entries, static_cast<uint32_t>(blob->input_fields().size()));
+    for (int field : blob->input_fields()) {
+      PutU32(entries, static_cast<uint32_t>(field));
+    }
+    PutProperties(entries, strings, blob->properties());
+  }
+  std::vector<int> index_fields = BlobIndexFields(blobs);
+  PutU32(entries, static_cast<uint32_t>(index_fields.size()));
+  for (int field : index_fields) {
+    PutU32(entries, static_cast<uint32_t>(field));
+  }
+
+  std::vector<uint8_t> index;
+  PutU32(index, static_cast<uint32_t>(strings.strings().size()));
+  for (const std::string* value : strings.strings()) {
+    PutU32(index, static_cast<uint32_t>(value->size()));
+    index.insert(index.end(), value->begin(), value->end());
+  }
+  index.insert(index.end(), entries.begin(), entries.end());
+
+  uint64_t body_length = index.size();
+  uint64_t checksum = Checksum(index.data(), index.size());
+  PutU64(index, static_cast<uint64_t>(index_offset));
+  PutU64(index, body_length);
+  PutU64(index, checksum);
+  PutU32(index, BLOB_INDEX_VERSION);
+  index.insert(index.end(), BLOB_INDEX_MAGIC,
+               BLOB_INDEX_MAGIC + sizeof(BLOB_INDEX_MAGIC));
+  return index;
+}
+
+std::optional<BlobIndexLocation> ParseBlobIndexTrailer(const uint8_t* trailer,
+                                                       int64_t data_end) {
+  if (std::memcmp(trailer + TRAILER_MAGIC_OFFSET, BLOB_INDEX_MAGIC,
+                  sizeof(BLOB_INDEX_MAGIC)) != 0 ||
+      read_integer_little_endian(trailer, TRAILER_VERSION_OFFSET) !=
+          BLOB_INDEX_VERSION) {
+    return std::nullopt;
+  }
+  auto offset = static_cast<int64_t>(GetU64(trailer + TRAILER_OFFSET_OFFSET));
+  auto body_length =
+      static_cast<int64_t>(GetU64(trailer + TRAILER_BODY_LENGTH_OFFSET));
+  // The index must end exactly where the footer starts
+  if (offset < MAGIC_LENGTH || body_length < 0 ||
+      body_length > data_end - offset - BLOB_INDEX_TRAILER_LENGTH ||
+      offset + body_length + BLOB_INDEX_TRAILER_LENGTH != data_end) {
+    return std::nullopt;
+  }
+  return BlobIndexLocation{offset, body_length + BLOB_INDEX_TRAILER_LENGTH};
+}
+
+Result<std::unique_ptr<FileMetadata>> DecodeBlobIndex(
+    const std::vector<uint8_t>& data, const BlobIndexLocation& location) {
+  constexpr std::string_view kCorrupt = "Blob index is corrupt";
+  if (static_cast<int64_t>(data.size()) != location.length) {
+    return {ErrorCode::kInvalidFooterPayload, kCorrupt};
+  }
+  size_t body_length = data.size() - BLOB_INDEX_TRAILER_LENGTH;
+  if (Checksum(data.data(), body_length) !=
+      GetU64(data.data() + body_length + TRAILER_CHECKSUM_OFFSET)) {
+    return {ErrorCode::kInvalidFooterPayload,
+            "Blob index checksum does not match"};
+  }
+
+  Cursor cursor(data.data(), body_length);
+  uint32_t string_count = 0;
+  if (!cursor.u32(string_count) || string_count > cursor.remaining() / 4) {
+    return {ErrorCode::kInvalidFooterPayload, kCorrupt};
+  }
+  std::vector<std::string> strings(string_count);
+  for (auto& value : strings) {
+    uint32_t length = 0;
+    if (!cursor.u32(length) || !cursor.bytes(value, length)) {
+      return {ErrorCode::kInvalidFooterPayload, kCorrupt};
+    }
+  }
+
+  FileMetadataParams file_params;
+  int64_t blob_count = 0;
+  if (!GetProperties(cursor, strings, file_params.properties) ||
+      !cursor.i64(blob_count) || blob_count < 0 ||
+      static_cast<uint64_t>(blob_count) > cursor.remaining() / 45) {
+    return {ErrorCode::kInvalidFooterPayload, kCorrupt};
+  }
+
+  file_params.blobs.reserve(static_cast<size_t>(blob_count) + 1);
+  for (int64_t i = 0; i < blob_count; i++) {
+    BlobMetadataParams params;
+    uint32_t type_id = 0;
+    uint8_t codec_id = 0;
+    uint32_t field_count = 0;
+    if (!cursor.i64(params.offset) || !cursor.i64(params.length) ||
+        !cursor.i64(params.snapshot_id) ||
+        !cursor.i64(params.sequence_number) || !cursor.u32(type_id) ||
+        type_id >= strings.size() || !cursor.u8(codec_id) ||
+        codec_id > MAX_CODEC_ID || !cursor.u32(field_count) ||
+        field_count > cursor.remaining() / 4) {
+      return {ErrorCode::kInvalidFooterPayload, kCorrupt};
+    }
+    params.type = strings[type_id];
+    auto codec_name = GetCodecName(static_cast<CompressionCodec>(codec_id));
+    if (codec_name.has_value()) {
+      params.compression_codec = std::string(codec_name.value());
+    }
+    params.input_fields.resize(field_count);
+    for (int& field : params.input_fields) {
+      uint32_t value = 0;
+      cursor.u32(value);
+      field = static_cast<int>(value);
+    }
+    if (!GetProperties(cursor, strings, params.properties)) {
+      return {ErrorCode::kInvalidFooterPayload, kCorrupt};
+    }
+    auto blob = BlobMetadata::Create(params);
+    if (!blob.ok()) {
+      return {ErrorCode::kInvalidFooterPayload, blob.error().message};
+    }
+    file_params.blobs.push_back(std::move(blob).value());
+  }
+
+  // The index blob itself, as listed last in the JSON footer
+  BlobMetadataParams index_params;
+  uint32_t field_count = 0;
+  if (!cursor.u32(field_count) || field_count != cursor.remaining() / 4 ||
+      cursor.remaining() % 4 != 0) {
+    return {ErrorCode::kInvalidFooterPayload, kCorrupt};
+  }
+  index_params.input_fields.resize(field_count);
+  for (int& field : index_params.input_fields) {
+    uint32_t value = 0;
+    cursor.u32(value);
+    field = static_cast<int>(value);
+  }
+  index_params.type = std::string(BLOB_INDEX_BLOB_TYPE);
+  index_params.snapshot_id = BLOB_INDEX_SNAPSHOT_ID;
+  index_params.sequence_number = BLOB_INDEX_SEQUENCE_NUMBER;
+  index_params.offset = location.offset;
+  index_params.length = location.length;
+  file_params.blobs.push_back(std::make_unique<BlobMetadata>(index_params));
+
+  return FileMetadata::Create(std::move(file_params));
+}
+
+}  // namespace icypuff
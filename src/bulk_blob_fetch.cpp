@@ -0,0 +1,332 @@
+#include "icypuff/bulk_blob_fetch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+
+#include "icypuff/logging.h"
+
+namespace icypuff {
+
+namespace {
+
+constexpr auto kRelaxed = std::memory_order_relaxed;
+
+// Blobs of one file fetched with one read
+struct FetchRange {
+  const IcypuffReader* reader;
+  int64_t offset;
+  int64_t length;
+  std::vector<size_t> requests;
+  std::vector<uint8_t> buffer;
+};
+
+struct FetchTask {
+  enum class Kind { kRead, kDecode };
+  Kind kind;
+  size_t range;
+  // Position in the range's requests, for decodes
+  size_t slot;
+};
+
+// Per-worker task deques. Owners push and pop at the back, so a worker
+// decodes the range it just read before reading on; thieves take from the
+// front, which holds the owner's oldest work.
+class TaskQueues {
+ public:
+  explicit TaskQueues(size_t workers) : queues_(workers) {}
+
+  void push(size_t worker, FetchTask task) {
+    std::lock_guard<std::mutex> lock(queues_[worker].mutex);
+    queues_[worker].tasks.push_back(task);
+  }
+
+  std::optional<FetchTask> pop(size_t worker) {
+    std::lock_guard<std::mutex> lock(queues_[worker].mutex);
+    auto& tasks = queues_[worker].tasks;
+    if (tasks.empty()) {
+      return std::nullopt;
+    }
+    FetchTask task = tasks.back();
+    tasks.pop_back();
+    return task;
+  }
+
+  std::optional<FetchTask> steal(size_t worker) {
+    for (size_t i = 1; i < queues_.size(); i++) {
+      Queue& victim = queues_[(worker + i) % queues_.size()];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (!victim.tasks.empty()) {
+        FetchTask task = victim.tasks.front();
+        victim.tasks.pop_front();
+        return task;
+      }
+    }
+    return std::nullopt;
+  }
+
+  // Any queued decode, own queue first. Decodes release in-flight bytes,
+  // so they are run when the limit holds back every read.
+  std::optional<FetchTask> take_decode(size_t worker) {
+    for (size_t i = 0; i < queues_.size(); i++) {
+      Queue& queue = queues_[(worker + i) % queues_.size()];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      for (auto it = queue.tasks.rbegin(); it != queue.tasks.rend(); ++it) {
+        if (it->kind == FetchTask::Kind::kDecode) {
+          FetchTask task = *it;
+          queue.tasks.erase(std::next(it).base());
+          return task;
+        }
+      }
+    }
+    return std::nullopt;
+  }
+
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<FetchTask> tasks;
+  };
+  std::vector<Queue> queues_;
+};
+
+// Groups each file's requests into coalesced reads, ordered by offset
+std::vector<FetchRange> CoalesceRequests(
+    const std::vector<BlobFetchRequest>& requests,
+    const BulkFetchParams& params) {
+  std::vector<size_t> order(requests.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    if (requests[a].reader != requests[b].reader) {
+      return std::less<const IcypuffReader*>()(requests[a].reader,
+                                               requests[b].reader);
+    }
+    return requests[a].blob->offset() < requests[b].blob->offset();
+  });
+
+  int64_t max_read_size =
+      std::min(params.max_read_size, params.max_in_flight_bytes);
+  std::vector<FetchRange> ranges;
+  for (size_t i : order) {
+    const BlobMetadata& blob = *requests[i].blob;
+    if (!ranges.empty() && ranges.back().reader == requests[i].reader) {
+      FetchRange& range = ranges.back();
+      int64_t range_end = range.offset + range.length;
+      int64_t new_end = std::max(range_end, blob.offset() + blob.length());
+      if (blob.offset() - range_end <= params.max_read_gap &&
+          new_end - range.offset <= max_read_size) {
+        range.length = new_end - range.offset;
+        range.requests.push_back(i);
+        continue;
+      }
+    }
+    ranges.push_back(
+        {requests[i].reader, blob.offset(), blob.length(), {i}, {}});
+  }
+  return ranges;
+}
+
+}  // namespace
+
+Result<BulkFetchStats> FetchBlobs(const std::vector<BlobFetchRequest>& requests,
+                                  const BlobFetchCallback& callback,
+                                  BulkFetchParams params) {
+  for (const auto& request : requests) {
+    if (!request.reader || !request.blob) {
+      return {ErrorCode::kInvalidArgument, "Fetch request is incomplete"};
+    }
+    if (request.blob->offset() < 0 || request.blob->length() < 0) {
+      return {ErrorCode::kInvalidArgument, "Blob range is invalid"};
+    }
+  }
+  if (params.max_in_flight_bytes <= 0 || params.max_read_size <= 0) {
+    return {ErrorCode::kInvalidArgument, "Fetch limits must be positive"};
+  }
+
+  std::vector<FetchRange> ranges = CoalesceRequests(requests, params);
+  BulkFetchStats stats;
+  if (ranges.empty()) {
+    return stats;
+  }
+
+  int threads = params.threads > 0
+                    ? params.threads
+                    : static_cast<int>(std::thread::hardware_concurrency());
+  int max_threads = static_cast<int>(ranges.size());
+  threads = std::clamp(threads, 1, max_threads);
+
+  // Each file's reads go to one worker, pushed last to first so the owner
+  // reads the file front to back
+  TaskQueues queues(threads);
+  {
+    std::unordered_map<const IcypuffReader*, size_t> owners;
+    for (size_t r = ranges.size(); r-- > 0;) {
+      auto [it, inserted] =
+          owners.try_emplace(ranges[r].reader, owners.size() % threads);
+      queues.push(it->second, {FetchTask::Kind::kRead, r, 0});
+    }
+  }
+
+  // Tasks queued or running, decodes are added when their read completes
+  std::atomic<size_t> outstanding{ranges.size()};
+  std::vector<std::atomic<size_t>> undecoded(ranges.size());
+  std::atomic<int64_t> in_flight{0};
+  std::atomic<int64_t> peak_in_flight{0};
+  std::atomic<int64_t> blobs{0};
+  std::atomic<int64_t> failures{0};
+  std::atomic<int64_t> reads{0};
+  std::atomic<int64_t> bytes_read{0};
+  std::atomic<int64_t> steals{0};
+  // Bumped whenever tasks are queued, bytes are freed or a worker stops,
+  // so idle workers sleep until something changed since they last looked
+  std::mutex wake_mutex;
+  std::condition_variable wake;
+  uint64_t wake_epoch = 0;
+
+  auto notify = [&]() {
+    std::lock_guard<std::mutex> lock(wake_mutex);
+    wake_epoch++;
+    wake.notify_all();
+  };
+
+  auto try_reserve = [&](int64_t bytes) {
+    int64_t current = in_flight.load();
+    do {
+      if (current > 0 && current + bytes > params.max_in_flight_bytes) {
+        return false;
+      }
+    } while (!in_flight.compare_exchange_weak(current, current + bytes));
+    int64_t peak = peak_in_flight.load(kRelaxed);
+    while (current + bytes > peak &&
+           !peak_in_flight.compare_exchange_weak(peak, current + bytes,
+                                                 kRelaxed)) {
+    }
+    return true;
+  };
+
+  auto deliver = [&](size_t request, Result<std::vector<uint8_t>> data) {
+    if (!data.ok()) {
+      failures.fetch_add(1, kRelaxed);
+    }
+    blobs.fetch_add(1, kRelaxed);
+    callback(request, std::move(data));
+  };
+
+  auto finish_range = [&](FetchRange& range) {
+    std::vector<uint8_t>().swap(range.buffer);
+    in_flight.fetch_sub(range.length);
+    notify();
+  };
+
+  auto run_read = [&](size_t worker, const FetchTask& task) {
+    FetchRange& range = ranges[task.range];
+    range.buffer.resize(static_cast<size_t>(range.length));
+    auto read_result = range.reader->read_blob_range(
+        range.offset, range.buffer.data(), range.buffer.size(),
+        range.requests.size());
+    reads.fetch_add(1, kRelaxed);
+    if (!read_result.ok()) {
+      ICYPUFF_LOG_WARN("Failed to read {} bytes at offset {}: {}",
+                       range.length, range.offset,
+                       read_result.error().message);
+      for (size_t request : range.requests) {
+        deliver(request, {read_result.error().code,
+                          read_result.error().message});
+      }
+      finish_range(range);
+      outstanding.fetch_sub(1);
+      return;
+    }
+    bytes_read.fetch_add(range.length, kRelaxed);
+
+    undecoded[task.range].store(range.requests.size());
+    outstanding.fetch_add(range.requests.size());
+    for (size_t slot = range.requests.size(); slot-- > 0;) {
+      queues.push(worker, {FetchTask::Kind::kDecode, task.range, slot});
+    }
+    outstanding.fetch_sub(1);
+    notify();
+  };
+
+  auto run_decode = [&](const FetchTask& task) {
+    FetchRange& range = ranges[task.range];
+    size_t request = range.requests[task.slot];
+    const BlobMetadata& blob = *requests[request].blob;
+    const uint8_t* data = range.buffer.data() + (blob.offset() - range.offset);
+    size_t length = static_cast<size_t>(blob.length());
+    if (params.raw) {
+      deliver(request, std::vector<uint8_t>(data, data + length));
+    } else {
+      deliver(request, range.reader->decode_blob(blob, data, length));
+    }
+    if (undecoded[task.range].fetch_sub(1) == 1) {
+      finish_range(range);
+    }
+    outstanding.fetch_sub(1);
+  };
+
+  auto worker = [&](size_t id) {
+    while (outstanding.load() > 0) {
+      uint64_t seen_epoch;
+      {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        seen_epoch = wake_epoch;
+      }
+      std::optional<FetchTask> task = queues.pop(id);
+      if (!task) {
+        task = queues.steal(id);
+        if (task) {
+          steals.fetch_add(1, kRelaxed);
+        }
+      }
+      if (task && task->kind == FetchTask::Kind::kRead &&
+          !try_reserve(ranges[task->range].length)) {
+        // Over the limit, decode instead of reading until bytes are freed
+        queues.push(id, *task);
+        task = queues.take_decode(id);
+      }
+      if (!task) {
+        std::unique_lock<std::mutex> lock(wake_mutex);
+        wake.wait(lock, [&]() {
+          return wake_epoch != seen_epoch || outstanding.load() == 0;
+        });
+        continue;
+      }
+      if (task->kind == FetchTask::Kind::kRead) {
+        run_read(id, *task);
+      } else {
+        run_decode(*task);
+      }
+    }
+    notify();
+  };
+
+  std::vector<std::thread> workers;
+  for (int t = 1; t < threads; t++) {
+    workers.emplace_back(worker, static_cast<size_t>(t));
+  }
+  worker(0);
+  for (auto& thread : workers) {
+    thread.join();
+  }
+
+  stats.blobs = blobs.load();
+  stats.failures = failures.load();
+  stats.reads = reads.load();
+  stats.bytes_read = bytes_read.load();
+  stats.steals = steals.load();
+  stats.peak_in_flight_bytes = peak_in_flight.load();
+  ICYPUFF_LOG_DEBUG("Fetched {} blobs with {} reads on {} threads",
+                    stats.blobs, stats.reads, threads);
+  return stats;
+}
+
+}  // namespace icypuff
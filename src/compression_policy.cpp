@@ -0,0 +1,111 @@
+#include "icypuff/compression_policy.h"
+
+#include <lz4.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+namespace icypuff {
+
+namespace {
+
+// Number of chunks a large blob's sample is drawn from
+constexpr size_t kSampleChunks = 4;
+
+// Approximate per-frame cost of headers and checksums, which dominates the
+// gain for very small blobs
+constexpr double kFrameOverhead = 16.0;
+
+double EntropyGain(const uint8_t* data, size_t length) {
+  std::array<size_t, 256> counts{};
+  for (size_t i = 0; i < length; i++) {
+    counts[data[i]]++;
+  }
+
+  double bits = 0.0;
+  for (size_t count : counts) {
+    if (count > 0) {
+      double p = static_cast<double>(count) / length;
+      bits -= p * std::log2(p);
+    }
+  }
+  return 1.0 - bits / 8.0;
+}
+
+double Lz4Gain(const uint8_t* data, size_t length) {
+  // LZ4 takes int sizes, larger samples are estimated from their start
+  length = std::min<size_t>(length, LZ4_MAX_INPUT_SIZE);
+  std::vector<char> compressed(LZ4_compressBound(static_cast<int>(length)));
+  int size = LZ4_compress_default(reinterpret_cast<const char*>(data),
+                                  compressed.data(), static_cast<int>(length),
+                                  static_cast<int>(compressed.size()));
+  if (size <= 0) {
+    return 0.0;
+  }
+  return 1.0 - static_cast<double>(size) / length;
+}
+
+// Accounts for the fixed frame overhead over the whole blob
+double WithFrameOverhead(double gain, size_t length) {
+  return gain - kFrameOverhead / static_cast<double>(length);
+}
+
+}  // namespace
+
+CompressibilityEstimate EstimateCompressibility(const uint8_t* data,
+                                                size_t length,
+                                                size_t sample_size) {
+  if (length == 0) {
+    return {0.0, 0.0};
+  }
+
+  // Small blobs are estimated in full, large ones from spread out chunks
+  std::vector<uint8_t> sample;
+  const uint8_t* sample_data = data;
+  size_t sample_length = length;
+  if (sample_size > 0 && length > sample_size) {
+    size_t chunk = std::max<size_t>(sample_size / kSampleChunks, 1);
+    size_t stride = length / kSampleChunks;
+    sample.reserve(chunk * kSampleChunks);
+    for (size_t i = 0; i < kSampleChunks; i++) {
+      const uint8_t* start = data + i * stride;
+      sample.insert(sample.end(), start, start + std::min(chunk, stride));
+    }
+    sample_data = sample.data();
+    sample_length = sample.size();
+  }
+
+  return {WithFrameOverhead(Lz4Gain(sample_data, sample_length), length),
+          WithFrameOverhead(EntropyGain(sample_data, sample_length), length)};
+}
+
+CompressionCodec SelectCompressionCodec(const AdaptiveCompressionPolicy& policy,
+                                        const uint8_t* data, size_t length) {
+  if (policy.preferred == CompressionCodec::None) {
+    return CompressionCodec::None;
+  }
+
+  auto estimate = EstimateCompressibility(data, length, policy.sample_size);
+
+  // Zstd gets at least the LZ4 match savings and the entropy coding savings
+  double expected_gain =
+      policy.preferred == CompressionCodec::Zstd
+          ? std::max(estimate.lz4_gain, estimate.entropy_gain)
+          : estimate.lz4_gain;
+  if (expected_gain < policy.min_gain) {
+    return CompressionCodec::None;
+  }
+
+  // LZ4 is only a fallback when it captures the gain by itself
+  if (policy.preferred == CompressionCodec::Zstd &&
+      expected_gain < policy.min_zstd_gain &&
+      estimate.lz4_gain >= policy.min_gain) {
+    return CompressionCodec::Lz4;
+  }
+
+  return policy.preferred;
+}
+
+}  // namespace icypuff
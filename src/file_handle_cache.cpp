@@ -0,0 +1,227 @@
+#include "icypuff/file_handle_cache.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <utility>
+
+#include "icypuff/logging.h"
+
+namespace icypuff {
+
+struct FileHandle::Entry {
+  std::string key;
+  int fd = -1;
+  uint64_t device = 0;
+  uint64_t inode = 0;
+  // Handles leasing the descriptor
+  size_t leases = 0;
+  // Whether the cache still maps key to this entry
+  bool cached = true;
+  // Position in the idle list, valid while idle
+  bool idle = false;
+  std::list<FileHandle::Entry*>::iterator idle_position;
+};
+
+namespace {
+
+void CloseFd(int fd) {
+#if !defined(_WIN32)
+  ::close(fd);
+#endif
+}
+
+}  // namespace
+
+FileHandle::FileHandle(FileHandleCache* cache, std::shared_ptr<Entry> entry)
+    : cache_(cache), entry_(std::move(entry)) {}
+
+FileHandle::FileHandle(FileHandle&& other) noexcept
+    : cache_(std::exchange(other.cache_, nullptr)),
+      entry_(std::move(other.entry_)) {}
+
+FileHandle& FileHandle::operator=(FileHandle&& other) noexcept {
+  if (this != &other) {
+    release();
+    cache_ = std::exchange(other.cache_, nullptr);
+    entry_ = std::move(other.entry_);
+  }
+  return *this;
+}
+
+FileHandle::~FileHandle() { release(); }
+
+int FileHandle::fd() const { return entry_ ? entry_->fd : -1; }
+
+void FileHandle::release() {
+  if (cache_ && entry_) {
+    cache_->release(entry_);
+  }
+  cache_ = nullptr;
+  entry_.reset();
+}
+
+Result<std::unique_ptr<FileHandleCache>> FileHandleCache::Create(
+    FileHandleCacheParams params) {
+  if (params.max_open_handles == 0) {
+    return {ErrorCode::kInvalidArgument,
+            "File handle cache needs at least one handle"};
+  }
+  return std::unique_ptr<FileHandleCache>(new FileHandleCache(params));
+}
+
+FileHandleCache& FileHandleCache::Default() {
+  static FileHandleCache* cache = new FileHandleCache(FileHandleCacheParams{});
+  return *cache;
+}
+
+FileHandleCache::FileHandleCache(FileHandleCacheParams params)
+    : params_(params) {}
+
+FileHandleCache::~FileHandleCache() {
+  for (auto& [key, entry] : entries_) {
+    CloseFd(entry->fd);
+  }
+}
+
+Result<FileHandle> FileHandleCache::acquire(const std::filesystem::path& path) {
+#if defined(_WIN32)
+  return {ErrorCode::kUnimplemented, "File handles are not supported"};
+#else
+  std::string key = path.string();
+  struct stat path_stat;
+  bool path_exists = true;
+  if (params_.revalidate) {
+    path_exists = ::stat(key.c_str(), &path_stat) == 0;
+  }
+
+  auto lease = [this](const std::shared_ptr<Entry>& entry) {
+    if (entry->idle) {
+      idle_.erase(entry->idle_position);
+      entry->idle = false;
+    }
+    entry->leases++;
+    return FileHandle(this, entry);
+  };
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      const Entry& entry = *it->second;
+      if (!params_.revalidate ||
+          (path_exists &&
+           entry.device == static_cast<uint64_t>(path_stat.st_dev) &&
+           entry.inode == static_cast<uint64_t>(path_stat.st_ino))) {
+        stats_.hits++;
+        return lease(it->second);
+      }
+      ICYPUFF_LOG_DEBUG("Dropping file handle of replaced file {}", key);
+      detach(it);
+    }
+  }
+
+  // Opened without the lock so slow opens do not block cached files
+  int fd = ::open(key.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return {ErrorCode::kInvalidArgument, "Failed to open file"};
+  }
+  struct stat fd_stat;
+  if (::fstat(fd, &fd_stat) != 0) {
+    ::close(fd);
+    return {ErrorCode::kInvalidArgument, "Failed to open file"};
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.misses++;
+  auto it = entries_.find(key);
+  if (it != entries_.end() &&
+      it->second->device == static_cast<uint64_t>(fd_stat.st_dev) &&
+      it->second->inode == static_cast<uint64_t>(fd_stat.st_ino)) {
+    // Another thread opened the same file first
+    ::close(fd);
+    return lease(it->second);
+  }
+  if (it != entries_.end()) {
+    detach(it);
+  }
+
+  auto entry = std::make_shared<Entry>();
+  entry->key = key;
+  entry->fd = fd;
+  entry->device = static_cast<uint64_t>(fd_stat.st_dev);
+  entry->inode = static_cast<uint64_t>(fd_stat.st_ino);
+  entries_.emplace(key, entry);
+  stats_.open_handles++;
+  evict_idle();
+  return lease(entry);
+#endif
+}
+
+void FileHandleCache::invalidate(const std::filesystem::path& path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(path.string());
+  if (it != entries_.end()) {
+    detach(it);
+  }
+}
+
+void FileHandleCache::set_max_open_handles(size_t max_open_handles) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  params_.max_open_handles = std::max<size_t>(max_open_handles, 1);
+  evict_idle();
+}
+
+FileHandleCacheStats FileHandleCache::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void FileHandleCache::release(const std::shared_ptr<Entry>& entry) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (--entry->leases > 0) {
+    return;
+  }
+  if (!entry->cached) {
+    CloseFd(entry->fd);
+    stats_.open_handles--;
+    return;
+  }
+  idle_.push_front(entry.get());
+  entry->idle = true;
+  entry->idle_position = idle_.begin();
+  evict_idle();
+}
+
+void FileHandleCache::evict_idle() {
+  while (stats_.open_handles > static_cast<int64_t>(params_.max_open_handles) &&
+         !idle_.empty()) {
+    Entry* entry = idle_.back();
+    idle_.pop_back();
+    CloseFd(entry->fd);
+    stats_.open_handles--;
+    stats_.evictions++;
+    // Erasing drops the last reference to the entry and its key
+    std::string key = entry->key;
+    entries_.erase(key);
+  }
+}
+
+void FileHandleCache::detach(
+    std::unordered_map<std::string, std::shared_ptr<Entry>>::iterator it) {
+  std::shared_ptr<Entry> entry = it->second;
+  entries_.erase(it);
+  entry->cached = false;
+  if (entry->idle) {
+    idle_.erase(entry->idle_position);
+    entry->idle = false;
+    CloseFd(entry->fd);
+    stats_.open_handles--;
+  }
+}
+
+}  // namespace icypuff
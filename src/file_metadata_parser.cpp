@@ -1,5 +1,6 @@
 #include "icypuff/file_metadata_parser.h"
 
+#include <charconv>
 #include <nlohmann/json.hpp>
 
 namespace icypuff {
@@ -88,48 +89,342 @@ Result<std::unique_ptr<BlobMetadata>> ParseBlobMetadata(
   return BlobMetadata::Create(params);
 }
 
-nlohmann::ordered_json SerializeBlobMetadata(const BlobMetadata& metadata) {
-  nlohmann::ordered_json json;
+// Streaming serializer producing the same bytes as nlohmann's dump() of the
+// equivalent ordered_json document, without building the DOM
+class FooterJsonSerializer {
+ public:
+  FooterJsonSerializer(std::string& out, bool pretty,
+                       PositionOutputStream* stream = nullptr)
+      : out_(out), pretty_(pretty), stream_(stream) {}
 
-  // Maintain field order to match test expectations
-  json[FileMetadataParser::kType] = metadata.type();
-  json[FileMetadataParser::kFields] = metadata.input_fields();
-  json[FileMetadataParser::kSnapshotId] = metadata.snapshot_id();
-  json[FileMetadataParser::kSequenceNumber] = metadata.sequence_number();
-  json[FileMetadataParser::kOffset] = metadata.offset();
-  json[FileMetadataParser::kLength] = metadata.length();
+  Result<void> Serialize(
+      const std::vector<std::unique_ptr<BlobMetadata>>& blobs,
+      const std::unordered_map<std::string, std::string>& properties) {
+    out_ += '{';
+    indent_++;
+    Key(FileMetadataParser::kBlobs);
+    if (blobs.empty()) {
+      out_ += "[]";
+    } else {
+      out_ += '[';
+      indent_++;
+      for (size_t i = 0; i < blobs.size(); i++) {
+        if (i > 0) {
+          out_ += ',';
+        }
+        Newline();
+        auto result = SerializeBlob(*blobs[i]);
+        if (!result.ok()) {
+          return result;
+        }
+        auto flushed = FlushIfNeeded();
+        if (!flushed.ok()) {
+          return flushed;
+        }
+      }
+      indent_--;
+      Newline();
+      out_ += ']';
+    }
+
+    if (!properties.empty()) {
+      out_ += ',';
+      Key(FileMetadataParser::kProperties);
+      auto result = SerializeProperties(properties);
+      if (!result.ok()) {
+        return result;
+      }
+    }
+    indent_--;
+    Newline();
+    out_ += '}';
+    return Flush();
+  }
+
+  int64_t bytes_written() const { return bytes_written_; }
+
+ private:
+  // Buffered bytes are handed to the stream once they exceed this size
+  static constexpr size_t kFlushThreshold = 64 * 1024;
+
+  Result<void> SerializeBlob(const BlobMetadata& metadata) {
+    out_ += '{';
+    indent_++;
+    Key(FileMetadataParser::kType);
+    auto result = String(metadata.type());
+    if (!result.ok()) {
+      return result;
+    }
+
+    out_ += ',';
+    Key(FileMetadataParser::kFields);
+    const auto& fields = metadata.input_fields();
+    if (fields.empty()) {
+      out_ += "[]";
+    } else {
+      out_ += '[';
+      indent_++;
+      for (size_t i = 0; i < fields.size(); i++) {
+        if (i > 0) {
+          out_ += ',';
+        }
+        Newline();
+        Integer(fields[i]);
+      }
+      indent_--;
+      Newline();
+      out_ += ']';
+    }
+
+    out_ += ',';
+    Key(FileMetadataParser::kSnapshotId);
+    Integer(metadata.snapshot_id());
+    out_ += ',';
+    Key(FileMetadataParser::kSequenceNumber);
+    Integer(metadata.sequence_number());
+    out_ += ',';
+    Key(FileMetadataParser::kOffset);
+    Integer(metadata.offset());
+    out_ += ',';
+    Key(FileMetadataParser::kLength);
+    Integer(metadata.length());
+
+    if (metadata.compression_codec()) {
+      out_ += ',';
+      Key(FileMetadataParser::kCompressionCodec);
+      result = String(*metadata.compression_codec());
+      if (!result.ok()) {
+        return result;
+      }
+    }
 
-  if (metadata.compression_codec()) {
-    json[FileMetadataParser::kCompressionCodec] = *metadata.compression_codec();
+    if (!metadata.properties().empty()) {
+      out_ += ',';
+      Key(FileMetadataParser::kProperties);
+      result = SerializeProperties(metadata.properties());
+      if (!result.ok()) {
+        return result;
+      }
+    }
+    indent_--;
+    Newline();
+    out_ += '}';
+    return Result<void>();
   }
 
-  if (!metadata.properties().empty()) {
-    json[FileMetadataParser::kProperties] = metadata.properties();
+  // Properties keep the map's iteration order, as the DOM conversion did
+  Result<void> SerializeProperties(
+      const std::unordered_map<std::string, std::string>& properties) {
+    out_ += '{';
+    indent_++;
+    bool first = true;
+    for (const auto& [key, value] : properties) {
+      if (!first) {
+        out_ += ',';
+      }
+      first = false;
+      Newline();
+      auto result = String(key);
+      if (!result.ok()) {
+        return result;
+      }
+      out_ += pretty_ ? ": " : ":";
+      result = String(value);
+      if (!result.ok()) {
+        return result;
+      }
+    }
+    indent_--;
+    Newline();
+    out_ += '}';
+    return Result<void>();
   }
 
-  return json;
-}
+  // Field names are plain ASCII and never need escaping
+  void Key(const char* name) {
+    Newline();
+    out_ += '"';
+    out_ += name;
+    out_ += pretty_ ? "\": " : "\":";
+  }
+
+  void Newline() {
+    if (pretty_) {
+      out_ += '\n';
+      out_.append(static_cast<size_t>(indent_) * 2, ' ');
+    }
+  }
+
+  void Integer(int64_t value) {
+    char buffer[24];
+    auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out_.append(buffer, end);
+  }
+
+  // Escapes like nlohmann with ensure_ascii disabled: quote, backslash and
+  // control characters only. Invalid UTF-8 is rejected instead of aborting.
+  Result<void> String(const std::string& value) {
+    static constexpr char kHex[] = "0123456789abcdef";
+    out_ += '"';
+    // Runs of bytes that need no escaping are appended at once
+    size_t run_start = 0;
+    size_t i = 0;
+    while (i < value.size()) {
+      auto byte = static_cast<uint8_t>(value[i]);
+      if (byte >= 0x80) {
+        size_t length = Utf8SequenceLength(value, i);
+        if (length == 0) {
+          return {ErrorCode::kInvalidArgument,
+                  "Invalid UTF-8 in footer metadata string"};
+        }
+        i += length;
+        continue;
+      }
+      if (byte >= 0x20 && byte != '"' && byte != '\\') {
+        i++;
+        continue;
+      }
+
+      out_.append(value, run_start, i - run_start);
+      switch (byte) {
+        case '\b':
+          out_ += "\\b";
+          break;
+        case '\t':
+          out_ += "\\t";
+          break;
+        case '\n':
+          out_ += "\\n";
+          break;
+        case '\f':
+          out_ += "\\f";
+          break;
+        case '\r':
+          out_ += "\\r";
+          break;
+        case '"':
+          out_ += "\\\"";
+          break;
+        case '\\':
+          out_ += "\\\\";
+          break;
+        default:
+          out_ += "\\u00";
+          out_ += kHex[byte >> 4];
+          out_ += kHex[byte & 0xF];
+          break;
+      }
+      i++;
+      run_start = i;
+    }
+    out_.append(value, run_start, value.size() - run_start);
+    out_ += '"';
+    return Result<void>();
+  }
+
+  // Returns the length of the well-formed UTF-8 sequence at pos, or 0
+  static size_t Utf8SequenceLength(const std::string& value, size_t pos) {
+    auto at = [&value](size_t index) {
+      return static_cast<uint8_t>(value[index]);
+    };
+    uint8_t lead = at(pos);
+    size_t length = 0;
+    uint8_t min_second = 0x80;
+    uint8_t max_second = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+      length = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+      length = 3;
+      if (lead == 0xE0) {
+        min_second = 0xA0;  // Overlong encodings
+      } else if (lead == 0xED) {
+        max_second = 0x9F;  // Surrogates
+      }
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+      length = 4;
+      if (lead == 0xF0) {
+        min_second = 0x90;  // Overlong encodings
+      } else if (lead == 0xF4) {
+        max_second = 0x8F;  // Above U+10FFFF
+      }
+    } else {
+      return 0;
+    }
+
+    if (pos + length > value.size()) {
+      return 0;
+    }
+    if (at(pos + 1) < min_second || at(pos + 1) > max_second) {
+      return 0;
+    }
+    for (size_t i = 2; i < length; i++) {
+      if (at(pos + i) < 0x80 || at(pos + i) > 0xBF) {
+        return 0;
+      }
+    }
+    return length;
+  }
+
+  Result<void> FlushIfNeeded() {
+    if (stream_ && out_.size() >= kFlushThreshold) {
+      return Flush();
+    }
+    return Result<void>();
+  }
+
+  Result<void> Flush() {
+    if (!stream_ || out_.empty()) {
+      return Result<void>();
+    }
+    auto result = stream_->write(reinterpret_cast<const uint8_t*>(out_.data()),
+                                 out_.size());
+    if (!result.ok()) {
+      return result;
+    }
+    bytes_written_ += static_cast<int64_t>(out_.size());
+    out_.clear();
+    return Result<void>();
+  }
+
+  std::string& out_;
+  bool pretty_;
+  PositionOutputStream* stream_;
+  int indent_ = 0;
+  int64_t bytes_written_ = 0;
+};
 
 }  // namespace
 
 Result<std::string> FileMetadataParser::ToJson(const FileMetadata& metadata,
                                                bool pretty) {
-  nlohmann::ordered_json json;
-
-  // Serialize blobs
-  json[kBlobs] = nlohmann::ordered_json::array();
-  for (const auto& blob : metadata.blobs()) {
-    auto blob_json = SerializeBlobMetadata(*blob);
-    json[kBlobs].push_back(nlohmann::ordered_json(blob_json));
+  std::string json;
+  auto result =
+      AppendJson(metadata.blobs(), metadata.properties(), json, pretty);
+  if (!result.ok()) {
+    return {result.error().code, result.error().message};
   }
+  return json;
+}
 
-  // Serialize properties if not empty
-  if (!metadata.properties().empty()) {
-    json[kProperties] = metadata.properties();
-  }
+Result<void> FileMetadataParser::AppendJson(
+    const std::vector<std::unique_ptr<BlobMetadata>>& blobs,
+    const std::unordered_map<std::string, std::string>& properties,
+    std::string& out, bool pretty) {
+  FooterJsonSerializer serializer(out, pretty);
+  return serializer.Serialize(blobs, properties);
+}
 
-  // Return formatted string with specific indentation
-  return pretty ? json.dump(2) : json.dump();
+Result<int64_t> FileMetadataParser::WriteJson(
+    const std::vector<std::unique_ptr<BlobMetadata>>& blobs,
+    const std::unordered_map<std::string, std::string>& properties,
+    PositionOutputStream& stream, bool pretty) {
+  std::string buffer;
+  FooterJsonSerializer serializer(buffer, pretty, &stream);
+  auto result = serializer.Serialize(blobs, properties);
+  if (!result.ok()) {
+    return {result.error().code, result.error().message};
+  }
+  return serializer.bytes_written();
 }
 
 Result<std::unique_ptr<FileMetadata>> FileMetadataParser::FromJson(
@@ -4,7 +4,9 @@
 #include <string>
 #include <unordered_map>
 
+#include "icypuff/blob_index.h"
 #include "icypuff/compression_codec.h"
+#include "icypuff/format_constants.h"
 #include "icypuff/result.h"
 
 namespace icypuff {
@@ -16,30 +18,48 @@ IcypuffWriteBuilder::IcypuffWriteBuilder(
 
 IcypuffWriteBuilder& IcypuffWriteBuilder::set(const std::string& property,
                                               const std::string& value) {
-  properties_[property] = value;
+  params_.properties[property] = value;
   return *this;
 }
 
 IcypuffWriteBuilder& IcypuffWriteBuilder::set_all(
     const std::unordered_map<std::string, std::string>& props) {
-  properties_.insert(props.begin(), props.end());
+  params_.properties.insert(props.begin(), props.end());
   return *this;
 }
 
 IcypuffWriteBuilder& IcypuffWriteBuilder::created_by(
     const std::string& application_identifier) {
-  properties_["created-by"] = application_identifier;
+  params_.properties["created-by"] = application_identifier;
   return *this;
 }
 
 IcypuffWriteBuilder& IcypuffWriteBuilder::compress_footer() {
-  compress_footer_ = true;
+  params_.compress_footer = true;
   return *this;
 }
 
 IcypuffWriteBuilder& IcypuffWriteBuilder::compress_blobs(
     CompressionCodec compression) {
-  default_blob_compression_ = compression;
+  params_.default_blob_compression = compression;
+  params_.compression_policy.reset();
+  return *this;
+}
+
+IcypuffWriteBuilder& IcypuffWriteBuilder::compress_blobs_adaptive(
+    const AdaptiveCompressionPolicy& policy) {
+  params_.compression_policy = policy;
+  return *this;
+}
+
+IcypuffWriteBuilder& IcypuffWriteBuilder::zstd_large_blobs(
+    const ZstdLargeBlobOptions& options) {
+  params_.zstd_large_blobs = options;
+  return *this;
+}
+
+IcypuffWriteBuilder& IcypuffWriteBuilder::write_blob_index() {
+  params_.write_blob_index = true;
   return *this;
 }
 
@@ -48,9 +68,188 @@ Result<std::unique_ptr<IcypuffWriter>> IcypuffWriteBuilder::build() {
     return {ErrorCode::kInvalidArgument, "Output file is null"};
   }
 
-  return std::make_unique<IcypuffWriter>(
-      std::move(output_file_), std::move(properties_), compress_footer_,
-      default_blob_compression_);
+  return std::make_unique<IcypuffWriter>(std::move(output_file_),
+                                         std::move(params_));
+}
+
+// IcypuffAppendBuilder implementation
+IcypuffAppendBuilder::IcypuffAppendBuilder(
+    std::unique_ptr<InputFile> input_file,
+    std::unique_ptr<OutputFile> output_file)
+    : input_file_(std::move(input_file)),
+      output_file_(std::move(output_file)) {}
+
+IcypuffAppendBuilder& IcypuffAppendBuilder::set(const std::string& property,
+                                                const std::string& value) {
+  property_updates_.emplace_back(property, value);
+  return *this;
+}
+
+IcypuffAppendBuilder& IcypuffAppendBuilder::set_all(
+    const std::unordered_map<std::string, std::string>& props) {
+  for (const auto& [property, value] : props) {
+    property_updates_.emplace_back(property, value);
+  }
+  return *this;
+}
+
+IcypuffAppendBuilder& IcypuffAppendBuilder::remove(
+    const std::string& property) {
+  property_updates_.emplace_back(property, std::nullopt);
+  return *this;
+}
+
+IcypuffAppendBuilder& IcypuffAppendBuilder::compress_footer() {
+  params_.compress_footer = true;
+  return *this;
+}
+
+IcypuffAppendBuilder& IcypuffAppendBuilder::compress_blobs(
+    CompressionCodec compression) {
+  params_.default_blob_compression = compression;
+  params_.compression_policy.reset();
+  return *this;
+}
+
+IcypuffAppendBuilder& IcypuffAppendBuilder::compress_blobs_adaptive(
+    const AdaptiveCompressionPolicy& policy) {
+  params_.compression_policy = policy;
+  return *this;
+}
+
+IcypuffAppendBuilder& IcypuffAppendBuilder::write_blob_index() {
+  params_.write_blob_index = true;
+  return *this;
+}
+
+Result<std::unique_ptr<IcypuffWriter>> IcypuffAppendBuilder::build() {
+  if (!input_file_) {
+    return {ErrorCode::kInvalidArgument, "Input file is null"};
+  }
+  if (!output_file_) {
+    return {ErrorCode::kInvalidArgument, "Output file is null"};
+  }
+
+  auto length_result = input_file_->length();
+  if (!length_result.ok()) {
+    return {length_result.error().code, length_result.error().message};
+  }
+  int64_t file_size = length_result.value();
+
+  // Reuse the parsed footer of the existing file
+  IcypuffReader reader(std::move(input_file_), file_size);
+  auto blobs_result = reader.get_blobs();
+  if (!blobs_result.ok()) {
+    return {blobs_result.error().code, blobs_result.error().message};
+  }
+  auto footer_size_result = reader.footer_size();
+  if (!footer_size_result.ok()) {
+    return {footer_size_result.error().code,
+            footer_size_result.error().message};
+  }
+
+  int64_t data_end = file_size - footer_size_result.value();
+  auto blobs = std::move(blobs_result).value();
+  for (const auto& blob : blobs) {
+    if (blob->offset() < MAGIC_LENGTH ||
+        blob->offset() + blob->length() > data_end) {
+      return {ErrorCode::kInvalidFooterPayload,
+              "Existing blob lies outside the data region"};
+    }
+  }
+
+  // An existing blob index no longer describes the file once blobs are
+  // appended. It is dropped, its bytes are overwritten when it is the last
+  // blob, and a file that had one gets a new one.
+  int64_t append_offset = data_end;
+  for (auto it = blobs.begin(); it != blobs.end();) {
+    if ((*it)->type() != BLOB_INDEX_BLOB_TYPE) {
+      ++it;
+      continue;
+    }
+    if ((*it)->offset() + (*it)->length() == data_end) {
+      append_offset = (*it)->offset();
+    }
+    params_.write_blob_index = true;
+    it = blobs.erase(it);
+  }
+
+  params_.properties = reader.properties();
+  for (auto& [property, value] : property_updates_) {
+    if (value.has_value()) {
+      params_.properties[property] = std::move(value).value();
+    } else {
+      params_.properties.erase(property);
+    }
+  }
+
+  auto close_result = reader.close();
+  if (!close_result.ok()) {
+    return {close_result.error().code, close_result.error().message};
+  }
+
+  // The file is left untouched until the writer's first write or close
+  return std::make_unique<IcypuffWriter>(std::move(output_file_),
+                                         append_offset, std::move(blobs),
+                                         std::move(params_));
+}
+
+// IcypuffMergeBuilder implementation
+IcypuffMergeBuilder::IcypuffMergeBuilder(
+    std::unique_ptr<OutputFile> output_file)
+    : output_file_(std::move(output_file)) {}
+
+IcypuffMergeBuilder& IcypuffMergeBuilder::add_input(
+    std::unique_ptr<InputFile> input_file) {
+  input_files_.push_back(std::move(input_file));
+  return *this;
+}
+
+IcypuffMergeBuilder& IcypuffMergeBuilder::set(const std::string& property,
+                                              const std::string& value) {
+  params_.properties[property] = value;
+  return *this;
+}
+
+IcypuffMergeBuilder& IcypuffMergeBuilder::set_all(
+    const std::unordered_map<std::string, std::string>& props) {
+  params_.properties.insert(props.begin(), props.end());
+  return *this;
+}
+
+IcypuffMergeBuilder& IcypuffMergeBuilder::created_by(
+    const std::string& application_identifier) {
+  params_.properties["created-by"] = application_identifier;
+  return *this;
+}
+
+IcypuffMergeBuilder& IcypuffMergeBuilder::compress_footer() {
+  params_.compress_footer = true;
+  return *this;
+}
+
+IcypuffMergeBuilder& IcypuffMergeBuilder::filter(BlobFilter filter) {
+  params_.filter = std::move(filter);
+  return *this;
+}
+
+IcypuffMergeBuilder& IcypuffMergeBuilder::write_blob_index() {
+  params_.write_blob_index = true;
+  return *this;
+}
+
+Result<std::unique_ptr<IcypuffMerger>> IcypuffMergeBuilder::build() {
+  if (!output_file_) {
+    return {ErrorCode::kInvalidArgument, "Output file is null"};
+  }
+  for (const auto& input_file : input_files_) {
+    if (!input_file) {
+      return {ErrorCode::kInvalidArgument, "Input file is null"};
+    }
+  }
+
+  return std::make_unique<IcypuffMerger>(
+      std::move(input_files_), std::move(output_file_), std::move(params_));
 }
 
 // IcypuffReadBuilder implementation
@@ -85,4 +284,13 @@ IcypuffReadBuilder Icypuff::read(std::unique_ptr<InputFile> input_file) {
   return IcypuffReadBuilder(std::move(input_file));
 }
 
+IcypuffAppendBuilder Icypuff::append(std::unique_ptr<InputFile> input_file,
+                                     std::unique_ptr<OutputFile> output_file) {
+  return IcypuffAppendBuilder(std::move(input_file), std::move(output_file));
+}
+
+IcypuffMergeBuilder Icypuff::merge(std::unique_ptr<OutputFile> output_file) {
+  return IcypuffMergeBuilder(std::move(output_file));
+}
+
 }  // namespace icypuff
\ No newline at end of file
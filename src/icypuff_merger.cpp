@@ -0,0 +1,153 @@
+#include "icypuff/icypuff_merger.h"
+
+#include <unordered_map>
+#include <unordered_set>
+
+#include "icypuff/blob_index.h"
+#include "icypuff/format_constants.h"
+#include "icypuff/icypuff_reader.h"
+#include "icypuff/icypuff_writer.h"
+#include "icypuff/logging.h"
+#include "icypuff/zstd_dictionary.h"
+
+namespace icypuff {
+
+IcypuffMerger::IcypuffMerger(
+    std::vector<std::unique_ptr<InputFile>> input_files,
+    std::unique_ptr<OutputFile> output_file, IcypuffMergerParams params)
+    : input_files_(std::move(input_files)),
+      output_file_(std::move(output_file)),
+      params_(std::move(params)) {}
+
+Result<MergeSummary> IcypuffMerger::merge() {
+  if (!output_file_) {
+    return {ErrorCode::kInvalidArgument, "Output file is null"};
+  }
+
+  IcypuffWriter writer(std::move(output_file_),
+                       IcypuffWriterParams{
+                           .properties = std::move(params_.properties),
+                           .compress_footer = params_.compress_footer,
+                           .default_blob_compression = CompressionCodec::None,
+                           .compression_policy = std::nullopt,
+                           .zstd_large_blobs = {},
+                           .write_blob_index = params_.write_blob_index,
+                       });
+
+  MergeSummary summary;
+  // A dictionary shared by several inputs is copied once. Ids come from the
+  // dictionary header, which add_zstd_dictionary callers control, so inputs
+  // reusing an id must hold the same dictionary bytes.
+  std::unordered_map<std::string, std::vector<uint8_t>> copied_dictionaries;
+
+  for (auto& input_file : input_files_) {
+    if (!input_file) {
+      return {ErrorCode::kInvalidArgument, "Input file is null"};
+    }
+    auto length_result = input_file->length();
+    if (!length_result.ok()) {
+      return {length_result.error().code, length_result.error().message};
+    }
+    int64_t file_size = length_result.value();
+
+    IcypuffReader reader(std::move(input_file), file_size);
+    auto blobs_result = reader.get_blobs();
+    if (!blobs_result.ok()) {
+      return {blobs_result.error().code, blobs_result.error().message};
+    }
+    auto footer_size_result = reader.footer_size();
+    if (!footer_size_result.ok()) {
+      return {footer_size_result.error().code,
+              footer_size_result.error().message};
+    }
+    int64_t data_end = file_size - footer_size_result.value();
+    const auto& blobs = blobs_result.value();
+
+    // Select regular blobs first to learn which dictionaries they need
+    std::vector<bool> keep(blobs.size(), false);
+    std::unordered_set<std::string> referenced_dictionaries;
+    for (size_t i = 0; i < blobs.size(); i++) {
+      const BlobMetadata& blob = *blobs[i];
+      if (blob.offset() < MAGIC_LENGTH ||
+          blob.offset() + blob.length() > data_end) {
+        return {ErrorCode::kInvalidFooterPayload,
+                "Blob lies outside the data region"};
+      }
+      if (blob.type() == ZSTD_DICTIONARY_BLOB_TYPE ||
+          blob.type() == BLOB_INDEX_BLOB_TYPE) {
+        continue;
+      }
+      keep[i] = !params_.filter || params_.filter(blob);
+      if (keep[i]) {
+        auto dict_it =
+            blob.properties().find(std::string(ZSTD_DICTIONARY_ID_PROPERTY));
+        if (dict_it != blob.properties().end()) {
+          referenced_dictionaries.insert(dict_it->second);
+        }
+      }
+    }
+
+    std::vector<const BlobMetadata*> selected;
+    selected.reserve(blobs.size());
+    for (size_t i = 0; i < blobs.size(); i++) {
+      const BlobMetadata& blob = *blobs[i];
+      if (blob.type() == ZSTD_DICTIONARY_BLOB_TYPE) {
+        auto id_it =
+            blob.properties().find(std::string(ZSTD_DICTIONARY_ID_PROPERTY));
+        if (id_it != blob.properties().end() &&
+            referenced_dictionaries.contains(id_it->second)) {
+          auto dictionary = reader.read_blob(blob);
+          if (!dictionary.ok()) {
+            return {dictionary.error().code, dictionary.error().message};
+          }
+          auto copied = copied_dictionaries.find(id_it->second);
+          if (copied == copied_dictionaries.end()) {
+            copied_dictionaries.emplace(id_it->second,
+                                        std::move(dictionary).value());
+            keep[i] = true;
+          } else if (copied->second != dictionary.value()) {
+            ICYPUFF_LOG_ERROR("Inputs hold different dictionaries with id {}",
+                              id_it->second);
+            return {ErrorCode::kInvalidArgument,
+                    "Inputs hold different Zstd dictionaries with the same id"};
+          }
+        }
+      }
+      if (keep[i]) {
+        selected.push_back(&blob);
+        summary.bytes_copied += blob.length();
+      } else {
+        summary.blobs_dropped++;
+      }
+    }
+
+    auto copy_result = writer.copy_blobs(reader.input_file(), selected);
+    if (!copy_result.ok()) {
+      return {copy_result.error().code, copy_result.error().message};
+    }
+    summary.blobs_copied += static_cast<int64_t>(selected.size());
+    summary.input_files++;
+
+    auto close_result = reader.close();
+    if (!close_result.ok()) {
+      return {close_result.error().code, close_result.error().message};
+    }
+  }
+
+  auto close_result = writer.close();
+  if (!close_result.ok()) {
+    return {close_result.error().code, close_result.error().message};
+  }
+  auto size_result = writer.file_size();
+  if (!size_result.ok()) {
+    return {size_result.error().code, size_result.error().message};
+  }
+  summary.file_size = size_result.value();
+
+  ICYPUFF_LOG_DEBUG("Merged {} files: {} blobs copied, {} dropped",
+                    summary.input_files, summary.blobs_copied,
+                    summary.blobs_dropped);
+  return summary;
+}
+
+}  // namespace icypuff
@@ -1,47 +1,69 @@
 #include "icypuff/icypuff_reader.h"
 
 #include <lz4frame.h>
-#include <spdlog/spdlog.h>
 #include <zstd.h>
 
+#include <charconv>
 #include <ios>
+#include <limits>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <vector>
 
+#include "icypuff/blob_index.h"
 #include "icypuff/compression_codec.h"
 #include "icypuff/file_metadata_parser.h"
 #include "icypuff/format_constants.h"
+#include "icypuff/latency.h"
+#include "icypuff/logging.h"
+#include "icypuff/stats.h"
+#include "icypuff/tracing.h"
 
 namespace icypuff {
 
+namespace {
+
+constexpr auto kRelaxed = std::memory_order_relaxed;
+
+// ZSTD_DCtx for dictionary decompression, one per thread so readers can
+// be shared
+ZSTD_DCtx* ThreadZstdContext() {
+  thread_local ZstdDecompressionContext context;
+  return context.get();
+}
+
+}  // namespace
+
 IcypuffReader::IcypuffReader(std::unique_ptr<InputFile> input_file,
                              std::optional<int64_t> file_size,
                              std::optional<int64_t> footer_size)
     : input_file_(std::move(input_file)) {
   auto length_result = input_file_->length();
   if (!length_result.ok()) {
-    spdlog::error("Failed to get file length: {}",
-                  length_result.error().message);
+    ICYPUFF_LOG_ERROR("Failed to get file length: {}",
+                      length_result.error().message);
     file_size_ = 0;
+    error_code_ = ErrorCode::kStreamNotInitialized;
+    error_message_ = ERROR_READER_NOT_INITIALIZED;
     return;
   }
 
   file_size_ = file_size.value_or(length_result.value());
-  spdlog::debug("File size: {}", file_size_);
+  ICYPUFF_LOG_DEBUG("File size: {}", file_size_);
 
   if (footer_size.has_value()) {
     int64_t size = footer_size.value();
-    spdlog::debug("Using provided footer size: {}", size);
+    ICYPUFF_LOG_DEBUG("Using provided footer size: {}", size);
     if (size <= FOOTER_START_MAGIC_LENGTH + FOOTER_STRUCT_LENGTH) {
-      spdlog::error("Invalid footer size: {}", size);
+      ICYPUFF_LOG_ERROR("Invalid footer size: {}", size);
       error_code_ = ErrorCode::kInvalidFooterSize;
       error_message_ = ERROR_INVALID_FOOTER_SIZE;
       return;
     }
     if (size > file_size_) {
-      spdlog::error("Footer size {} larger than file size {}", size,
-                    file_size_);
+      ICYPUFF_LOG_ERROR("Footer size {} larger than file size {}", size,
+                        file_size_);
       error_code_ = ErrorCode::kInvalidFileLength;
       error_message_ = "Footer size larger than file size";
       return;
@@ -49,37 +71,20 @@ IcypuffReader::IcypuffReader(std::unique_ptr<InputFile> input_file,
     known_footer_size_ = static_cast<int>(size);
   }
 
-  auto stream_result = input_file_->new_stream();
-  if (!stream_result.ok()) {
-    spdlog::error("Failed to create input stream: {}",
-                  stream_result.error().message);
-    error_code_ = ErrorCode::kStreamNotInitialized;
-    error_message_ = ERROR_READER_NOT_INITIALIZED;
-    return;
-  }
-  input_stream_ = std::move(stream_result).value();
-  spdlog::debug("Successfully initialized reader");
+  ICYPUFF_LOG_DEBUG("Successfully initialized reader");
 }
 
-Result<std::vector<std::unique_ptr<BlobMetadata>>> IcypuffReader::get_blobs() {
-  if (error_code_ != ErrorCode::kOk) {
-    return Result<std::vector<std::unique_ptr<BlobMetadata>>>(error_code_,
-                                                              error_message_);
-  }
-
-  if (!input_stream_) {
-    return Result<std::vector<std::unique_ptr<BlobMetadata>>>(
-        ErrorCode::kStreamNotInitialized, ERROR_READER_NOT_INITIALIZED);
-  }
-
-  auto metadata_result = read_file_metadata();
+Result<std::vector<std::unique_ptr<BlobMetadata>>> IcypuffReader::get_blobs()
+    const {
+  auto metadata_result = file_metadata();
   if (!metadata_result.ok()) {
     return Result<std::vector<std::unique_ptr<BlobMetadata>>>(
         metadata_result.error().code, metadata_result.error().message);
   }
 
   std::vector<std::unique_ptr<BlobMetadata>> blobs;
-  for (const auto& blob : known_file_metadata_->blobs()) {
+  blobs.reserve(metadata_result.value()->blobs().size());
+  for (const auto& blob : metadata_result.value()->blobs()) {
     BlobMetadataParams params;
     params.type = blob->type();
     params.input_fields = blob->input_fields();
@@ -92,63 +97,304 @@ Result<std::vector<std::unique_ptr<BlobMetadata>>> IcypuffReader::get_blobs() {
 
     auto new_blob = BlobMetadata::Create(params);
     if (!new_blob.ok()) {
-      spdlog::error("Failed to create blob metadata: {}",
-                    new_blob.error().message);
+      ICYPUFF_LOG_ERROR("Failed to create blob metadata: {}",
+                        new_blob.error().message);
       return Result<std::vector<std::unique_ptr<BlobMetadata>>>(
           new_blob.error().code, new_blob.error().message);
     }
     blobs.push_back(std::move(new_blob).value());
   }
-  spdlog::debug("Successfully read {} blobs", blobs.size());
+  ICYPUFF_LOG_DEBUG("Successfully read {} blobs", blobs.size());
   return blobs;
 }
 
+AsyncResult<Result<std::vector<std::unique_ptr<BlobMetadata>>>>
+IcypuffReader::get_blobs_async(Executor& executor) const {
+  return {executor, [this]() { return get_blobs(); }};
+}
+
+AsyncResult<Result<std::vector<uint8_t>>> IcypuffReader::read_blob_async(
+    Executor& executor, const BlobMetadata& blob) const {
+  return {executor, [this, &blob]() { return read_blob(blob); }};
+}
+
+Result<const FileMetadata*> IcypuffReader::file_metadata() const {
+  if (error_code_ != ErrorCode::kOk) {
+    return {error_code_, error_message_};
+  }
+  if (closed_.load(std::memory_order_acquire)) {
+    return {ErrorCode::kStreamNotInitialized, ERROR_READER_NOT_INITIALIZED};
+  }
+
+  auto metadata_result = read_file_metadata();
+  if (!metadata_result.ok()) {
+    return {metadata_result.error().code, metadata_result.error().message};
+  }
+  return known_file_metadata_.get();
+}
+
 const std::unordered_map<std::string, std::string>& IcypuffReader::properties()
     const {
   static const std::unordered_map<std::string, std::string> empty_map;
-  return known_file_metadata_ ? known_file_metadata_->properties() : empty_map;
+  auto metadata_result = file_metadata();
+  return metadata_result.ok() ? metadata_result.value()->properties()
+                              : empty_map;
+}
+
+Result<int64_t> IcypuffReader::footer_size() const {
+  if (error_code_ != ErrorCode::kOk) {
+    return {error_code_, error_message_};
+  }
+
+  auto footer_size_result = get_footer_size();
+  if (!footer_size_result.ok()) {
+    return {footer_size_result.error().code,
+            footer_size_result.error().message};
+  }
+  return static_cast<int64_t>(footer_size_result.value());
 }
 
 Result<std::vector<uint8_t>> IcypuffReader::read_blob(
-    const BlobMetadata& blob) {
-  if (!input_stream_) {
-    return Result<std::vector<uint8_t>>(ErrorCode::kStreamNotInitialized,
-                                        ERROR_READER_NOT_INITIALIZED);
+    const BlobMetadata& blob) const {
+  auto data_result = read_blob_data(blob);
+  if (!data_result.ok()) {
+    return data_result;
+  }
+  stats_.blobs_read.fetch_add(1, kRelaxed);
+  return decode_blob(blob, data_result.value().data(),
+                     data_result.value().size());
+}
+
+std::vector<Result<std::vector<uint8_t>>> IcypuffReader::read_blobs(
+    const std::vector<const BlobMetadata*>& blobs) const {
+  std::vector<std::vector<uint8_t>> buffers(blobs.size());
+  std::vector<ResultError> errors(blobs.size(), {ErrorCode::kOk, {}});
+  std::vector<PositionalRead> reads;
+  // Blob of each read
+  std::vector<size_t> read_blobs;
+  for (size_t i = 0; i < blobs.size(); i++) {
+    const BlobMetadata& blob = *blobs[i];
+    if (error_code_ != ErrorCode::kOk) {
+      errors[i] = {error_code_, error_message_};
+    } else if (closed_.load(std::memory_order_acquire)) {
+      errors[i] = {ErrorCode::kStreamNotInitialized,
+                   ERROR_READER_NOT_INITIALIZED};
+    } else if (blob.offset() < 0 || blob.length() < 0) {
+      errors[i] = {ErrorCode::kInvalidArgument, "Blob range is invalid"};
+    } else {
+      buffers[i].resize(static_cast<size_t>(blob.length()));
+      reads.push_back({blob.offset(), buffers[i].data(), buffers[i].size()});
+      read_blobs.push_back(i);
+    }
   }
 
-  auto seek_result = input_stream_->seek(blob.offset());
-  if (!seek_result.ok()) {
-    return Result<std::vector<uint8_t>>(ErrorCode::kStreamSeekError,
-                                        seek_result.error().message);
+  input_file_->read_batch(reads, [&](size_t read, Result<void> result) {
+    if (!result.ok()) {
+      errors[read_blobs[read]] = result.error();
+    }
+  });
+  stats_.read_calls.fetch_add(static_cast<int64_t>(reads.size()), kRelaxed);
+  stats_.seeks.fetch_add(static_cast<int64_t>(reads.size()), kRelaxed);
+
+  std::vector<Result<std::vector<uint8_t>>> results;
+  results.reserve(blobs.size());
+  for (size_t i = 0; i < blobs.size(); i++) {
+    if (errors[i].code != ErrorCode::kOk) {
+      results.emplace_back(errors[i].code, errors[i].message);
+      continue;
+    }
+    stats_.bytes_read.fetch_add(static_cast<int64_t>(buffers[i].size()),
+                                kRelaxed);
+    stats_.blobs_read.fetch_add(1, kRelaxed);
+    results.push_back(
+        decode_blob(*blobs[i], buffers[i].data(), buffers[i].size()));
+  }
+  return results;
+}
+
+Result<void> IcypuffReader::read_blob_range(int64_t offset, uint8_t* buffer,
+                                            size_t length,
+                                            size_t blob_count) const {
+  internal::LatencyTimer latency(LatencyOp::kReadBlobIo);
+  ICYPUFF_TRACE_SPAN(read_span, SpanKind::kBlobRead);
+  if (error_code_ != ErrorCode::kOk) {
+    return {error_code_, error_message_};
+  }
+  if (closed_.load(std::memory_order_acquire)) {
+    return {ErrorCode::kStreamNotInitialized, ERROR_READER_NOT_INITIALIZED};
+  }
+  if (offset < 0) {
+    return {ErrorCode::kInvalidArgument, "Blob range is invalid"};
   }
 
-  std::vector<uint8_t> data(blob.length());
-  auto read_result = input_stream_->read(data.data(), data.size());
+  auto read_result = input_file_->read_fully(offset, buffer, length);
+  stats_.read_calls.fetch_add(1, kRelaxed);
+  stats_.seeks.fetch_add(1, kRelaxed);
   if (!read_result.ok()) {
-    return Result<std::vector<uint8_t>>(ErrorCode::kStreamReadError,
-                                        read_result.error().message);
+    return read_result;
+  }
+  stats_.bytes_read.fetch_add(static_cast<int64_t>(length), kRelaxed);
+  stats_.blobs_read.fetch_add(static_cast<int64_t>(blob_count), kRelaxed);
+  ICYPUFF_TRACE_DONE(read_span, length);
+  return Result<void>();
+}
+
+Result<std::vector<uint8_t>> IcypuffReader::decode_blob(
+    const BlobMetadata& blob, const uint8_t* data, size_t length) const {
+  // Blobs compressed with a trained dictionary reference it by id
+  const ZstdDecompressionDictionary* dictionary = nullptr;
+  auto dict_it =
+      blob.properties().find(std::string(ZSTD_DICTIONARY_ID_PROPERTY));
+  if (dict_it != blob.properties().end() &&
+      blob.type() != ZSTD_DICTIONARY_BLOB_TYPE) {
+    auto dict_result = get_zstd_dictionary(dict_it->second);
+    if (!dict_result.ok()) {
+      return {dict_result.error().code, dict_result.error().message};
+    }
+    dictionary = dict_result.value();
+  }
+  return decompress_data(data, length, blob.compression_codec(), dictionary);
+}
+
+Result<RawBlob> IcypuffReader::read_blob_raw(const BlobMetadata& blob) const {
+  auto codec = GetCodecFromName(blob.compression_codec());
+  if (!codec.has_value()) {
+    return {ErrorCode::kUnknownCodec, "Unknown compression codec"};
+  }
+
+  auto data_result = read_blob_data(blob);
+  if (!data_result.ok()) {
+    return {data_result.error().code, data_result.error().message};
+  }
+  stats_.blobs_read.fetch_add(1, kRelaxed);
+  return RawBlob{std::move(data_result).value(), codec.value()};
+}
+
+Result<std::vector<uint8_t>> IcypuffReader::read_blob_data(
+    const BlobMetadata& blob) const {
+  internal::LatencyTimer latency(LatencyOp::kReadBlobIo);
+  ICYPUFF_TRACE_SPAN(read_span, SpanKind::kBlobRead);
+  if (error_code_ != ErrorCode::kOk) {
+    return {error_code_, error_message_};
+  }
+  if (blob.offset() < 0 || blob.length() < 0 ||
+      blob.length() > std::numeric_limits<int>::max()) {
+    return {ErrorCode::kInvalidArgument, "Blob range is invalid"};
+  }
+
+  auto data = read_input(blob.offset(), static_cast<int>(blob.length()));
+  if (data.ok()) {
+    ICYPUFF_TRACE_DONE(read_span, data.value().size());
   }
+  return data;
+}
 
-  if (read_result.value() != data.size()) {
-    return Result<std::vector<uint8_t>>(ErrorCode::kIncompleteRead,
-                                        ERROR_INCOMPLETE_BLOB_READ);
+Result<const ZstdDecompressionDictionary*> IcypuffReader::get_zstd_dictionary(
+    const std::string& id) const {
+  uint32_t dict_id = 0;
+  auto [ptr, ec] = std::from_chars(id.data(), id.data() + id.size(), dict_id);
+  if (ec != std::errc() || ptr != id.data() + id.size()) {
+    return {ErrorCode::kInvalidArgument, "Invalid Zstd dictionary id"};
   }
 
-  return decompress_data(data, blob.compression_codec());
+  // Dictionary slots are registered with the footer and never change after
+  auto metadata_result = read_file_metadata(false);
+  if (!metadata_result.ok()) {
+    return {metadata_result.error().code, metadata_result.error().message};
+  }
+  auto slot_it = zstd_dictionaries_.find(dict_id);
+  if (slot_it == zstd_dictionaries_.end()) {
+    return {ErrorCode::kInvalidArgument, "Zstd dictionary blob not found"};
+  }
+  ZstdDictionarySlot& slot = *slot_it->second;
+
+  bool loaded_now = false;
+  std::call_once(slot.once, [&]() {
+    loaded_now = true;
+    const BlobMetadata& blob = *slot.blob;
+    if (blob.length() > std::numeric_limits<int>::max()) {
+      slot.error_code = ErrorCode::kInvalidArgument;
+      slot.error_message = "Blob range is invalid";
+      return;
+    }
+    auto raw = read_input(blob.offset(), static_cast<int>(blob.length()));
+    if (!raw.ok()) {
+      slot.error_code = raw.error().code;
+      slot.error_message = raw.error().message;
+      return;
+    }
+    // Decoded without the blob decompression stats and latency, which
+    // describe blob reads
+    auto codec = GetCodecFromName(blob.compression_codec());
+    if (!codec.has_value()) {
+      slot.error_code = ErrorCode::kUnknownCodec;
+      slot.error_message = "Unknown compression codec";
+      return;
+    }
+    auto dictionary_data = decompress_codec(
+        raw.value().data(), raw.value().size(), codec.value(), nullptr);
+    if (!dictionary_data.ok()) {
+      slot.error_code = dictionary_data.error().code;
+      slot.error_message = dictionary_data.error().message;
+      return;
+    }
+
+    auto ddict = ZstdDecompressionDictionary::Create(dictionary_data.value());
+    if (!ddict.ok()) {
+      slot.error_code = ddict.error().code;
+      slot.error_message = ddict.error().message;
+      return;
+    }
+    if (ddict.value()->id() != dict_id) {
+      slot.error_code = ErrorCode::kDecompressionError;
+      slot.error_message =
+          "Zstd dictionary id does not match its blob property";
+      return;
+    }
+
+    ICYPUFF_LOG_DEBUG("Loaded Zstd dictionary {} ({} bytes)", dict_id,
+                      dictionary_data.value().size());
+    slot.dictionary = std::move(ddict).value();
+  });
+
+  if (slot.error_code != ErrorCode::kOk) {
+    return {slot.error_code, slot.error_message};
+  }
+  if (!loaded_now) {
+    stats_.dictionary_cache_hits.fetch_add(1, kRelaxed);
+  }
+  return slot.dictionary.get();
 }
 
 Result<std::vector<uint8_t>> IcypuffReader::decompress_data(
-    const std::vector<uint8_t>& data,
-    const std::optional<std::string>& codec_name) {
+    const uint8_t* data, size_t length,
+    const std::optional<std::string>& codec_name,
+    const ZstdDecompressionDictionary* dictionary) const {
   auto codec = GetCodecFromName(codec_name);
   if (!codec.has_value()) {
     return {ErrorCode::kUnknownCodec,
             "Unknown compression codec: " + codec_name.value_or("none")};
   }
 
-  switch (codec.value()) {
+  internal::LatencyTimer latency(LatencyOp::kReadBlobDecompress);
+  ICYPUFF_TRACE_SPAN(decompress_span, SpanKind::kDecompress);
+  int64_t start = internal::NowNanos();
+  auto result = decompress_codec(data, length, codec.value(), dictionary);
+  if (result.ok()) {
+    ICYPUFF_TRACE_DONE(decompress_span, result.value().size());
+    stats_.decompression[static_cast<size_t>(codec.value())].record(
+        static_cast<int64_t>(result.value().size()),
+        static_cast<int64_t>(length), internal::NowNanos() - start);
+  }
+  return result;
+}
+
+Result<std::vector<uint8_t>> IcypuffReader::decompress_codec(
+    const uint8_t* data, size_t length, CompressionCodec codec,
+    const ZstdDecompressionDictionary* dictionary) const {
+  switch (codec) {
     case CompressionCodec::None:
-      return data;
+      return std::vector<uint8_t>(data, data + length);
 
     case CompressionCodec::Lz4: {
       // Get decompressed size from LZ4 frame
@@ -159,25 +405,30 @@ Result<std::vector<uint8_t>> IcypuffReader::decompress_data(
                 "Failed to create LZ4 decompression context"};
       }
 
-      size_t src_size = data.size();
-      size_t dest_size = 0;
-      err = LZ4F_getFrameInfo(ctx, nullptr, data.data(), &src_size);
+      // getFrameInfo consumes the frame header, decoding resumes after it
+      LZ4F_frameInfo_t frame_info;
+      size_t header_size = length;
+      err = LZ4F_getFrameInfo(ctx, &frame_info, data, &header_size);
       if (LZ4F_isError(err)) {
         LZ4F_freeDecompressionContext(ctx);
         return {ErrorCode::kDecompressionError, "Failed to get LZ4 frame info"};
       }
-
-      std::vector<uint8_t> decompressed(err);
+      std::vector<uint8_t> decompressed(frame_info.contentSize);
       size_t decompressed_size = decompressed.size();
+      size_t src_size = length - header_size;
 
       err = LZ4F_decompress(ctx, decompressed.data(), &decompressed_size,
-                            data.data(), &src_size, nullptr);
+                            data + header_size, &src_size, nullptr);
       LZ4F_freeDecompressionContext(ctx);
 
       if (LZ4F_isError(err)) {
         return {ErrorCode::kDecompressionError,
                 "Failed to decompress LZ4 data"};
       }
+      // A non-zero hint means the frame did not end within the content size
+      if (err != 0) {
+        return {ErrorCode::kDecompressionError, "Incomplete LZ4 frame"};
+      }
 
       decompressed.resize(decompressed_size);
       return decompressed;
@@ -185,7 +436,7 @@ Result<std::vector<uint8_t>> IcypuffReader::decompress_data(
 
     case CompressionCodec::Zstd: {
       unsigned long long const decompressed_size =
-          ZSTD_getFrameContentSize(data.data(), data.size());
+          ZSTD_getFrameContentSize(data, length);
       if (decompressed_size == ZSTD_CONTENTSIZE_ERROR) {
         return {ErrorCode::kDecompressionError, "Invalid Zstd data"};
       }
@@ -195,8 +446,20 @@ Result<std::vector<uint8_t>> IcypuffReader::decompress_data(
 
       std::vector<uint8_t> decompressed(decompressed_size);
 
-      size_t const err = ZSTD_decompress(
-          decompressed.data(), decompressed.size(), data.data(), data.size());
+      size_t err = 0;
+      if (dictionary) {
+        ZSTD_DCtx* context = ThreadZstdContext();
+        if (!context) {
+          return {ErrorCode::kDecompressionError,
+                  "Failed to create ZSTD decompression context"};
+        }
+        err = ZSTD_decompress_usingDDict(context, decompressed.data(),
+                                         decompressed.size(), data, length,
+                                         dictionary->get());
+      } else {
+        err = ZSTD_decompress(decompressed.data(), decompressed.size(), data,
+                              length);
+      }
       if (ZSTD_isError(err)) {
         return {ErrorCode::kDecompressionError,
                 "Failed to decompress Zstd data"};
@@ -211,19 +474,62 @@ Result<std::vector<uint8_t>> IcypuffReader::decompress_data(
 }
 
 Result<void> IcypuffReader::close() {
-  if (input_stream_) {
-    auto result = input_stream_->close();
-    input_stream_.reset();
-    return result;
+  closed_.store(true, std::memory_order_release);
+  return Result<void>();
+}
+
+Result<void> IcypuffReader::read_file_metadata(bool count_cache_hit) const {
+  bool loaded_now = false;
+  std::call_once(metadata_once_, [&]() {
+    loaded_now = true;
+    auto result = load_file_metadata();
+    if (!result.ok()) {
+      metadata_error_code_ = result.error().code;
+      metadata_error_message_ = result.error().message;
+      known_file_metadata_.reset();
+      return;
+    }
+    register_zstd_dictionaries();
+  });
+
+  if (metadata_error_code_ != ErrorCode::kOk) {
+    return {metadata_error_code_, metadata_error_message_};
+  }
+  if (!loaded_now && count_cache_hit) {
+    ICYPUFF_LOG_DEBUG("Using cached file metadata");
+    stats_.metadata_cache_hits.fetch_add(1, kRelaxed);
   }
   return Result<void>();
 }
 
-Result<void> IcypuffReader::read_file_metadata() {
-  if (known_file_metadata_) {
-    spdlog::debug("Using cached file metadata");
-    return Result<void>();
+void IcypuffReader::register_zstd_dictionaries() const {
+  for (const auto& blob : known_file_metadata_->blobs()) {
+    if (blob->type() != ZSTD_DICTIONARY_BLOB_TYPE) {
+      continue;
+    }
+    auto id_it =
+        blob->properties().find(std::string(ZSTD_DICTIONARY_ID_PROPERTY));
+    if (id_it == blob->properties().end()) {
+      continue;
+    }
+    const std::string& id = id_it->second;
+    uint32_t dict_id = 0;
+    auto [ptr, ec] =
+        std::from_chars(id.data(), id.data() + id.size(), dict_id);
+    if (ec != std::errc() || ptr != id.data() + id.size()) {
+      continue;
+    }
+    // The first dictionary blob with an id wins, as when searching in order
+    auto slot = std::make_unique<ZstdDictionarySlot>();
+    slot->blob = blob.get();
+    zstd_dictionaries_.try_emplace(dict_id, std::move(slot));
   }
+}
+
+Result<void> IcypuffReader::load_file_metadata() const {
+  internal::LatencyTimer latency(LatencyOp::kReadFileMetadata);
+  int64_t read_start = internal::NowNanos();
+  ICYPUFF_TRACE_SPAN(footer_span, SpanKind::kFooterRead);
 
   auto footer_size_result = get_footer_size();
   if (!footer_size_result.ok()) {
@@ -231,15 +537,31 @@ Result<void> IcypuffReader::read_file_metadata() {
                         footer_size_result.error().message);
   }
   int footer_size = footer_size_result.value();
-  spdlog::debug("Footer size: {}", footer_size);
+  ICYPUFF_LOG_DEBUG("Footer size: {}", footer_size);
+
+  // A blob index written just before the footer replaces reading and
+  // parsing the JSON footer
+  auto index_result = read_blob_index(file_size_ - footer_size);
+  if (!index_result.ok()) {
+    return {index_result.error().code, index_result.error().message};
+  }
+  if (index_result.value()) {
+    stats_.footer_reads.fetch_add(1, kRelaxed);
+    stats_.footer_index_loads.fetch_add(1, kRelaxed);
+    stats_.footer_read_nanos.fetch_add(internal::NowNanos() - read_start,
+                                       kRelaxed);
+    ICYPUFF_TRACE_DONE(footer_span, footer_size);
+    ICYPUFF_LOG_DEBUG("Loaded file metadata from the blob index");
+    return Result<void>();
+  }
 
   auto footer_data = read_input(file_size_ - footer_size, footer_size);
   if (!footer_data.ok()) {
     return Result<void>(ErrorCode::kInvalidFooterSize,
                         ERROR_INVALID_FOOTER_SIZE);
   }
-  spdlog::debug("Successfully read {} bytes of footer data",
-                footer_data.value().size());
+  ICYPUFF_LOG_DEBUG("Successfully read {} bytes of footer data",
+                    footer_data.value().size());
 
   auto magic_check =
       check_magic(footer_data.value(), FOOTER_START_MAGIC_OFFSET);
@@ -257,7 +579,7 @@ Result<void> IcypuffReader::read_file_metadata() {
   int footer_payload_size = read_integer_little_endian(
       footer_data.value().data() + footer_struct_offset,
       FOOTER_STRUCT_PAYLOAD_SIZE_OFFSET);
-  spdlog::debug("Footer payload size: {}", footer_payload_size);
+  ICYPUFF_LOG_DEBUG("Footer payload size: {}", footer_payload_size);
 
   if (footer_size !=
       FOOTER_START_MAGIC_LENGTH + footer_payload_size + FOOTER_STRUCT_LENGTH) {
@@ -267,34 +589,127 @@ Result<void> IcypuffReader::read_file_metadata() {
 
   // Extract the footer payload (JSON data) between the start magic and footer
   // struct
-  std::string json_data(
-      reinterpret_cast<const char*>(footer_data.value().data() +
-                                    FOOTER_START_MAGIC_LENGTH),
-      footer_payload_size);
-  spdlog::debug("Footer JSON: {}", json_data);
-
-  auto metadata_result = FileMetadataParser::FromJson(json_data);
+  const uint8_t* payload =
+      footer_data.value().data() + FOOTER_START_MAGIC_LENGTH;
+  uint32_t flags = read_integer_little_endian(
+      footer_data.value().data() + footer_struct_offset,
+      FOOTER_STRUCT_FLAGS_OFFSET);
+  std::string json_data;
+  if (flags &
+      (1u << static_cast<int>(FooterFlag::FOOTER_PAYLOAD_COMPRESSED))) {
+    // The spec compresses footers with LZ4 while this library's writer uses
+    // Zstd, the frame magic tells them apart
+    uint32_t frame_magic =
+        footer_payload_size < 4 ? 0 : read_integer_little_endian(payload, 0);
+    CompressionCodec codec;
+    if (frame_magic == LZ4F_MAGICNUMBER) {
+      codec = CompressionCodec::Lz4;
+    } else if (frame_magic == ZSTD_MAGICNUMBER) {
+      codec = CompressionCodec::Zstd;
+    } else {
+      return Result<void>(ErrorCode::kInvalidFooterPayload,
+                          "Unknown footer payload compression");
+    }
+    auto decompressed =
+        decompress_codec(payload, footer_payload_size, codec, nullptr);
+    if (!decompressed.ok()) {
+      return Result<void>(ErrorCode::kInvalidFooterPayload,
+                          decompressed.error().message);
+    }
+    json_data.assign(
+        reinterpret_cast<const char*>(decompressed.value().data()),
+        decompressed.value().size());
+  } else {
+    json_data.assign(reinterpret_cast<const char*>(payload),
+                     footer_payload_size);
+  }
+
+  int64_t parse_start = internal::NowNanos();
+  stats_.footer_reads.fetch_add(1, kRelaxed);
+  stats_.footer_read_nanos.fetch_add(parse_start - read_start, kRelaxed);
+  Result<std::unique_ptr<FileMetadata>> metadata_result = [&]() {
+    ICYPUFF_TRACE_SPAN(parse_span, SpanKind::kFooterParse);
+    auto result = FileMetadataParser::FromJson(json_data);
+    if (result.ok()) {
+      ICYPUFF_TRACE_DONE(parse_span, json_data.size());
+    }
+    return result;
+  }();
+  stats_.footer_parse_nanos.fetch_add(internal::NowNanos() - parse_start,
+                                      kRelaxed);
   if (!metadata_result.ok()) {
     return Result<void>(ErrorCode::kInvalidFooterPayload,
                         metadata_result.error().message);
   }
 
   known_file_metadata_ = std::move(metadata_result).value();
-  spdlog::debug("Successfully parsed file metadata");
+  ICYPUFF_TRACE_DONE(footer_span, footer_size);
+  ICYPUFF_LOG_DEBUG("Successfully parsed file metadata");
   return Result<void>();
 }
 
-Result<int> IcypuffReader::get_footer_size() {
-  if (known_footer_size_) {
-    return *known_footer_size_;
+Result<bool> IcypuffReader::read_blob_index(int64_t data_end) const {
+  if (data_end < MAGIC_LENGTH + BLOB_INDEX_TRAILER_LENGTH) {
+    return false;
+  }
+  auto trailer = read_input(data_end - BLOB_INDEX_TRAILER_LENGTH,
+                            BLOB_INDEX_TRAILER_LENGTH);
+  if (!trailer.ok()) {
+    return {trailer.error().code, trailer.error().message};
+  }
+  auto location = ParseBlobIndexTrailer(trailer.value().data(), data_end);
+  if (!location.has_value() ||
+      location->length > std::numeric_limits<int>::max()) {
+    return false;
+  }
+
+  auto index = read_input(location->offset, static_cast<int>(location->length));
+  if (!index.ok()) {
+    return {index.error().code, index.error().message};
+  }
+  int64_t parse_start = internal::NowNanos();
+  auto metadata = DecodeBlobIndex(index.value(), location.value());
+  stats_.footer_parse_nanos.fetch_add(internal::NowNanos() - parse_start,
+                                      kRelaxed);
+  if (!metadata.ok()) {
+    // The JSON footer is authoritative, a damaged index only costs speed
+    ICYPUFF_LOG_WARN("Ignoring blob index: {}", metadata.error().message);
+    return false;
+  }
+  known_file_metadata_ = std::move(metadata).value();
+  return true;
+}
+
+Result<int> IcypuffReader::get_footer_size() const {
+  std::call_once(footer_size_once_, [&]() {
+    if (known_footer_size_) {
+      return;
+    }
+    auto result = load_footer_size();
+    if (!result.ok()) {
+      footer_size_error_code_ = result.error().code;
+      if (footer_size_error_message_.empty()) {
+        footer_size_error_message_ = result.error().message;
+      }
+      return;
+    }
+    known_footer_size_ = result.value();
+  });
+
+  if (footer_size_error_code_ != ErrorCode::kOk) {
+    return {footer_size_error_code_, footer_size_error_message_};
   }
+  return *known_footer_size_;
+}
 
+Result<int> IcypuffReader::load_footer_size() const {
   if (file_size_ < FOOTER_STRUCT_LENGTH) {
-    return Result<int>(ErrorCode::kInvalidFileLength,
-                       "Invalid file: file length " +
-                           std::to_string(file_size_) +
-                           " is less than minimal length of the footer tail " +
-                           std::to_string(FOOTER_STRUCT_LENGTH));
+    // Runs under footer_size_once_, the message outlives the result
+    footer_size_error_message_ =
+        "Invalid file: file length " + std::to_string(file_size_) +
+        " is less than minimal length of the footer tail " +
+        std::to_string(FOOTER_STRUCT_LENGTH);
+    return {ErrorCode::kInvalidFileLength, footer_size_error_message_};
   }
 
   auto footer_struct =
@@ -335,41 +750,32 @@ Result<int> IcypuffReader::get_footer_size() {
     return Result<int>(ErrorCode::kInvalidMagic, ERROR_INVALID_MAGIC);
   }
 
-  known_footer_size_ = total_footer_size;
   return total_footer_size;
 }
 
 Result<std::vector<uint8_t>> IcypuffReader::read_input(int64_t offset,
-                                                       int length) {
-  if (!input_stream_) {
+                                                       int length) const {
+  if (closed_.load(std::memory_order_acquire)) {
     return Result<std::vector<uint8_t>>(ErrorCode::kStreamNotInitialized,
                                         ERROR_READER_NOT_INITIALIZED);
   }
 
-  auto seek_result = input_stream_->seek(offset);
-  if (!seek_result.ok()) {
-    return Result<std::vector<uint8_t>>(ErrorCode::kStreamSeekError,
-                                        seek_result.error().message);
-  }
-
   std::vector<uint8_t> data(length);
-  auto read_result = input_stream_->read(data.data(), data.size());
+  auto read_result = input_file_->read_fully(offset, data.data(), data.size());
+  stats_.read_calls.fetch_add(1, kRelaxed);
+  stats_.seeks.fetch_add(1, kRelaxed);
   if (!read_result.ok()) {
-    return Result<std::vector<uint8_t>>(ErrorCode::kStreamReadError,
+    return Result<std::vector<uint8_t>>(read_result.error().code,
                                         read_result.error().message);
   }
+  stats_.bytes_read.fetch_add(length, kRelaxed);
 
-  if (read_result.value() != data.size()) {
-    return Result<std::vector<uint8_t>>(ErrorCode::kIncompleteRead,
-                                        ERROR_INCOMPLETE_BLOB_READ);
-  }
-
-  spdlog::debug("Successfully read {} bytes at offset {}", length, offset);
+  ICYPUFF_LOG_DEBUG("Successfully read {} bytes at offset {}", length, offset);
   return data;
 }
 
 Result<void> IcypuffReader::check_magic(const std::vector<uint8_t>& data,
-                                        int offset) {
+                                        int offset) const {
   if (offset + MAGIC_LENGTH > data.size()) {
     return Result<void>(ErrorCode::kInvalidFileLength,
                         "Not enough data to check magic: need " +
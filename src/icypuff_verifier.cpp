@@ -0,0 +1,428 @@
+#include "icypuff/icypuff_verifier.h"
+
+#include <lz4frame.h>
+#include <zstd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "icypuff/compression_codec.h"
+#include "icypuff/format_constants.h"
+#include "icypuff/icypuff_reader.h"
+#include "icypuff/logging.h"
+#include "icypuff/zstd_dictionary.h"
+
+namespace icypuff {
+
+namespace {
+
+// Frames are decoded into a fixed scratch buffer and the output discarded,
+// so verifying a blob never holds its decoded contents
+constexpr size_t VERIFY_SCRATCH_SIZE = 256 << 10;
+
+// A blob that passed the structural checks, queued for decoding
+struct PendingBlob {
+  int64_t index;
+  const BlobMetadata* metadata;
+  CompressionCodec codec;
+  const ZstdDecompressionDictionary* dictionary;
+};
+
+// Consecutive blobs fetched with one read
+struct ReadRange {
+  int64_t offset;
+  int64_t length;
+  std::vector<PendingBlob> blobs;
+};
+
+Result<void> ReadFully(SeekableInputStream& stream, int64_t offset,
+                       uint8_t* buffer, size_t length) {
+  auto seek_result = stream.seek(offset);
+  if (!seek_result.ok()) {
+    return seek_result;
+  }
+  size_t total = 0;
+  while (total < length) {
+    auto read_result = stream.read(buffer + total, length - total);
+    if (!read_result.ok()) {
+      return {read_result.error().code, read_result.error().message};
+    }
+    if (read_result.value() == 0) {
+      return {ErrorCode::kIncompleteRead, "File ended inside a blob"};
+    }
+    total += read_result.value();
+  }
+  return Result<void>();
+}
+
+// Decoding state owned by one worker thread
+class FrameChecker {
+ public:
+  FrameChecker() : scratch_(VERIFY_SCRATCH_SIZE) {
+    if (LZ4F_isError(LZ4F_createDecompressionContext(&lz4_, LZ4F_VERSION))) {
+      lz4_ = nullptr;
+    }
+  }
+
+  ~FrameChecker() {
+    if (lz4_) {
+      LZ4F_freeDecompressionContext(lz4_);
+    }
+  }
+
+  ICYPUFF_DISALLOW_COPY_ASSIGN_AND_MOVE(FrameChecker);
+
+  // Returns an empty string when the frame is valid and sets the decoded
+  // size
+  std::string check(const uint8_t* data, size_t size, const PendingBlob& blob,
+                    int64_t& decoded) {
+    switch (blob.codec) {
+      case CompressionCodec::None:
+        decoded = static_cast<int64_t>(size);
+        return {};
+      case CompressionCodec::Lz4:
+        return check_lz4(data, size, decoded);
+      case CompressionCodec::Zstd:
+        return check_zstd(data, size, blob.dictionary, decoded);
+    }
+    return "Unknown compression codec";
+  }
+
+ private:
+  std::string check_lz4(const uint8_t* data, size_t size, int64_t& decoded) {
+    if (!lz4_) {
+      return "Failed to create LZ4 decompression context";
+    }
+    LZ4F_resetDecompressionContext(lz4_);
+
+    LZ4F_frameInfo_t frame_info;
+    size_t consumed = size;
+    size_t hint = LZ4F_getFrameInfo(lz4_, &frame_info, data, &consumed);
+    if (LZ4F_isError(hint)) {
+      return std::string("Invalid LZ4 frame header: ") +
+             LZ4F_getErrorName(hint);
+    }
+
+    // The frame's block and content checksums are verified while decoding
+    decoded = 0;
+    while (hint != 0) {
+      if (consumed == size) {
+        return "LZ4 frame is truncated";
+      }
+      size_t src_size = size - consumed;
+      size_t dst_size = scratch_.size();
+      hint = LZ4F_decompress(lz4_, scratch_.data(), &dst_size,
+                             data + consumed, &src_size, nullptr);
+      if (LZ4F_isError(hint)) {
+        return std::string("LZ4 frame does not decode: ") +
+               LZ4F_getErrorName(hint);
+      }
+      consumed += src_size;
+      decoded += static_cast<int64_t>(dst_size);
+    }
+
+    if (consumed != size) {
+      return "Trailing bytes after the LZ4 frame";
+    }
+    if (frame_info.contentSize != 0 &&
+        static_cast<int64_t>(frame_info.contentSize) != decoded) {
+      return "LZ4 frame decodes to a different size than it declares";
+    }
+    return {};
+  }
+
+  std::string check_zstd(const uint8_t* data, size_t size,
+                         const ZstdDecompressionDictionary* dictionary,
+                         int64_t& decoded) {
+    if (!zstd_.valid()) {
+      return "Failed to create Zstd decompression context";
+    }
+    size_t frame_size = ZSTD_findFrameCompressedSize(data, size);
+    if (ZSTD_isError(frame_size)) {
+      return std::string("Invalid Zstd frame: ") +
+             ZSTD_getErrorName(frame_size);
+    }
+    if (frame_size != size) {
+      return "Trailing bytes after the Zstd frame";
+    }
+    unsigned long long content_size = ZSTD_getFrameContentSize(data, size);
+
+    ZSTD_DCtx_reset(zstd_.get(), ZSTD_reset_session_and_parameters);
+    if (dictionary) {
+      ZSTD_DCtx_refDDict(zstd_.get(), dictionary->get());
+    }
+
+    // The frame's content checksum is verified when its end is decoded
+    ZSTD_inBuffer input{data, size, 0};
+    decoded = 0;
+    size_t remaining = 1;
+    while (remaining != 0) {
+      ZSTD_outBuffer output{scratch_.data(), scratch_.size(), 0};
+      remaining = ZSTD_decompressStream(zstd_.get(), &output, &input);
+      if (ZSTD_isError(remaining)) {
+        return std::string("Zstd frame does not decode: ") +
+               ZSTD_getErrorName(remaining);
+      }
+      decoded += static_cast<int64_t>(output.pos);
+      if (remaining != 0 && input.pos == input.size &&
+          output.pos < output.size) {
+        return "Zstd frame is truncated";
+      }
+    }
+
+    if (content_size != ZSTD_CONTENTSIZE_UNKNOWN &&
+        static_cast<int64_t>(content_size) != decoded) {
+      return "Zstd frame decodes to a different size than it declares";
+    }
+    return {};
+  }
+
+  std::vector<uint8_t> scratch_;
+  LZ4F_dctx* lz4_ = nullptr;
+  ZstdDecompressionContext zstd_;
+};
+
+}  // namespace
+
+IcypuffVerifier::IcypuffVerifier(std::unique_ptr<InputFile> input_file,
+                                 IcypuffVerifierParams params)
+    : input_file_(std::move(input_file)), params_(params) {}
+
+Result<VerificationReport> IcypuffVerifier::verify() {
+  if (!input_file_) {
+    return {ErrorCode::kInvalidArgument, "Input file is null"};
+  }
+  auto length_result = input_file_->length();
+  if (!length_result.ok()) {
+    return {length_result.error().code, length_result.error().message};
+  }
+  int64_t file_size = length_result.value();
+
+  VerificationReport report;
+  auto file_issue = [&](std::string message) {
+    report.issues.push_back({-1, std::move(message)});
+  };
+
+  IcypuffReader reader(std::move(input_file_), file_size);
+  const InputFile& input_file = reader.input_file();
+
+  // Header magic
+  auto stream_result = input_file.new_stream();
+  if (!stream_result.ok()) {
+    return {stream_result.error().code, stream_result.error().message};
+  }
+  if (file_size < MAGIC_LENGTH) {
+    file_issue("File is shorter than the header magic");
+    return report;
+  }
+  uint8_t header[MAGIC_LENGTH];
+  auto header_result =
+      ReadFully(*stream_result.value(), 0, header, MAGIC_LENGTH);
+  if (!header_result.ok()) {
+    return {header_result.error().code, header_result.error().message};
+  }
+  if (std::memcmp(header, MAGIC, MAGIC_LENGTH) != 0) {
+    file_issue("Invalid header magic");
+  }
+
+  // Footer magics and bounds are checked while the footer is loaded
+  auto blobs_result = reader.get_blobs();
+  if (!blobs_result.ok()) {
+    file_issue("Invalid footer: " + std::string(blobs_result.error().message));
+    return report;
+  }
+  auto footer_size_result = reader.footer_size();
+  if (!footer_size_result.ok()) {
+    file_issue("Invalid footer: " +
+               std::string(footer_size_result.error().message));
+    return report;
+  }
+  int64_t data_end = file_size - footer_size_result.value();
+  const auto& blobs = blobs_result.value();
+  auto blob_issue = [&](size_t index, std::string message) {
+    report.issues.push_back({static_cast<int64_t>(index), std::move(message)});
+  };
+
+  // Dictionaries are few and small, they are loaded through the reader
+  std::unordered_map<std::string, std::unique_ptr<ZstdDecompressionDictionary>>
+      dictionaries;
+  for (size_t i = 0; i < blobs.size(); i++) {
+    const BlobMetadata& blob = *blobs[i];
+    if (blob.type() != ZSTD_DICTIONARY_BLOB_TYPE) {
+      continue;
+    }
+    auto id_it =
+        blob.properties().find(std::string(ZSTD_DICTIONARY_ID_PROPERTY));
+    if (id_it == blob.properties().end()) {
+      blob_issue(i, "Zstd dictionary blob has no dictionary id");
+      continue;
+    }
+    auto data = reader.read_blob(blob);
+    if (!data.ok()) {
+      blob_issue(i, "Zstd dictionary does not load: " +
+                        std::string(data.error().message));
+      continue;
+    }
+    auto ddict = ZstdDecompressionDictionary::Create(data.value());
+    if (!ddict.ok()) {
+      blob_issue(i, "Invalid Zstd dictionary: " +
+                        std::string(ddict.error().message));
+      continue;
+    }
+    if (std::to_string(ddict.value()->id()) != id_it->second) {
+      blob_issue(i, "Zstd dictionary id does not match its blob property");
+      continue;
+    }
+    dictionaries.emplace(id_it->second, std::move(ddict).value());
+  }
+
+  // Structural checks, in file order so overlaps are adjacent
+  std::vector<size_t> order(blobs.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return blobs[a]->offset() < blobs[b]->offset();
+  });
+
+  std::vector<ReadRange> ranges;
+  int64_t previous_end = MAGIC_LENGTH;
+  size_t previous_index = 0;
+  bool has_previous = false;
+  for (size_t i : order) {
+    const BlobMetadata& blob = *blobs[i];
+    if (blob.length() < 0 || blob.offset() < MAGIC_LENGTH ||
+        blob.offset() > data_end - blob.length()) {
+      blob_issue(i, "Blob lies outside the data region");
+      continue;
+    }
+    if (has_previous && blob.offset() < previous_end) {
+      blob_issue(i, "Blob overlaps blob " + std::to_string(previous_index));
+    }
+    if (blob.offset() + blob.length() > previous_end || !has_previous) {
+      previous_end = blob.offset() + blob.length();
+      previous_index = i;
+    }
+    has_previous = true;
+
+    auto codec = GetCodecFromName(blob.compression_codec());
+    if (!codec.has_value()) {
+      blob_issue(i, "Unknown compression codec");
+      continue;
+    }
+    const ZstdDecompressionDictionary* dictionary = nullptr;
+    auto dict_it =
+        blob.properties().find(std::string(ZSTD_DICTIONARY_ID_PROPERTY));
+    if (dict_it != blob.properties().end() &&
+        blob.type() != ZSTD_DICTIONARY_BLOB_TYPE) {
+      auto found = dictionaries.find(dict_it->second);
+      if (found == dictionaries.end()) {
+        blob_issue(i, "Zstd dictionary " + dict_it->second + " is missing");
+        continue;
+      }
+      dictionary = found->second.get();
+    }
+
+    // Extend the current read while the blob is close and the read small
+    PendingBlob pending{static_cast<int64_t>(i), &blob, codec.value(),
+                        dictionary};
+    if (!ranges.empty()) {
+      ReadRange& range = ranges.back();
+      int64_t range_end = range.offset + range.length;
+      int64_t new_end = std::max(range_end, blob.offset() + blob.length());
+      if (blob.offset() - range_end <= params_.max_read_gap &&
+          new_end - range.offset <= params_.max_read_size) {
+        range.length = new_end - range.offset;
+        range.blobs.push_back(pending);
+        continue;
+      }
+    }
+    ranges.push_back({blob.offset(), blob.length(), {pending}});
+  }
+
+  // Decode in parallel, each worker with its own stream and contexts
+  int threads = params_.threads > 0
+                    ? params_.threads
+                    : static_cast<int>(std::thread::hardware_concurrency());
+  int max_threads = static_cast<int>(std::max<size_t>(ranges.size(), 1));
+  threads = std::clamp(threads, 1, max_threads);
+
+  std::atomic<size_t> next_range{0};
+  std::atomic<int64_t> bytes_read{0};
+  std::atomic<int64_t> uncompressed_bytes{0};
+  std::atomic<int64_t> blobs_checked{0};
+  std::mutex mutex;
+  std::vector<VerificationIssue> issues;
+  Result<void> io_error;
+
+  auto worker = [&]() {
+    auto stream = input_file.new_stream();
+    if (!stream.ok()) {
+      std::lock_guard<std::mutex> lock(mutex);
+      io_error = {stream.error().code, stream.error().message};
+      return;
+    }
+    FrameChecker checker;
+    std::vector<uint8_t> buffer;
+    std::vector<VerificationIssue> local_issues;
+    for (size_t r = next_range.fetch_add(1); r < ranges.size();
+         r = next_range.fetch_add(1)) {
+      const ReadRange& range = ranges[r];
+      buffer.resize(static_cast<size_t>(range.length));
+      auto read_result = ReadFully(*stream.value(), range.offset,
+                                   buffer.data(), buffer.size());
+      if (!read_result.ok()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        io_error = read_result;
+        return;
+      }
+      bytes_read.fetch_add(range.length, std::memory_order_relaxed);
+
+      for (const PendingBlob& blob : range.blobs) {
+        int64_t decoded = 0;
+        std::string problem = checker.check(
+            buffer.data() + (blob.metadata->offset() - range.offset),
+            static_cast<size_t>(blob.metadata->length()), blob, decoded);
+        if (!problem.empty()) {
+          local_issues.push_back({blob.index, std::move(problem)});
+        }
+        uncompressed_bytes.fetch_add(decoded, std::memory_order_relaxed);
+        blobs_checked.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    issues.insert(issues.end(), local_issues.begin(), local_issues.end());
+  };
+
+  std::vector<std::thread> workers;
+  for (int t = 1; t < threads; t++) {
+    workers.emplace_back(worker);
+  }
+  worker();
+  for (auto& thread : workers) {
+    thread.join();
+  }
+  if (!io_error.ok()) {
+    return {io_error.error().code, io_error.error().message};
+  }
+
+  report.issues.insert(report.issues.end(), issues.begin(), issues.end());
+  std::stable_sort(report.issues.begin(), report.issues.end(),
+                   [](const VerificationIssue& a, const VerificationIssue& b) {
+                     return a.blob_index < b.blob_index;
+                   });
+  report.blobs_checked = blobs_checked.load();
+  report.bytes_read = bytes_read.load();
+  report.uncompressed_bytes = uncompressed_bytes.load();
+  report.reads = static_cast<int64_t>(ranges.size());
+  ICYPUFF_LOG_DEBUG("Verified {} blobs with {} reads on {} threads, {} issues",
+                    report.blobs_checked, report.reads, threads,
+                    report.issues.size());
+  return report;
+}
+
+}  // namespace icypuff
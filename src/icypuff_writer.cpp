@@ -1,38 +1,124 @@
 #include "icypuff/icypuff_writer.h"
 
 #include <lz4frame.h>
-#include <spdlog/spdlog.h>
 #include <zstd.h>
 
+#include <algorithm>
 #include <memory>
+#include <string>
 #include <vector>
 
-#include "icypuff/file_metadata.h"
+#include "icypuff/blob_index.h"
 #include "icypuff/file_metadata_parser.h"
 #include "icypuff/format_constants.h"
+#include "icypuff/latency.h"
+#include "icypuff/logging.h"
+#include "icypuff/tracing.h"
 
 namespace icypuff {
 
+namespace {
+
+// Buffer size for copying blob bytes when no zero-copy transfer is possible
+constexpr int64_t COPY_BUFFER_SIZE = 1024 * 1024;
+
+constexpr auto kRelaxed = std::memory_order_relaxed;
+
+// Counts the I/O the writer issues against its output stream
+class CountingOutputStream : public PositionOutputStream {
+ public:
+  CountingOutputStream(std::unique_ptr<PositionOutputStream> stream,
+                       internal::WriterCounters& counters)
+      : stream_(std::move(stream)), counters_(counters) {}
+
+  Result<void> write(const uint8_t* buffer, size_t length) override {
+    auto result = stream_->write(buffer, length);
+    counters_.write_calls.fetch_add(1, kRelaxed);
+    if (result.ok()) {
+      counters_.bytes_written.fetch_add(static_cast<int64_t>(length),
+                                        kRelaxed);
+    }
+    return result;
+  }
+
+  Result<void> transfer_from(const InputFile& source, int64_t offset,
+                             int64_t length) override {
+    auto result = stream_->transfer_from(source, offset, length);
+    if (result.ok()) {
+      counters_.write_calls.fetch_add(1, kRelaxed);
+      counters_.bytes_written.fetch_add(length, kRelaxed);
+    }
+    return result;
+  }
+
+  Result<int64_t> position() const override { return stream_->position(); }
+
+  Result<void> flush() override { return stream_->flush(); }
+
+  Result<void> close() override { return stream_->close(); }
+
+ private:
+  std::unique_ptr<PositionOutputStream> stream_;
+  internal::WriterCounters& counters_;
+};
+
+}  // namespace
+
 IcypuffWriter::IcypuffWriter(
     std::unique_ptr<OutputFile> output_file,
     std::unordered_map<std::string, std::string> properties,
     bool compress_footer, CompressionCodec default_blob_compression)
+    : IcypuffWriter(std::move(output_file),
+                    IcypuffWriterParams{
+                        .properties = std::move(properties),
+                        .compress_footer = compress_footer,
+                        .default_blob_compression = default_blob_compression,
+                        .compression_policy = std::nullopt,
+                        .zstd_large_blobs = {},
+                        .write_blob_index = false,
+                    }) {}
+
+IcypuffWriter::IcypuffWriter(std::unique_ptr<OutputFile> output_file,
+                             IcypuffWriterParams params)
     : output_file_(std::move(output_file)),
-      properties_(std::move(properties)),
-      footer_compression_(compress_footer ? CompressionCodec::Zstd
-                                          : CompressionCodec::None),
-      default_blob_compression_(default_blob_compression) {
-  spdlog::debug("Attempting to create output stream");
+      properties_(std::move(params.properties)),
+      footer_compression_(params.compress_footer ? CompressionCodec::Zstd
+                                                 : CompressionCodec::None),
+      default_blob_compression_(params.default_blob_compression),
+      compression_policy_(params.compression_policy),
+      zstd_large_blobs_(params.zstd_large_blobs),
+      write_blob_index_(params.write_blob_index) {
+  ICYPUFF_LOG_DEBUG("Attempting to create output stream");
 
   auto stream_result = output_file_->create_or_overwrite();
   if (!stream_result.ok()) {
-    spdlog::error("Failed to create output stream: {}",
-                  stream_result.error().message);
+    ICYPUFF_LOG_ERROR("Failed to create output stream: {}",
+                      stream_result.error().message);
     return;
   }
 
-  output_stream_ = std::move(stream_result).value();
-  spdlog::debug("Output stream created successfully");
+  output_stream_ = std::make_unique<CountingOutputStream>(
+      std::move(stream_result).value(), stats_);
+  ICYPUFF_LOG_DEBUG("Output stream created successfully");
+}
+
+IcypuffWriter::IcypuffWriter(
+    std::unique_ptr<OutputFile> output_file, int64_t append_offset,
+    std::vector<std::unique_ptr<BlobMetadata>> existing_blobs,
+    IcypuffWriterParams params)
+    : output_file_(std::move(output_file)),
+      append_offset_(append_offset),
+      properties_(std::move(params.properties)),
+      footer_compression_(params.compress_footer ? CompressionCodec::Zstd
+                                                 : CompressionCodec::None),
+      default_blob_compression_(params.default_blob_compression),
+      compression_policy_(params.compression_policy),
+      zstd_large_blobs_(params.zstd_large_blobs),
+      write_blob_index_(params.write_blob_index),
+      written_blobs_metadata_(std::move(existing_blobs)),
+      header_written_(true) {
+  ICYPUFF_LOG_DEBUG("Appending after {} existing blobs",
+                    written_blobs_metadata_.size());
 }
 
 Result<std::unique_ptr<BlobMetadata>> IcypuffWriter::write_blob(
@@ -40,16 +126,141 @@ Result<std::unique_ptr<BlobMetadata>> IcypuffWriter::write_blob(
     const std::vector<int>& fields, int64_t snapshot_id,
     int64_t sequence_number, std::optional<CompressionCodec> compression,
     const std::unordered_map<std::string, std::string>& properties) {
-  spdlog::debug("Writing blob of type: {} with length: {}", type, length);
+  ICYPUFF_LOG_DEBUG("Writing blob of type: {} with length: {}", type, length);
+  internal::LatencyTimer latency(LatencyOp::kWriteBlob);
 
   if (finished_) {
-    spdlog::error("Cannot write blob, writer is already finished");
+    ICYPUFF_LOG_ERROR("Cannot write blob, writer is already finished");
     return {ErrorCode::kInvalidState, "Writer is already finished"};
   }
 
-  if (!output_stream_) {
-    spdlog::error("Cannot write blob, writer is not initialized");
-    return {ErrorCode::kStreamNotInitialized, "Writer is not initialized"};
+  auto compressed = compress_blob(data, length, type, compression);
+  if (!compressed.ok()) {
+    return {compressed.error().code, compressed.error().message};
+  }
+  const CompressedBlob& blob = compressed.value();
+  if (blob.properties.empty()) {
+    return append_blob(blob.data.data(), blob.data.size(), blob.codec, type,
+                       fields, snapshot_id, sequence_number, properties);
+  }
+  auto blob_properties = properties;
+  blob_properties.insert(blob.properties.begin(), blob.properties.end());
+  return append_blob(blob.data.data(), blob.data.size(), blob.codec, type,
+                     fields, snapshot_id, sequence_number, blob_properties);
+}
+
+Result<CompressedBlob> IcypuffWriter::compress_blob(
+    const uint8_t* data, size_t length, const std::string& type,
+    std::optional<CompressionCodec> compression) const {
+  // Use the provided compression codec or fall back to default
+  CompressionCodec codec = compression.has_value()
+                               ? compression.value()
+                               : select_codec(data, length, type);
+
+  // Blobs of a type with a registered dictionary are compressed with it
+  const ZstdCompressionDictionary* dictionary = nullptr;
+  if (codec == CompressionCodec::Zstd) {
+    auto dict_it = zstd_dictionaries_.find(type);
+    if (dict_it != zstd_dictionaries_.end()) {
+      dictionary = dict_it->second.get();
+    }
+  }
+
+  // Compress the data if needed
+  int64_t compress_start = internal::NowNanos();
+  auto compressed_data = [&]() {
+    ICYPUFF_TRACE_SPAN(compress_span, SpanKind::kCompress);
+    auto result = compress_data(data, length, codec, dictionary);
+    if (result.ok()) {
+      ICYPUFF_TRACE_DONE(compress_span, length);
+    }
+    return result;
+  }();
+  if (!compressed_data.ok()) {
+    return {compressed_data.error().code, compressed_data.error().message};
+  }
+  stats_.compression[static_cast<size_t>(codec)].record(
+      static_cast<int64_t>(length),
+      static_cast<int64_t>(compressed_data.value().size()),
+      internal::NowNanos() - compress_start);
+
+  CompressedBlob blob;
+  blob.data = std::move(compressed_data).value();
+  blob.codec = codec;
+  if (dictionary) {
+    blob.properties[std::string(ZSTD_DICTIONARY_ID_PROPERTY)] =
+        std::to_string(dictionary->id());
+  }
+  return blob;
+}
+
+Result<std::unique_ptr<BlobMetadata>> IcypuffWriter::write_blob_precompressed(
+    const uint8_t* data, size_t length, CompressionCodec codec,
+    const std::string& type, const std::vector<int>& fields,
+    int64_t snapshot_id, int64_t sequence_number,
+    const std::unordered_map<std::string, std::string>& properties) {
+  ICYPUFF_LOG_DEBUG("Writing precompressed blob of type: {} with length: {}",
+                    type, length);
+  internal::LatencyTimer latency(LatencyOp::kWriteBlob);
+
+  if (finished_) {
+    ICYPUFF_LOG_ERROR("Cannot write blob, writer is already finished");
+    return {ErrorCode::kInvalidState, "Writer is already finished"};
+  }
+
+  // Only the frame header is checked, the payload is written as is. Puffin
+  // requires frames to record the uncompressed size.
+  switch (codec) {
+    case CompressionCodec::None:
+      break;
+    case CompressionCodec::Lz4: {
+      if (length < LZ4F_HEADER_SIZE_MIN ||
+          read_integer_little_endian(data, 0) != LZ4F_MAGICNUMBER) {
+        return {ErrorCode::kInvalidArgument, "Data is not an LZ4 frame"};
+      }
+      // FLG byte, bit 3 is the content size flag. LZ4F stores a content
+      // size of 0 as unknown, so empty frames have no size: accept them
+      // when the end mark directly follows the header, then only the
+      // content checksum (FLG bit 2) may follow.
+      if ((data[4] & 0x08) == 0) {
+        size_t header_size = LZ4F_HEADER_SIZE_MIN + ((data[4] & 0x01) ? 4 : 0);
+        size_t empty_size = header_size + 4 + ((data[4] & 0x04) ? 4 : 0);
+        if (length != empty_size ||
+            read_integer_little_endian(data, static_cast<int>(header_size)) !=
+                0) {
+          return {ErrorCode::kInvalidArgument,
+                  "LZ4 frame does not record its content size"};
+        }
+      }
+      break;
+    }
+    case CompressionCodec::Zstd: {
+      unsigned long long content_size = ZSTD_getFrameContentSize(data, length);
+      if (content_size == ZSTD_CONTENTSIZE_ERROR) {
+        return {ErrorCode::kInvalidArgument, "Data is not a Zstd frame"};
+      }
+      if (content_size == ZSTD_CONTENTSIZE_UNKNOWN) {
+        return {ErrorCode::kInvalidArgument,
+                "Zstd frame does not record its content size"};
+      }
+      break;
+    }
+  }
+
+  return append_blob(data, length, codec, type, fields, snapshot_id,
+                     sequence_number, properties);
+}
+
+Result<std::unique_ptr<BlobMetadata>> IcypuffWriter::append_blob(
+    const uint8_t* data, size_t length, CompressionCodec codec,
+    const std::string& type, const std::vector<int>& fields,
+    int64_t snapshot_id, int64_t sequence_number,
+    const std::unordered_map<std::string, std::string>& properties) {
+  ICYPUFF_TRACE_SPAN(write_span, SpanKind::kBlobWrite);
+  auto stream_result = open_stream_if_needed();
+  if (!stream_result.ok()) {
+    ICYPUFF_LOG_ERROR("Cannot write blob, writer is not initialized");
+    return {stream_result.error().code, stream_result.error().message};
   }
 
   auto header_result = write_header_if_needed();
@@ -63,18 +274,7 @@ Result<std::unique_ptr<BlobMetadata>> IcypuffWriter::write_blob(
   }
   int64_t offset = pos_result.value();
 
-  // Use the provided compression codec or fall back to default
-  CompressionCodec codec = compression.value_or(default_blob_compression_);
-
-  // Compress the data if needed
-  auto compressed_data = compress_data(data, length, codec);
-  if (!compressed_data.ok()) {
-    return {compressed_data.error().code, compressed_data.error().message};
-  }
-
-  // Write the compressed data
-  auto write_result = output_stream_->write(compressed_data.value().data(),
-                                            compressed_data.value().size());
+  auto write_result = output_stream_->write(data, length);
   if (!write_result.ok()) {
     return {write_result.error().code, write_result.error().message};
   }
@@ -86,7 +286,7 @@ Result<std::unique_ptr<BlobMetadata>> IcypuffWriter::write_blob(
   params.snapshot_id = snapshot_id;
   params.sequence_number = sequence_number;
   params.offset = offset;
-  params.length = compressed_data.value().size();
+  params.length = static_cast<int64_t>(length);
   params.compression_codec = GetCodecName(codec);
   params.properties = properties;
 
@@ -96,9 +296,204 @@ Result<std::unique_ptr<BlobMetadata>> IcypuffWriter::write_blob(
   }
 
   written_blobs_metadata_.push_back(std::move(metadata).value());
+  stats_.blobs_written.fetch_add(1, kRelaxed);
+  ICYPUFF_TRACE_DONE(write_span, length);
   return BlobMetadata::Create(params);
 }
 
+Result<std::vector<std::unique_ptr<BlobMetadata>>> IcypuffWriter::copy_blobs(
+    const InputFile& source, const std::vector<const BlobMetadata*>& blobs) {
+  ICYPUFF_LOG_DEBUG("Copying {} blobs from {}", blobs.size(),
+                    source.location());
+
+  if (finished_) {
+    return {ErrorCode::kInvalidState, "Writer is already finished"};
+  }
+  auto stream_result = open_stream_if_needed();
+  if (!stream_result.ok()) {
+    return {stream_result.error().code, stream_result.error().message};
+  }
+
+  auto header_result = write_header_if_needed();
+  if (!header_result.ok()) {
+    return {header_result.error().code, header_result.error().message};
+  }
+
+  auto pos_result = output_stream_->position();
+  if (!pos_result.ok()) {
+    return {pos_result.error().code, pos_result.error().message};
+  }
+  int64_t position = pos_result.value();
+
+  std::vector<std::unique_ptr<BlobMetadata>> copies;
+  copies.reserve(blobs.size());
+  size_t run_start = 0;
+  while (run_start < blobs.size()) {
+    // Extend the run while the next blob starts where the previous one ends
+    int64_t run_offset = blobs[run_start]->offset();
+    int64_t run_length = blobs[run_start]->length();
+    size_t run_end = run_start + 1;
+    while (run_end < blobs.size() &&
+           blobs[run_end]->offset() == run_offset + run_length) {
+      run_length += blobs[run_end]->length();
+      run_end++;
+    }
+
+    auto copy_result = copy_range(source, run_offset, run_length);
+    if (!copy_result.ok()) {
+      return {copy_result.error().code, copy_result.error().message};
+    }
+
+    for (size_t i = run_start; i < run_end; i++) {
+      const BlobMetadata& blob = *blobs[i];
+      BlobMetadataParams params;
+      params.type = blob.type();
+      params.input_fields = blob.input_fields();
+      params.snapshot_id = blob.snapshot_id();
+      params.sequence_number = blob.sequence_number();
+      params.offset = position + (blob.offset() - run_offset);
+      params.length = blob.length();
+      params.compression_codec = blob.compression_codec();
+      params.properties = blob.properties();
+
+      auto metadata = BlobMetadata::Create(params);
+      if (!metadata.ok()) {
+        return {metadata.error().code, metadata.error().message};
+      }
+      written_blobs_metadata_.push_back(std::move(metadata).value());
+      stats_.blobs_written.fetch_add(1, kRelaxed);
+
+      auto copy = BlobMetadata::Create(params);
+      if (!copy.ok()) {
+        return {copy.error().code, copy.error().message};
+      }
+      copies.push_back(std::move(copy).value());
+    }
+
+    position += run_length;
+    run_start = run_end;
+  }
+
+  return copies;
+}
+
+Result<void> IcypuffWriter::copy_range(const InputFile& source,
+                                       int64_t offset, int64_t length) {
+  ICYPUFF_TRACE_SPAN(write_span, SpanKind::kBlobWrite);
+  auto transfer_result = output_stream_->transfer_from(source, offset, length);
+  if (transfer_result.ok()) {
+    ICYPUFF_TRACE_DONE(write_span, length);
+    return transfer_result;
+  }
+  if (transfer_result.error().code != ErrorCode::kUnimplemented) {
+    return transfer_result;
+  }
+
+  // No zero-copy path between these files, copy through a bounded buffer
+  auto stream_result = source.new_stream();
+  if (!stream_result.ok()) {
+    return {stream_result.error().code, stream_result.error().message};
+  }
+  auto stream = std::move(stream_result).value();
+  auto seek_result = stream->seek(offset);
+  if (!seek_result.ok()) {
+    return seek_result;
+  }
+
+  std::vector<uint8_t> buffer(
+      static_cast<size_t>(std::min<int64_t>(length, COPY_BUFFER_SIZE)));
+  int64_t remaining = length;
+  while (remaining > 0) {
+    size_t chunk =
+        static_cast<size_t>(std::min<int64_t>(remaining, buffer.size()));
+    auto read_result = stream->read(buffer.data(), chunk);
+    if (!read_result.ok()) {
+      return {read_result.error().code, read_result.error().message};
+    }
+    if (read_result.value() == 0) {
+      return {ErrorCode::kIncompleteRead, "Source file ended early"};
+    }
+    auto write_result =
+        output_stream_->write(buffer.data(), read_result.value());
+    if (!write_result.ok()) {
+      return write_result;
+    }
+    remaining -= static_cast<int64_t>(read_result.value());
+  }
+  ICYPUFF_TRACE_DONE(write_span, length);
+  return stream->close();
+}
+
+Result<std::unique_ptr<BlobMetadata>> IcypuffWriter::train_zstd_dictionary(
+    const std::string& type, const std::vector<std::vector<uint8_t>>& samples,
+    const std::vector<int>& fields, size_t capacity) {
+  ICYPUFF_LOG_DEBUG("Training Zstd dictionary for type: {} from {} samples",
+                    type, samples.size());
+
+  auto dictionary = TrainZstdDictionary(samples, capacity);
+  if (!dictionary.ok()) {
+    return {dictionary.error().code, dictionary.error().message};
+  }
+
+  return add_zstd_dictionary(type, dictionary.value(), fields);
+}
+
+Result<std::unique_ptr<BlobMetadata>> IcypuffWriter::add_zstd_dictionary(
+    const std::string& type, const std::vector<uint8_t>& dictionary,
+    const std::vector<int>& fields) {
+  if (type == ZSTD_DICTIONARY_BLOB_TYPE) {
+    return {ErrorCode::kInvalidArgument,
+            "Cannot register a dictionary for dictionary blobs"};
+  }
+  if (zstd_dictionaries_.contains(type)) {
+    return {ErrorCode::kInvalidState,
+            "Zstd dictionary already registered for type"};
+  }
+
+  auto cdict = ZstdCompressionDictionary::Create(
+      dictionary, DEFAULT_ZSTD_COMPRESSION_LEVEL);
+  if (!cdict.ok()) {
+    return {cdict.error().code, cdict.error().message};
+  }
+  auto compression_dictionary = std::move(cdict).value();
+
+  // The dictionary blob is stored uncompressed so it can be loaded directly
+  auto dictionary_blob = write_blob(
+      dictionary.data(), dictionary.size(),
+      std::string(ZSTD_DICTIONARY_BLOB_TYPE), fields, 0, 0,
+      CompressionCodec::None,
+      {{std::string(ZSTD_DICTIONARY_ID_PROPERTY),
+        std::to_string(compression_dictionary->id())}});
+  if (!dictionary_blob.ok()) {
+    return dictionary_blob;
+  }
+
+  ICYPUFF_LOG_DEBUG("Registered Zstd dictionary {} for type: {}",
+                    compression_dictionary->id(), type);
+  zstd_dictionaries_.emplace(type, std::move(compression_dictionary));
+  return dictionary_blob;
+}
+
+CompressionCodec IcypuffWriter::select_codec(const uint8_t* data,
+                                             size_t length,
+                                             const std::string& type) const {
+  if (!compression_policy_) {
+    return default_blob_compression_;
+  }
+
+  // Dictionary-compressed types are small by design; sampling them without
+  // the dictionary would underestimate their gain
+  if (zstd_dictionaries_.contains(type)) {
+    return CompressionCodec::Zstd;
+  }
+
+  CompressionCodec codec =
+      SelectCompressionCodec(*compression_policy_, data, length);
+  ICYPUFF_LOG_DEBUG("Adaptive compression selected {} for blob of type: {}",
+                    GetCodecName(codec).value_or("none"), type);
+  return codec;
+}
+
 Result<int64_t> IcypuffWriter::file_size() const {
   if (!file_size_) {
     return {ErrorCode::kInvalidArgument,
@@ -120,17 +515,41 @@ IcypuffWriter::written_blobs_metadata() const {
   return written_blobs_metadata_;
 }
 
+AsyncResult<Result<std::unique_ptr<BlobMetadata>>>
+IcypuffWriter::write_blob_async(
+    Executor& executor, const uint8_t* data, size_t length, std::string type,
+    std::vector<int> fields, int64_t snapshot_id, int64_t sequence_number,
+    std::optional<CompressionCodec> compression,
+    std::unordered_map<std::string, std::string> properties) {
+  // The blob description is moved into the operation, only the data is
+  // borrowed
+  return {executor,
+          [this, data, length, type = std::move(type),
+           fields = std::move(fields), snapshot_id, sequence_number,
+           compression, properties = std::move(properties)]() {
+            return write_blob(data, length, type, fields, snapshot_id,
+                              sequence_number, compression, properties);
+          }};
+}
+
+AsyncResult<Result<void>> IcypuffWriter::close_async(Executor& executor) {
+  return {executor, [this]() { return close(); }};
+}
+
 Result<void> IcypuffWriter::close() {
-  spdlog::debug("Closing writer");
+  ICYPUFF_LOG_DEBUG("Closing writer");
+  internal::LatencyTimer latency(LatencyOp::kClose);
+  ICYPUFF_TRACE_SPAN(close_span, SpanKind::kClose);
 
   if (finished_) {
-    spdlog::debug("Writer already finished");
+    ICYPUFF_LOG_DEBUG("Writer already finished");
     return Result<void>();
   }
 
-  if (!output_stream_) {
-    spdlog::error("Cannot close writer, stream not initialized");
-    return {ErrorCode::kStreamNotInitialized, "Writer is not initialized"};
+  auto stream_result = open_stream_if_needed();
+  if (!stream_result.ok()) {
+    ICYPUFF_LOG_ERROR("Cannot close writer, stream not initialized");
+    return stream_result;
   }
 
   auto header_result = write_header_if_needed();
@@ -138,6 +557,13 @@ Result<void> IcypuffWriter::close() {
     return header_result;
   }
 
+  if (write_blob_index_) {
+    auto index_result = write_blob_index();
+    if (!index_result.ok()) {
+      return index_result;
+    }
+  }
+
   auto pos_result = output_stream_->position();
   if (!pos_result.ok()) {
     return {pos_result.error().code, pos_result.error().message};
@@ -164,7 +590,30 @@ Result<void> IcypuffWriter::close() {
   }
 
   output_stream_.reset();
-  spdlog::debug("Writer closed successfully");
+  ICYPUFF_TRACE_DONE(close_span, *footer_size_);
+  ICYPUFF_LOG_DEBUG("Writer closed successfully");
+  return Result<void>();
+}
+
+Result<void> IcypuffWriter::open_stream_if_needed() {
+  if (output_stream_) {
+    return Result<void>();
+  }
+  if (!append_offset_) {
+    return {ErrorCode::kStreamNotInitialized, "Writer is not initialized"};
+  }
+
+  // Only the footer and a trailing index are truncated, existing blob bytes
+  // stay in place
+  auto stream_result = output_file_->append_at(*append_offset_);
+  if (!stream_result.ok()) {
+    ICYPUFF_LOG_ERROR("Failed to open file for appending: {}",
+                      stream_result.error().message);
+    return {stream_result.error().code, stream_result.error().message};
+  }
+  append_offset_.reset();
+  output_stream_ = std::make_unique<CountingOutputStream>(
+      std::move(stream_result).value(), stats_);
   return Result<void>();
 }
 
@@ -182,6 +631,33 @@ Result<void> IcypuffWriter::write_header_if_needed() {
   return Result<void>();
 }
 
+Result<void> IcypuffWriter::write_blob_index() {
+  auto pos_result = output_stream_->position();
+  if (!pos_result.ok()) {
+    return {pos_result.error().code, pos_result.error().message};
+  }
+
+  // Files with blobs of unknown codecs, e.g. appended to files of other
+  // writers, stay readable through the JSON footer
+  auto index = EncodeBlobIndex(written_blobs_metadata_, properties_,
+                               pos_result.value());
+  if (!index.ok()) {
+    ICYPUFF_LOG_WARN("Writing the file without a blob index: {}",
+                     index.error().message);
+    return Result<void>();
+  }
+
+  auto blob_result = append_blob(
+      index.value().data(), index.value().size(), CompressionCodec::None,
+      std::string(BLOB_INDEX_BLOB_TYPE),
+      BlobIndexFields(written_blobs_metadata_), BLOB_INDEX_SNAPSHOT_ID,
+      BLOB_INDEX_SEQUENCE_NUMBER, {});
+  if (!blob_result.ok()) {
+    return {blob_result.error().code, blob_result.error().message};
+  }
+  return Result<void>();
+}
+
 Result<void> IcypuffWriter::write_footer() {
   // Write start magic
   auto write_result = output_stream_->write(MAGIC, MAGIC_LENGTH);
@@ -189,42 +665,45 @@ Result<void> IcypuffWriter::write_footer() {
     return write_result;
   }
 
-  // Create file metadata
-  FileMetadataParams params;
-  params.blobs = std::move(written_blobs_metadata_);
-  params.properties = properties_;
-
-  auto metadata = FileMetadata::Create(std::move(params));
-  if (!metadata.ok()) {
-    return {metadata.error().code, metadata.error().message};
-  }
-
-  // Convert metadata to JSON and compress if needed
-  auto json_result = FileMetadataParser::ToJson(*metadata.value());
-  if (!json_result.ok()) {
-    return {json_result.error().code, json_result.error().message};
-  }
+  // Serialize the footer straight from the written blobs. Uncompressed
+  // footers are streamed to the output without materializing the payload.
+  int64_t payload_size = 0;
+  if (footer_compression_ == CompressionCodec::None) {
+    auto json_result = FileMetadataParser::WriteJson(
+        written_blobs_metadata_, properties_, *output_stream_);
+    if (!json_result.ok()) {
+      return {json_result.error().code, json_result.error().message};
+    }
+    payload_size = json_result.value();
+  } else {
+    std::string json_str;
+    auto json_result = FileMetadataParser::AppendJson(written_blobs_metadata_,
+                                                      properties_, json_str);
+    if (!json_result.ok()) {
+      return json_result;
+    }
 
-  std::string json_str = std::move(json_result).value();
-  auto compressed_json =
-      compress_data(reinterpret_cast<const uint8_t*>(json_str.data()),
-                    json_str.size(), footer_compression_);
-  if (!compressed_json.ok()) {
-    return {compressed_json.error().code, compressed_json.error().message};
-  }
+    auto compressed_json =
+        compress_data(reinterpret_cast<const uint8_t*>(json_str.data()),
+                      json_str.size(), footer_compression_);
+    if (!compressed_json.ok()) {
+      return {compressed_json.error().code, compressed_json.error().message};
+    }
 
-  // Write compressed JSON
-  write_result = output_stream_->write(compressed_json.value().data(),
-                                       compressed_json.value().size());
-  if (!write_result.ok()) {
-    return write_result;
+    // Write compressed JSON
+    write_result = output_stream_->write(compressed_json.value().data(),
+                                         compressed_json.value().size());
+    if (!write_result.ok()) {
+      return write_result;
+    }
+    payload_size = static_cast<int64_t>(compressed_json.value().size());
   }
 
   // Write footer struct
   std::vector<uint8_t> footer_struct(FOOTER_STRUCT_LENGTH);
   write_integer_little_endian(footer_struct.data(),
                               FOOTER_STRUCT_PAYLOAD_SIZE_OFFSET,
-                              compressed_json.value().size());
+                              static_cast<uint32_t>(payload_size));
 
   // Write flags
   uint32_t flags = 0;
@@ -247,26 +726,62 @@ Result<void> IcypuffWriter::write_footer() {
   return Result<void>();
 }
 
+Result<void> IcypuffWriter::configure_large_blob_compression(
+    const ZstdContext& ctx) const {
+  size_t result = ZSTD_CCtx_setParameter(ctx.get(), ZSTD_c_nbWorkers,
+                                         zstd_large_blobs_.workers);
+  if (ZSTD_isError(result)) {
+    // libzstd built without multithreading support
+    ICYPUFF_LOG_WARN("ZSTD workers unavailable, compressing on one thread: {}",
+                     ZSTD_getErrorName(result));
+  } else if (zstd_large_blobs_.job_size > 0) {
+    result =
+        ZSTD_CCtx_setParameter(ctx.get(), ZSTD_c_jobSize,
+                               static_cast<int>(zstd_large_blobs_.job_size));
+    if (ZSTD_isError(result)) {
+      ICYPUFF_LOG_ERROR("Invalid ZSTD job size {}: {}",
+                        zstd_large_blobs_.job_size, ZSTD_getErrorName(result));
+      return {ErrorCode::kInvalidArgument, "Invalid ZSTD job size"};
+    }
+  }
+
+  if (zstd_large_blobs_.long_distance_matching) {
+    result =
+        ZSTD_CCtx_setParameter(ctx.get(), ZSTD_c_enableLongDistanceMatching, 1);
+    if (ZSTD_isError(result)) {
+      ICYPUFF_LOG_ERROR("Failed to enable ZSTD long distance matching: {}",
+                        ZSTD_getErrorName(result));
+      return {ErrorCode::kCompressionError,
+              "Failed to enable ZSTD long distance matching"};
+    }
+  }
+
+  return Result<void>();
+}
+
 Result<std::vector<uint8_t>> IcypuffWriter::compress_data(
-    const uint8_t* data, size_t length, CompressionCodec codec) {
+    const uint8_t* data, size_t length, CompressionCodec codec,
+    const ZstdCompressionDictionary* dictionary) const {
   switch (codec) {
     case CompressionCodec::None: {
       return std::vector<uint8_t>(data, data + length);
     }
 
     case CompressionCodec::Lz4: {
-      size_t max_dst_size = LZ4F_compressFrameBound(length, nullptr);
-      std::vector<uint8_t> compressed(max_dst_size);
-
       LZ4F_preferences_t prefs = LZ4F_INIT_PREFERENCES;
       prefs.frameInfo.contentSize = length;
       prefs.frameInfo.contentChecksumFlag = LZ4F_contentChecksumEnabled;
       prefs.frameInfo.blockChecksumFlag = LZ4F_blockChecksumEnabled;
 
+      // The bound must account for the checksums enabled above
+      size_t max_dst_size = LZ4F_compressFrameBound(length, &prefs);
+      std::vector<uint8_t> compressed(max_dst_size);
+
       size_t result = LZ4F_compressFrame(compressed.data(), max_dst_size, data,
                                          length, &prefs);
       if (LZ4F_isError(result)) {
-        spdlog::error("LZ4 compression failed: {}", LZ4F_getErrorName(result));
+        ICYPUFF_LOG_ERROR("LZ4 compression failed: {}",
+                          LZ4F_getErrorName(result));
         return {ErrorCode::kCompressionError, "LZ4 compression failed"};
       }
 
@@ -280,20 +795,38 @@ Result<std::vector<uint8_t>> IcypuffWriter::compress_data(
 
       ZstdContext ctx;
       if (!ctx.valid()) {
-        spdlog::error("Failed to create ZSTD context");
+        ICYPUFF_LOG_ERROR("Failed to create ZSTD context");
         return {ErrorCode::kCompressionError, "Failed to create ZSTD context"};
       }
 
       // Set compression parameters
-      ZSTD_CCtx_setParameter(ctx.get(), ZSTD_c_compressionLevel, 3);
+      ZSTD_CCtx_setParameter(ctx.get(), ZSTD_c_compressionLevel,
+                             DEFAULT_ZSTD_COMPRESSION_LEVEL);
       ZSTD_CCtx_setParameter(ctx.get(), ZSTD_c_checksumFlag, 1);
       ZSTD_CCtx_setParameter(ctx.get(), ZSTD_c_contentSizeFlag, 1);
+      if (zstd_large_blobs_.workers > 0 &&
+          static_cast<int64_t>(length) >= zstd_large_blobs_.min_blob_size) {
+        auto configured = configure_large_blob_compression(ctx);
+        if (!configured.ok()) {
+          return {configured.error().code, configured.error().message};
+        }
+      }
+      if (dictionary) {
+        size_t ref_result = ZSTD_CCtx_refCDict(ctx.get(), dictionary->get());
+        if (ZSTD_isError(ref_result)) {
+          ICYPUFF_LOG_ERROR("Failed to reference ZSTD dictionary: {}",
+                            ZSTD_getErrorName(ref_result));
+          return {ErrorCode::kCompressionError,
+                  "Failed to reference ZSTD dictionary"};
+        }
+      }
 
       size_t result = ZSTD_compress2(ctx.get(), compressed.data(), max_dst_size,
                                      data, length);
 
       if (ZSTD_isError(result)) {
-        spdlog::error("ZSTD compression failed: {}", ZSTD_getErrorName(result));
+        ICYPUFF_LOG_ERROR("ZSTD compression failed: {}",
+                          ZSTD_getErrorName(result));
         return {ErrorCode::kCompressionError, "ZSTD compression failed"};
       }
 
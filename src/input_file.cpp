@@ -0,0 +1,42 @@
+#include "icypuff/input_file.h"
+
+#include "icypuff/format_constants.h"
+
+namespace icypuff {
+
+Result<void> InputFile::read_fully(int64_t position, uint8_t* buffer,
+                                   size_t length) const {
+  auto stream_result = new_stream();
+  if (!stream_result.ok()) {
+    return {stream_result.error().code, stream_result.error().message};
+  }
+  auto& stream = *stream_result.value();
+
+  auto seek_result = stream.seek(position);
+  if (!seek_result.ok()) {
+    return {ErrorCode::kStreamSeekError, seek_result.error().message};
+  }
+
+  size_t total = 0;
+  while (total < length) {
+    auto read_result = stream.read(buffer + total, length - total);
+    if (!read_result.ok()) {
+      return {ErrorCode::kStreamReadError, read_result.error().message};
+    }
+    if (read_result.value() == 0) {
+      return {ErrorCode::kIncompleteRead, ERROR_INCOMPLETE_BLOB_READ};
+    }
+    total += read_result.value();
+  }
+  return Result<void>();
+}
+
+void InputFile::read_batch(std::span<const PositionalRead> reads,
+                           const ReadCompletion& on_complete) const {
+  for (size_t i = 0; i < reads.size(); i++) {
+    on_complete(i, read_fully(reads[i].position, reads[i].buffer,
+                              reads[i].length));
+  }
+}
+
+}  // namespace icypuff
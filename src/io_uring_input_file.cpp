@@ -0,0 +1,538 @@
+#include "icypuff/io_uring_input_file.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#if defined(ICYPUFF_HAVE_IO_URING)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "icypuff/format_constants.h"
+#include "icypuff/logging.h"
+
+namespace icypuff {
+
+namespace {
+
+// O_DIRECT offsets, lengths and buffers are aligned to this, which covers
+// the logical block size of common devices
+constexpr size_t DIRECT_IO_ALIGNMENT = 4096;
+
+// Largest submission queue requested from the kernel
+constexpr unsigned MAX_QUEUE_DEPTH = 4096;
+
+struct FreeDeleter {
+  void operator()(uint8_t* buffer) const { std::free(buffer); }
+};
+
+}  // namespace
+
+struct IoUringInputFile::ReadState {
+  // File range read into target. Direct reads widen the requested range
+  // to the alignment and read into a bounce buffer.
+  int64_t offset = 0;
+  uint8_t* target = nullptr;
+  size_t length = 0;
+  // Bytes at the start of the range that must be read to succeed, reads
+  // of aligned ranges may stop early at the end of the file
+  size_t needed = 0;
+  size_t done = 0;
+  bool complete = false;
+  std::unique_ptr<uint8_t, FreeDeleter> bounce;
+  // Where the requested bytes of a bounce buffer are copied
+  uint8_t* destination = nullptr;
+  size_t destination_offset = 0;
+  size_t destination_length = 0;
+#if defined(ICYPUFF_HAVE_IO_URING)
+  // Referenced by the in-flight request
+  iovec iov;
+#endif
+
+  Result<void> finish() {
+    if (done < needed) {
+      return {ErrorCode::kIncompleteRead, ERROR_INCOMPLETE_BLOB_READ};
+    }
+    if (bounce) {
+      std::memcpy(destination, bounce.get() + destination_offset,
+                  destination_length);
+    }
+    return Result<void>();
+  }
+};
+
+#if defined(ICYPUFF_HAVE_IO_URING)
+// Submission and completion queues of one io_uring instance, mapped from
+// the kernel. Used by one batch at a time.
+class IoUringInputFile::Ring {
+ public:
+  // Returns null when the kernel does not allow io_uring
+  static std::unique_ptr<Ring> Create(unsigned entries, int fail_after) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (fd < 0) {
+      ICYPUFF_LOG_DEBUG("io_uring is not available: {}", std::strerror(errno));
+      return nullptr;
+    }
+    std::unique_ptr<Ring> ring(new Ring(fd, fail_after));
+    if (!ring->map(params)) {
+      ICYPUFF_LOG_WARN("Failed to map io_uring queues: {}",
+                       std::strerror(errno));
+      return nullptr;
+    }
+    return ring;
+  }
+
+  ICYPUFF_DISALLOW_COPY_ASSIGN_AND_MOVE(Ring);
+
+  ~Ring() {
+    if (sqes_ != MAP_FAILED) {
+      munmap(sqes_, sqes_size_);
+    }
+    if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+      munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ != MAP_FAILED) {
+      munmap(sq_ring_, sq_ring_size_);
+    }
+    ::close(fd_);
+  }
+
+  // Reads that may be queued or in flight at once
+  unsigned capacity() const { return sq_entries_; }
+
+  // Reads queued but not yet handed to the kernel
+  unsigned unsubmitted() const { return unsubmitted_; }
+
+  // Queue a read of iov, submitted by the next submit_and_wait
+  void prepare_read(int fd, const iovec* iov, int64_t offset,
+                    uint64_t user_data) {
+    unsigned tail = *sq_tail_;
+    unsigned index = tail & *sq_mask_;
+    io_uring_sqe* sqe = &sqes_[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(iov);
+    sqe->len = 1;
+    sqe->off = static_cast<uint64_t>(offset);
+    sqe->user_data = user_data;
+    sq_array_[index] = index;
+    std::atomic_ref<unsigned>(*sq_tail_).store(tail + 1,
+                                               std::memory_order_release);
+    unsubmitted_++;
+  }
+
+  // Submit queued reads and wait for at least one completion. Returns 0 or
+  // a negated errno.
+  int submit_and_wait() {
+    if (fail_after_ == 0) {
+      // Hands the reads to the kernel before failing, so they are in
+      // flight when the caller gives up on the ring
+      long submitted =
+          syscall(__NR_io_uring_enter, fd_, unsubmitted_, 0, 0, nullptr, 0);
+      unsubmitted_ -= submitted > 0 ? static_cast<unsigned>(submitted) : 0;
+      return -EIO;
+    }
+    if (fail_after_ > 0) {
+      fail_after_--;
+    }
+    long submitted = syscall(__NR_io_uring_enter, fd_, unsubmitted_, 1,
+                             IORING_ENTER_GETEVENTS, nullptr, 0);
+    if (submitted < 0) {
+      return -errno;
+    }
+    unsubmitted_ -= static_cast<unsigned>(submitted);
+    return 0;
+  }
+
+  // Wait for a completion without submitting. Returns 0 or a negated
+  // errno.
+  int wait() {
+    if (syscall(__NR_io_uring_enter, fd_, 0, 1, IORING_ENTER_GETEVENTS,
+                nullptr, 0) < 0) {
+      return -errno;
+    }
+    return 0;
+  }
+
+  // Calls fn(user_data, result) for every completion available
+  template <typename Fn>
+  void reap(Fn&& fn) {
+    unsigned head = *cq_head_;
+    unsigned tail =
+        std::atomic_ref<unsigned>(*cq_tail_).load(std::memory_order_acquire);
+    for (; head != tail; head++) {
+      const io_uring_cqe& cqe = cqes_[head & *cq_mask_];
+      fn(cqe.user_data, cqe.res);
+    }
+    std::atomic_ref<unsigned>(*cq_head_).store(head,
+                                               std::memory_order_release);
+  }
+
+ private:
+  Ring(int fd, int fail_after) : fd_(fd), fail_after_(fail_after) {}
+
+  bool map(const io_uring_params& params) {
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ =
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+      sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+      return false;
+    }
+    cq_ring_ = single_mmap
+                   ? sq_ring_
+                   : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      return false;
+    }
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+      return false;
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    auto* sq = static_cast<uint8_t*>(sq_ring_);
+    sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    sq_entries_ = params.sq_entries;
+    auto* cq = static_cast<uint8_t*>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+  }
+
+  int fd_;
+  void* sq_ring_ = MAP_FAILED;
+  size_t sq_ring_size_ = 0;
+  void* cq_ring_ = MAP_FAILED;
+  size_t cq_ring_size_ = 0;
+  io_uring_sqe* sqes_ = static_cast<io_uring_sqe*>(MAP_FAILED);
+  size_t sqes_size_ = 0;
+  unsigned* sq_head_ = nullptr;
+  unsigned* sq_tail_ = nullptr;
+  unsigned* sq_mask_ = nullptr;
+  unsigned* sq_array_ = nullptr;
+  unsigned sq_entries_ = 0;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned* cq_mask_ = nullptr;
+  io_uring_cqe* cqes_ = nullptr;
+  unsigned unsubmitted_ = 0;
+  // Submissions left before they fail, negative for no limit
+  int fail_after_;
+};
+#else
+class IoUringInputFile::Ring {
+ public:
+  static std::unique_ptr<Ring> Create(unsigned, int) { return nullptr; }
+};
+#endif
+
+Result<std::unique_ptr<IoUringInputFile>> IoUringInputFile::Create(
+    const std::filesystem::path& path, IoUringInputFileParams params) {
+  std::unique_ptr<IoUringInputFile> file(new IoUringInputFile(path, params));
+#if defined(_WIN32)
+  return {ErrorCode::kUnimplemented, "io_uring files need a POSIX system"};
+#else
+  std::string location = file->location();
+#if defined(O_DIRECT)
+  if (params.direct_io) {
+    file->fd_ = ::open(location.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT);
+    if (file->fd_ >= 0) {
+      file->direct_io_ = true;
+    } else {
+      ICYPUFF_LOG_WARN("O_DIRECT is not supported for {}, using buffered reads",
+                       location);
+    }
+  }
+#endif
+  if (file->fd_ < 0) {
+    file->fd_ = ::open(location.c_str(), O_RDONLY | O_CLOEXEC);
+  }
+  if (file->fd_ < 0) {
+    return {ErrorCode::kInvalidArgument, "Failed to open file"};
+  }
+
+  if (!params.disable_io_uring) {
+    auto ring = Ring::Create(std::clamp(params.queue_depth, 1u,
+                                        MAX_QUEUE_DEPTH),
+                             params.fail_submissions_after);
+    if (ring) {
+      file->io_uring_available_ = true;
+      file->idle_rings_.push_back(std::move(ring));
+    }
+  }
+  ICYPUFF_LOG_DEBUG("Opened {} for {} reads{}", location,
+                    file->io_uring_available_ ? "io_uring" : "pread",
+                    file->direct_io_ ? " with O_DIRECT" : "");
+  return file;
+#endif
+}
+
+IoUringInputFile::IoUringInputFile(const std::filesystem::path& path,
+                                   IoUringInputFileParams params)
+    : local_(path), params_(params) {}
+
+IoUringInputFile::~IoUringInputFile() {
+#if !defined(_WIN32)
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+#endif
+}
+
+Result<int64_t> IoUringInputFile::length() const { return local_.length(); }
+
+Result<std::unique_ptr<SeekableInputStream>> IoUringInputFile::new_stream()
+    const {
+  return local_.new_stream();
+}
+
+Result<void> IoUringInputFile::read_fully(int64_t position, uint8_t* buffer,
+                                          size_t length) const {
+  PositionalRead read{position, buffer, length};
+  Result<void> result;
+  read_batch({&read, 1},
+             [&](size_t, Result<void> read_result) { result = read_result; });
+  return result;
+}
+
+void IoUringInputFile::read_batch(std::span<const PositionalRead> reads,
+                                  const ReadCompletion& on_complete) const {
+#if defined(_WIN32)
+  local_.read_batch(reads, on_complete);
+#else
+  std::vector<ReadState> states(reads.size());
+  for (size_t i = 0; i < reads.size(); i++) {
+    const PositionalRead& read = reads[i];
+    ReadState& state = states[i];
+    if (read.position < 0) {
+      state.complete = true;
+      on_complete(i, {ErrorCode::kStreamSeekError,
+                      "Read position is negative"});
+      continue;
+    }
+    if (!direct_io_) {
+      state.offset = read.position;
+      state.target = read.buffer;
+      state.length = state.needed = read.length;
+      continue;
+    }
+
+    int64_t start = read.position & ~int64_t{DIRECT_IO_ALIGNMENT - 1};
+    int64_t end = read.position + static_cast<int64_t>(read.length);
+    int64_t aligned_end = (end + DIRECT_IO_ALIGNMENT - 1) &
+                          ~int64_t{DIRECT_IO_ALIGNMENT - 1};
+    state.offset = start;
+    state.length = static_cast<size_t>(aligned_end - start);
+    state.needed = static_cast<size_t>(end - start);
+    state.bounce.reset(static_cast<uint8_t*>(
+        std::aligned_alloc(DIRECT_IO_ALIGNMENT, std::max<size_t>(
+                                                    state.length, 1))));
+    if (!state.bounce) {
+      state.complete = true;
+      on_complete(i, {ErrorCode::kInternalError,
+                      "Failed to allocate a read buffer"});
+      continue;
+    }
+    state.target = state.bounce.get();
+    state.destination = read.buffer;
+    state.destination_offset = static_cast<size_t>(read.position - start);
+    state.destination_length = read.length;
+  }
+
+  auto ring = io_uring_available_ ? acquire_ring() : nullptr;
+  if (ring) {
+    // A failed ring may hold stale submissions and completions, so it is
+    // destroyed rather than pooled
+    if (read_with_ring(*ring, states, on_complete)) {
+      release_ring(std::move(ring));
+    }
+  } else {
+    read_with_pread(states, on_complete);
+  }
+#endif
+}
+
+std::unique_ptr<IoUringInputFile::Ring> IoUringInputFile::acquire_ring()
+    const {
+  {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    if (!idle_rings_.empty()) {
+      auto ring = std::move(idle_rings_.back());
+      idle_rings_.pop_back();
+      return ring;
+    }
+  }
+  // Batches running at once each get their own ring
+  return Ring::Create(std::clamp(params_.queue_depth, 1u, MAX_QUEUE_DEPTH),
+                      params_.fail_submissions_after);
+}
+
+void IoUringInputFile::release_ring(std::unique_ptr<Ring> ring) const {
+  std::lock_guard<std::mutex> lock(rings_mutex_);
+  idle_rings_.push_back(std::move(ring));
+}
+
+bool IoUringInputFile::read_with_ring(Ring& ring,
+                                      std::vector<ReadState>& states,
+                                      const ReadCompletion& on_complete) const {
+#if defined(ICYPUFF_HAVE_IO_URING)
+  size_t remaining = 0;
+  for (const auto& state : states) {
+    remaining += state.complete ? 0 : 1;
+  }
+  auto complete = [&](size_t i, Result<void> result) {
+    states[i].complete = true;
+    remaining--;
+    on_complete(i, result);
+  };
+
+  size_t next = 0;
+  unsigned in_flight = 0;
+  // Interrupted and short reads, resubmitted for the rest of their range
+  std::vector<size_t> retry;
+  auto queue = [&](size_t i) {
+    ReadState& state = states[i];
+    state.iov.iov_base = state.target + state.done;
+    state.iov.iov_len = state.length - state.done;
+    ring.prepare_read(fd_, &state.iov,
+                      state.offset + static_cast<int64_t>(state.done), i);
+    in_flight++;
+  };
+
+  while (remaining > 0) {
+    while (in_flight < ring.capacity()) {
+      if (!retry.empty()) {
+        queue(retry.back());
+        retry.pop_back();
+        continue;
+      }
+      while (next < states.size() && states[next].complete) {
+        next++;
+      }
+      if (next == states.size()) {
+        break;
+      }
+      if (states[next].length == 0) {
+        complete(next++, Result<void>());
+        continue;
+      }
+      queue(next++);
+    }
+    if (in_flight == 0) {
+      break;
+    }
+
+    int error = ring.submit_and_wait();
+    if (error != 0 && error != -EINTR && error != -EAGAIN &&
+        error != -EBUSY) {
+      // The kernel writes into the buffers of submitted reads until they
+      // complete, so every one is reaped before the batch falls back to
+      // pread. Completions reach the queue without a system call, so a
+      // failing wait only costs spinning.
+      ICYPUFF_LOG_WARN("io_uring submission failed: {}", std::strerror(-error));
+      unsigned submitted = in_flight - ring.unsubmitted();
+      while (submitted > 0) {
+        ring.reap([&](uint64_t, int) { submitted--; });
+        if (submitted > 0 && ring.wait() != 0) {
+          std::this_thread::yield();
+        }
+      }
+      for (auto& state : states) {
+        state.done = state.complete ? state.done : 0;
+      }
+      read_with_pread(states, on_complete);
+      return false;
+    }
+
+    ring.reap([&](uint64_t user_data, int result) {
+      in_flight--;
+      size_t i = static_cast<size_t>(user_data);
+      ReadState& state = states[i];
+      if (result == -EINTR || result == -EAGAIN) {
+        retry.push_back(i);
+      } else if (result < 0) {
+        complete(i, {ErrorCode::kStreamReadError, "Failed to read from file"});
+      } else {
+        state.done += static_cast<size_t>(result);
+        if (result == 0 || state.done >= state.needed) {
+          complete(i, state.finish());
+        } else {
+          retry.push_back(i);
+        }
+      }
+    });
+  }
+  return true;
+#else
+  read_with_pread(states, on_complete);
+  return true;
+#endif
+}
+
+void IoUringInputFile::read_with_pread(
+    std::vector<ReadState>& states, const ReadCompletion& on_complete) const {
+#if !defined(_WIN32)
+  for (size_t i = 0; i < states.size(); i++) {
+    ReadState& state = states[i];
+    if (state.complete) {
+      continue;
+    }
+    bool failed = false;
+    while (state.done < state.length) {
+      ssize_t n = ::pread(fd_, state.target + state.done,
+                          state.length - state.done,
+                          static_cast<off_t>(state.offset + state.done));
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        failed = true;
+        break;
+      }
+      if (n == 0) {
+        break;
+      }
+      state.done += static_cast<size_t>(n);
+    }
+    state.complete = true;
+    if (failed) {
+      on_complete(i, {ErrorCode::kStreamReadError, "Failed to read from file"});
+    } else {
+      on_complete(i, state.finish());
+    }
+  }
+#endif
+}
+
+std::string IoUringInputFile::location() const { return local_.location(); }
+
+bool IoUringInputFile::exists() const { return local_.exists(); }
+
+}  // namespace icypuff
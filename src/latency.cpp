@@ -0,0 +1,205 @@
+#include "icypuff/latency.h"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cmath>
+
+#include "icypuff/stats.h"
+
+namespace icypuff {
+
+namespace {
+
+constexpr auto kRelaxed = std::memory_order_relaxed;
+
+constexpr const char* PROMETHEUS_METRIC = "icypuff_operation_latency_seconds";
+
+// Exported bucket range, 2^10ns to 2^34ns in histogram bucket indexes
+constexpr size_t PROMETHEUS_FIRST_BUCKET =
+    (10 - LatencyHistogram::kSubBucketBits + 1) *
+        LatencyHistogram::kSubBucketCount -
+    1;
+constexpr size_t PROMETHEUS_LAST_BUCKET =
+    (34 - LatencyHistogram::kSubBucketBits + 1) *
+        LatencyHistogram::kSubBucketCount -
+    1;
+// Export every other bucket, four per power of two
+constexpr size_t PROMETHEUS_BUCKET_STRIDE = 2;
+
+std::array<LatencyHistogram, LATENCY_OP_COUNT>& Histograms() {
+  static std::array<LatencyHistogram, LATENCY_OP_COUNT> histograms;
+  return histograms;
+}
+
+void AppendSeconds(std::string& out, int64_t nanos) {
+  char buffer[32];
+  auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer),
+                                 static_cast<double>(nanos) / 1e9);
+  out.append(buffer, ec == std::errc() ? end : buffer);
+}
+
+void AppendSample(std::string& out, std::string_view suffix,
+                  std::string_view op, std::string_view le, int64_t value) {
+  out.append(PROMETHEUS_METRIC);
+  out.append(suffix);
+  out.append("{op=\"");
+  out.append(op);
+  out.append("\"");
+  if (!le.empty()) {
+    out.append(",le=\"");
+    out.append(le);
+    out.append("\"");
+  }
+  out.append("} ");
+  out.append(std::to_string(value));
+  out.append("\n");
+}
+
+}  // namespace
+
+std::string_view GetLatencyOpName(LatencyOp op) {
+  switch (op) {
+    case LatencyOp::kReadFileMetadata:
+      return "read_file_metadata";
+    case LatencyOp::kReadBlobIo:
+      return "read_blob_io";
+    case LatencyOp::kReadBlobDecompress:
+      return "read_blob_decompress";
+    case LatencyOp::kWriteBlob:
+      return "write_blob";
+    case LatencyOp::kClose:
+      return "close";
+  }
+  return "unknown";
+}
+
+int64_t LatencySnapshot::percentile(double q) const {
+  if (count == 0) {
+    return 0;
+  }
+  // Rank of the quantile among the recorded values, 1-based
+  auto rank = static_cast<int64_t>(
+      std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(count)));
+  rank = std::max<int64_t>(rank, 1);
+  int64_t seen = 0;
+  for (size_t i = 0; i < bucket_counts.size(); i++) {
+    seen += bucket_counts[i];
+    if (seen >= rank) {
+      return LatencyHistogram::BucketUpperBound(i);
+    }
+  }
+  return LatencyHistogram::BucketUpperBound(bucket_counts.size() - 1);
+}
+
+size_t LatencyHistogram::BucketIndex(int64_t nanos) {
+  if (nanos < 2 * kSubBucketCount) {
+    return static_cast<size_t>(std::max<int64_t>(nanos, 0));
+  }
+  auto value = static_cast<uint64_t>(nanos);
+  int exponent = std::bit_width(value) - 1;
+  if (exponent >= kMaxExponent) {
+    return kBucketCount - 1;
+  }
+  int shift = exponent - kSubBucketBits;
+  return static_cast<size_t>(shift) * kSubBucketCount +
+         static_cast<size_t>(value >> shift);
+}
+
+int64_t LatencyHistogram::BucketUpperBound(size_t index) {
+  if (index < 2 * kSubBucketCount) {
+    return static_cast<int64_t>(index);
+  }
+  if (index >= kBucketCount - 1) {
+    return INT64_MAX;
+  }
+  int shift = static_cast<int>(index / kSubBucketCount) - 1;
+  auto sub_bucket = static_cast<int64_t>(index % kSubBucketCount) +
+                    kSubBucketCount;
+  return ((sub_bucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(int64_t nanos) {
+  buckets_[BucketIndex(nanos)].fetch_add(1, kRelaxed);
+  sum_nanos_.fetch_add(std::max<int64_t>(nanos, 0), kRelaxed);
+}
+
+LatencySnapshot LatencyHistogram::snapshot() const {
+  LatencySnapshot result;
+  result.bucket_counts.resize(kBucketCount);
+  for (size_t i = 0; i < kBucketCount; i++) {
+    result.bucket_counts[i] = buckets_[i].load(kRelaxed);
+    result.count += result.bucket_counts[i];
+  }
+  result.sum_nanos = sum_nanos_.load(kRelaxed);
+  return result;
+}
+
+void LatencyHistogram::reset() {
+  for (auto& bucket : buckets_) {
+    bucket.store(0, kRelaxed);
+  }
+  sum_nanos_.store(0, kRelaxed);
+}
+
+LatencyHistogram& GetLatencyHistogram(LatencyOp op) {
+  return Histograms()[static_cast<size_t>(op)];
+}
+
+void ResetLatencyHistograms() {
+  for (auto& histogram : Histograms()) {
+    histogram.reset();
+  }
+}
+
+std::string RenderLatencyPrometheus() {
+  std::string out;
+  out.append("# HELP ");
+  out.append(PROMETHEUS_METRIC);
+  out.append(" Latency of icypuff reader and writer operations.\n");
+  out.append("# TYPE ");
+  out.append(PROMETHEUS_METRIC);
+  out.append(" histogram\n");
+
+  std::string le;
+  for (size_t op = 0; op < LATENCY_OP_COUNT; op++) {
+    std::string_view name = GetLatencyOpName(static_cast<LatencyOp>(op));
+    // The count comes from the buckets so the exported series is consistent
+    // even when values are recorded while rendering
+    LatencySnapshot snapshot = Histograms()[op].snapshot();
+
+    int64_t cumulative = 0;
+    size_t next = 0;
+    for (size_t i = PROMETHEUS_FIRST_BUCKET; i <= PROMETHEUS_LAST_BUCKET;
+         i += PROMETHEUS_BUCKET_STRIDE) {
+      for (; next <= i; next++) {
+        cumulative += snapshot.bucket_counts[next];
+      }
+      le.clear();
+      AppendSeconds(le, LatencyHistogram::BucketUpperBound(i));
+      AppendSample(out, "_bucket", name, le, cumulative);
+    }
+    AppendSample(out, "_bucket", name, "+Inf", snapshot.count);
+
+    out.append(PROMETHEUS_METRIC);
+    out.append("_sum{op=\"");
+    out.append(name);
+    out.append("\"} ");
+    AppendSeconds(out, snapshot.sum_nanos);
+    out.append("\n");
+    AppendSample(out, "_count", name, "", snapshot.count);
+  }
+  return out;
+}
+
+namespace internal {
+
+LatencyTimer::LatencyTimer(LatencyOp op) : op_(op), start_(NowNanos()) {}
+
+LatencyTimer::~LatencyTimer() {
+  GetLatencyHistogram(op_).record(NowNanos() - start_);
+}
+
+}  // namespace internal
+
+}  // namespace icypuff
@@ -2,7 +2,15 @@
 
 #include <sys/stat.h>
 
+#if !defined(_WIN32)
+#include <unistd.h>
+
+#include <cerrno>
+#else
 #include <fstream>
+#endif
+
+#include <utility>
 
 #include "icypuff/format_constants.h"
 #include "icypuff/seekable_input_stream.h"
@@ -11,6 +19,68 @@ namespace icypuff {
 
 namespace {
 
+#if !defined(_WIN32)
+// Reads a leased descriptor with pread, tracking its own position so
+// streams of one file share the descriptor
+class LocalSeekableInputStream : public SeekableInputStream {
+ public:
+  explicit LocalSeekableInputStream(std::shared_ptr<const FileHandle> handle)
+      : handle_(std::move(handle)) {}
+
+  Result<size_t> read(uint8_t* buffer, size_t length) override {
+    if (!handle_) {
+      return Result<size_t>{ErrorCode::kStreamNotInitialized,
+                            "Stream is closed"};
+    }
+    size_t total = 0;
+    while (total < length) {
+      ssize_t n = ::pread(handle_->fd(), buffer + total, length - total,
+                          static_cast<off_t>(position_ + total));
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return Result<size_t>{ErrorCode::kInvalidArgument,
+                              "Failed to read from file"};
+      }
+      if (n == 0) {
+        break;
+      }
+      total += static_cast<size_t>(n);
+    }
+    position_ += static_cast<int64_t>(total);
+    return Result<size_t>{total};
+  }
+
+  Result<void> skip(int64_t length) override {
+    return seek(position_ + length);
+  }
+
+  Result<void> seek(int64_t position) override {
+    if (position < 0) {
+      return Result<void>{ErrorCode::kInvalidArgument,
+                          "Failed to seek in file"};
+    }
+    position_ = position;
+    return Result<void>{};
+  }
+
+  Result<int64_t> position() const override {
+    return Result<int64_t>{position_};
+  }
+
+  // Returns the descriptor to the cache rather than closing it, once the
+  // file and its other streams are done with it
+  Result<void> close() override {
+    handle_.reset();
+    return Result<void>{};
+  }
+
+ private:
+  std::shared_ptr<const FileHandle> handle_;
+  int64_t position_ = 0;
+};
+#else
 class LocalSeekableInputStream : public SeekableInputStream {
  public:
   explicit LocalSeekableInputStream(const std::filesystem::path& path)
@@ -66,14 +136,19 @@ class LocalSeekableInputStream : public SeekableInputStream {
  private:
   mutable std::ifstream stream_;
 };
+#endif
 
 }  // namespace
 
-LocalInputFile::LocalInputFile(const std::string& path)
-    : path_(std::filesystem::absolute(path)) {}
+LocalInputFile::LocalInputFile(const std::string& path,
+                               FileHandleCache* handle_cache)
+    : LocalInputFile(std::filesystem::path(path), handle_cache) {}
 
-LocalInputFile::LocalInputFile(const std::filesystem::path& path)
-    : path_(std::filesystem::absolute(path)) {}
+LocalInputFile::LocalInputFile(const std::filesystem::path& path,
+                               FileHandleCache* handle_cache)
+    : path_(std::filesystem::absolute(path)),
+      handle_cache_(handle_cache ? handle_cache
+                                 : &FileHandleCache::Default()) {}
 
 Result<int64_t> LocalInputFile::length() const {
   std::error_code ec;
@@ -86,12 +161,72 @@ Result<int64_t> LocalInputFile::length() const {
 
 Result<std::unique_ptr<SeekableInputStream>> LocalInputFile::new_stream()
     const {
+#if !defined(_WIN32)
+  auto handle = lease();
+  if (!handle.ok()) {
+    return Result<std::unique_ptr<SeekableInputStream>>{handle.error().code,
+                                                        handle.error().message};
+  }
+  return Result<std::unique_ptr<SeekableInputStream>>{
+      std::make_unique<LocalSeekableInputStream>(std::move(handle).value())};
+#else
   auto stream = std::make_unique<LocalSeekableInputStream>(path_);
   if (!stream->is_valid()) {
     return Result<std::unique_ptr<SeekableInputStream>>{
         ErrorCode::kInvalidArgument, "Failed to open file"};
   }
   return Result<std::unique_ptr<SeekableInputStream>>{std::move(stream)};
+#endif
+}
+
+Result<void> LocalInputFile::read_fully(int64_t position, uint8_t* buffer,
+                                        size_t length) const {
+#if defined(_WIN32)
+  return InputFile::read_fully(position, buffer, length);
+#else
+  if (position < 0) {
+    return {ErrorCode::kStreamSeekError, "Read position is negative"};
+  }
+  int fd = fd_.load(std::memory_order_acquire);
+  if (fd < 0) {
+    auto handle = lease();
+    if (!handle.ok()) {
+      return {handle.error().code, handle.error().message};
+    }
+    fd = handle.value()->fd();
+  }
+
+  size_t total = 0;
+  while (total < length) {
+    ssize_t n = ::pread(fd, buffer + total, length - total,
+                        static_cast<off_t>(position + total));
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return {ErrorCode::kStreamReadError, "Failed to read from file"};
+    }
+    if (n == 0) {
+      return {ErrorCode::kIncompleteRead, ERROR_INCOMPLETE_BLOB_READ};
+    }
+    total += static_cast<size_t>(n);
+  }
+  return Result<void>();
+#endif
+}
+
+Result<std::shared_ptr<const FileHandle>> LocalInputFile::lease() const {
+  std::lock_guard<std::mutex> lock(lease_mutex_);
+  if (!handle_) {
+    // Failures are not kept, so a file created later is opened on retry
+    auto handle = handle_cache_->acquire(path_);
+    if (!handle.ok()) {
+      return {handle.error().code, handle.error().message};
+    }
+    handle_ = std::make_shared<const FileHandle>(std::move(handle).value());
+    fd_.store(handle_->fd(), std::memory_order_release);
+  }
+  return handle_;
 }
 
 std::string LocalInputFile::location() const { return path_.string(); }
@@ -100,31 +235,16 @@ bool LocalInputFile::exists() const { return std::filesystem::exists(path_); }
 
 Result<std::vector<uint8_t>> LocalInputFile::read_at(int64_t offset,
                                                      int64_t length) const {
-  auto stream_result = new_stream();
-  if (!stream_result.ok()) {
-    return Result<std::vector<uint8_t>>{stream_result.error().code,
-                                        stream_result.error().message};
+  if (length < 0) {
+    return Result<std::vector<uint8_t>>{ErrorCode::kInvalidArgument,
+                                        "Read length is negative"};
   }
-
-  auto stream = std::move(stream_result).value();
-  auto seek_result = stream->seek(offset);
-  if (!seek_result.ok()) {
-    return Result<std::vector<uint8_t>>{seek_result.error().code,
-                                        seek_result.error().message};
-  }
-
   std::vector<uint8_t> buffer(length);
-  auto read_result = stream->read(buffer.data(), buffer.size());
+  auto read_result = read_fully(offset, buffer.data(), buffer.size());
   if (!read_result.ok()) {
     return Result<std::vector<uint8_t>>{read_result.error().code,
                                         read_result.error().message};
   }
-
-  if (read_result.value() != length) {
-    return Result<std::vector<uint8_t>>{ErrorCode::kIncompleteRead,
-                                        ERROR_INCOMPLETE_BLOB_READ};
-  }
-
   return buffer;
 }
 
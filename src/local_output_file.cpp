@@ -1,69 +1,333 @@
 #include "icypuff/local_output_file.h"
 
-#include <spdlog/spdlog.h>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#endif
 
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
 #include <fstream>
+#include <random>
+#include <thread>
+#include <unordered_set>
 
+#include "icypuff/file_handle_cache.h"
 #include "icypuff/local_input_file.h"
+#include "icypuff/logging.h"
+#include "icypuff/macros.h"
 #include "icypuff/position_output_stream.h"
 
 namespace icypuff {
 
 namespace {
 
+#if !defined(_WIN32)
+// Closes a file descriptor when going out of scope
+class ScopedFd {
+ public:
+  explicit ScopedFd(int fd) : fd_(fd) {}
+  ~ScopedFd() {
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+  }
+
+  ICYPUFF_DISALLOW_COPY_ASSIGN_AND_MOVE(ScopedFd);
+
+  int get() const { return fd_; }
+
+ private:
+  int fd_;
+};
+#endif
+
+#if !defined(_WIN32)
+// Temporary file in the same directory, so the final rename stays on one
+// filesystem and is atomic
+std::filesystem::path TempPathFor(const std::filesystem::path& path) {
+  static constexpr char kDigits[] = "0123456789abcdef";
+  std::random_device rd;
+  std::mt19937_64 gen(rd());
+  uint64_t value = gen();
+  std::string suffix(16, '0');
+  for (auto& digit : suffix) {
+    digit = kDigits[value & 0xF];
+    value >>= 4;
+  }
+  return path.parent_path() /
+         ("." + path.filename().string() + "." + suffix + ".tmp");
+}
+
+Result<void> SyncPath(const std::filesystem::path& path, bool directory) {
+  int flags = O_RDONLY | (directory ? O_DIRECTORY : 0);
+  ScopedFd fd(::open(path.c_str(), flags));
+  if (fd.get() < 0 || ::fsync(fd.get()) != 0) {
+    ICYPUFF_LOG_ERROR("Failed to fsync {}: {}", path.string(),
+                      std::strerror(errno));
+    return {ErrorCode::kStreamWriteError, directory
+                                              ? "Failed to fsync directory"
+                                              : "Failed to fsync file"};
+  }
+  return Result<void>{};
+}
+
+Result<void> SyncParentDirectory(const std::filesystem::path& path) {
+  auto directory = path.parent_path();
+  return SyncPath(directory.empty() ? "." : directory, true);
+}
+
+// Creates the file and reserves its expected size without changing the
+// file size, so the stream still appends from offset 0
+Result<void> PrepareFile(const std::filesystem::path& path, int flags,
+                         int64_t preallocate_size) {
+  ScopedFd fd(::open(path.c_str(), O_WRONLY | O_CREAT | flags, 0644));
+  if (fd.get() < 0) {
+    ICYPUFF_LOG_ERROR("Failed to create {}: {}", path.string(),
+                      std::strerror(errno));
+    return {ErrorCode::kInvalidArgument,
+            errno == EEXIST ? "File already exists" : "Failed to create file"};
+  }
+#if defined(__linux__)
+  if (preallocate_size > 0 &&
+      ::fallocate(fd.get(), FALLOC_FL_KEEP_SIZE, 0, preallocate_size) != 0) {
+    // Preallocation is an optimization, not all filesystems support it
+    ICYPUFF_LOG_DEBUG("Failed to preallocate {} bytes for {}: {}",
+                      preallocate_size, path.string(), std::strerror(errno));
+  }
+#else
+  (void)preallocate_size;
+#endif
+  return Result<void>{};
+}
+
+void RemoveTempFiles(const std::vector<FsyncGroup::PendingFile>& files) {
+  for (const auto& file : files) {
+    std::error_code ec;
+    std::filesystem::remove(file.temp_path, ec);
+  }
+}
+
+// Syncs the files, renames them to their paths and syncs their
+// directories. Nothing is renamed when a file fails to sync. A failed rename
+// is not rolled back: the files renamed before it stay committed and the
+// rest are discarded.
+Result<void> CommitFiles(const std::vector<FsyncGroup::PendingFile>& files,
+                         int threads) {
+  std::atomic<size_t> next{0};
+  std::atomic<bool> failed{false};
+  auto sync_files = [&]() {
+    for (size_t i = next++; i < files.size(); i = next++) {
+      if (files[i].fsync != FsyncPolicy::kNone &&
+          !SyncPath(files[i].temp_path, false).ok()) {
+        failed = true;
+      }
+    }
+  };
+
+  // fsync latency is dominated by device flushes, which overlap well
+  size_t worker_count =
+      std::min(files.size(), static_cast<size_t>(std::max(threads, 1)));
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < worker_count; i++) {
+    workers.emplace_back(sync_files);
+  }
+  sync_files();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  if (failed) {
+    RemoveTempFiles(files);
+    return {ErrorCode::kStreamWriteError, "Failed to fsync file"};
+  }
+
+  std::unordered_set<std::string> directories;
+  for (size_t i = 0; i < files.size(); i++) {
+    const auto& file = files[i];
+    int result;
+    if (file.overwrite) {
+      result = ::rename(file.temp_path.c_str(), file.path.c_str());
+    } else {
+      // link fails instead of replacing a file created in the meantime
+      result = ::link(file.temp_path.c_str(), file.path.c_str());
+      if (result == 0) {
+        ::unlink(file.temp_path.c_str());
+      }
+    }
+    if (result != 0) {
+      ICYPUFF_LOG_ERROR("Failed to rename {} to {}: {}",
+                        file.temp_path.string(), file.path.string(),
+                        std::strerror(errno));
+      RemoveTempFiles({files.begin() + i, files.end()});
+      return {ErrorCode::kStreamWriteError,
+              errno == EEXIST ? "File already exists"
+                              : "Failed to rename file"};
+    }
+    // Readers reopen the new file instead of a cached descriptor of the old
+    FileHandleCache::Default().invalidate(std::filesystem::absolute(file.path));
+    if (file.fsync == FsyncPolicy::kFileAndDirectory) {
+      directories.insert(file.path.parent_path().string());
+    }
+  }
+
+  // One directory sync covers every rename into that directory
+  for (const auto& directory : directories) {
+    auto sync_result = SyncPath(directory.empty() ? "." : directory, true);
+    if (!sync_result.ok()) {
+      return sync_result;
+    }
+  }
+  return Result<void>{};
+}
+#endif
+
 class LocalPositionOutputStream : public PositionOutputStream {
  public:
   explicit LocalPositionOutputStream(const std::filesystem::path& path,
                                      bool overwrite)
-      : stream_(path, std::ios::binary | std::ios::out |
-                          (overwrite ? std::ios::trunc : std::ios::app)) {
+      : LocalPositionOutputStream(
+            path, std::ios::binary | std::ios::out |
+                      (overwrite ? std::ios::trunc : std::ios::app)) {}
+
+  LocalPositionOutputStream(const std::filesystem::path& path,
+                            std::ios::openmode mode)
+      : path_(path), stream_(path, mode) {
     if (!stream_) {
-      spdlog::error("Failed to open output stream for path: {}", path.string());
+      ICYPUFF_LOG_ERROR("Failed to open output stream for path: {}",
+                        path.string());
       return;  // Error will be handled by caller
     }
-    spdlog::debug("Successfully opened output stream for path: {}",
-                  path.string());
+    // Continue after any existing content when not truncating
+    stream_.seekp(0, std::ios::end);
+    ICYPUFF_LOG_DEBUG("Successfully opened output stream for path: {}",
+                      path.string());
   }
 
   Result<void> write(const uint8_t* buffer, size_t length) override {
-    spdlog::debug("Writing {} bytes to output stream", length);
+    ICYPUFF_LOG_DEBUG("Writing {} bytes to output stream", length);
     stream_.write(static_cast<const char*>(static_cast<const void*>(buffer)),
                   length);
     if (stream_.bad()) {
-      spdlog::error("Failed to write {} bytes to output stream", length);
+      ICYPUFF_LOG_ERROR("Failed to write {} bytes to output stream", length);
       return Result<void>{ErrorCode::kInvalidArgument,
                           "Failed to write to file"};
     }
     return Result<void>{};
   }
 
+#if defined(__linux__)
+  // Copies between local files inside the kernel with copy_file_range, which
+  // also shares extents on filesystems with reflink support, and falls back
+  // to sendfile across filesystems
+  Result<void> transfer_from(const InputFile& source, int64_t offset,
+                             int64_t length) override {
+    const auto* local_source = dynamic_cast<const LocalInputFile*>(&source);
+    if (local_source == nullptr) {
+      return {ErrorCode::kUnimplemented, "Transfer requires a local source"};
+    }
+
+    auto pos_result = position();
+    if (!pos_result.ok()) {
+      return {pos_result.error().code, pos_result.error().message};
+    }
+    stream_.flush();
+    if (stream_.fail()) {
+      return {ErrorCode::kStreamWriteError, "Failed to flush file"};
+    }
+
+    ScopedFd in_fd(::open(local_source->location().c_str(), O_RDONLY));
+    if (in_fd.get() < 0) {
+      return {ErrorCode::kStreamReadError, "Failed to open source file"};
+    }
+    ScopedFd out_fd(::open(path_.c_str(), O_WRONLY));
+    if (out_fd.get() < 0) {
+      return {ErrorCode::kStreamWriteError, "Failed to open file"};
+    }
+
+    off_t in_offset = offset;
+    off_t out_offset = pos_result.value();
+    int64_t remaining = length;
+    bool use_sendfile = false;
+    while (remaining > 0) {
+      ssize_t copied;
+      if (!use_sendfile) {
+        copied = ::copy_file_range(in_fd.get(), &in_offset, out_fd.get(),
+                                   &out_offset, remaining, 0);
+        if (copied < 0 && (errno == EXDEV || errno == EINVAL ||
+                           errno == ENOSYS || errno == EOPNOTSUPP)) {
+          use_sendfile = true;
+          // sendfile writes at the file offset of the output descriptor
+          if (::lseek(out_fd.get(), out_offset, SEEK_SET) < 0) {
+            return {ErrorCode::kStreamSeekError, "Failed to seek in file"};
+          }
+          continue;
+        }
+      } else {
+        copied = ::sendfile(out_fd.get(), in_fd.get(), &in_offset, remaining);
+        if (copied > 0) {
+          out_offset += copied;
+        } else if (copied < 0 && remaining == length &&
+                   (errno == EINVAL || errno == ENOSYS)) {
+          return {ErrorCode::kUnimplemented, "Transfer is not supported"};
+        }
+      }
+
+      if (copied < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        ICYPUFF_LOG_ERROR("Failed to transfer {} bytes from {}: {}", remaining,
+                          local_source->location(), std::strerror(errno));
+        return {ErrorCode::kStreamWriteError, "Failed to transfer file range"};
+      }
+      if (copied == 0) {
+        return {ErrorCode::kIncompleteRead, "Source file ended early"};
+      }
+      remaining -= copied;
+    }
+
+    stream_.seekp(out_offset);
+    if (stream_.fail()) {
+      return {ErrorCode::kStreamSeekError, "Failed to seek in file"};
+    }
+    ICYPUFF_LOG_DEBUG("Transferred {} bytes from {}", length,
+                      local_source->location());
+    return Result<void>{};
+  }
+#endif
+
   Result<int64_t> position() const override {
     auto pos = stream_.tellp();
     if (pos == -1) {
-      spdlog::error("Failed to get position in output stream");
+      ICYPUFF_LOG_ERROR("Failed to get position in output stream");
       return Result<int64_t>{ErrorCode::kInvalidArgument,
                              "Failed to get position in file"};
     }
     auto pos_int = static_cast<int64_t>(pos);
-    spdlog::debug("Current position in output stream: {}", pos_int);
+    ICYPUFF_LOG_DEBUG("Current position in output stream: {}", pos_int);
     return Result<int64_t>{pos_int};
   }
 
   Result<void> flush() override {
-    spdlog::debug("Flushing output stream");
+    ICYPUFF_LOG_DEBUG("Flushing output stream");
     stream_.flush();
     if (stream_.fail()) {
-      spdlog::error("Failed to flush output stream");
+      ICYPUFF_LOG_ERROR("Failed to flush output stream");
       return Result<void>{ErrorCode::kInvalidArgument, "Failed to flush file"};
     }
     return Result<void>{};
   }
 
   Result<void> close() override {
-    spdlog::debug("Closing output stream");
+    ICYPUFF_LOG_DEBUG("Closing output stream");
     stream_.close();
     if (stream_.fail()) {
-      spdlog::error("Failed to close output stream");
+      ICYPUFF_LOG_ERROR("Failed to close output stream");
       return Result<void>{ErrorCode::kInvalidArgument, "Failed to close file"};
     }
     return Result<void>{};
@@ -72,57 +336,318 @@ class LocalPositionOutputStream : public PositionOutputStream {
   bool is_valid() const { return static_cast<bool>(stream_); }
 
  private:
+  std::filesystem::path path_;
   mutable std::ofstream stream_;  // mutable because tellp() is not const
 };
 
+#if !defined(_WIN32)
+// Applies the durability options of a LocalOutputFile when closed. Atomic
+// files are written to temp_path and renamed to path on commit.
+class DurablePositionOutputStream : public PositionOutputStream {
+ public:
+  DurablePositionOutputStream(
+      std::unique_ptr<LocalPositionOutputStream> stream,
+      FsyncGroup::PendingFile file, int64_t preallocate_size,
+      std::shared_ptr<FsyncGroup> fsync_group)
+      : stream_(std::move(stream)),
+        file_(std::move(file)),
+        preallocate_size_(preallocate_size),
+        fsync_group_(std::move(fsync_group)) {}
+
+  ~DurablePositionOutputStream() override {
+    // An abandoned atomic file never replaces the target
+    if (owns_temp_file()) {
+      stream_.reset();
+      RemoveTempFiles({file_});
+    }
+  }
+
+  ICYPUFF_DISALLOW_COPY_ASSIGN_AND_MOVE(DurablePositionOutputStream);
+
+  Result<void> write(const uint8_t* buffer, size_t length) override {
+    return stream_->write(buffer, length);
+  }
+
+  Result<void> transfer_from(const InputFile& source, int64_t offset,
+                             int64_t length) override {
+    return stream_->transfer_from(source, offset, length);
+  }
+
+  Result<int64_t> position() const override { return stream_->position(); }
+
+  Result<void> flush() override { return stream_->flush(); }
+
+  Result<void> close() override {
+    if (closed_) {
+      return Result<void>{};
+    }
+    auto pos_result = stream_->position();
+    if (!pos_result.ok()) {
+      return {pos_result.error().code, pos_result.error().message};
+    }
+    auto close_result = stream_->close();
+    if (!close_result.ok()) {
+      return close_result;
+    }
+    closed_ = true;
+
+    // Release preallocated space beyond the written size
+    if (preallocate_size_ > pos_result.value() &&
+        ::truncate(file_.temp_path.c_str(), pos_result.value()) != 0) {
+      ICYPUFF_LOG_DEBUG("Failed to release preallocated space of {}",
+                        file_.temp_path.string());
+    }
+
+    if (file_.temp_path == file_.path) {
+      if (file_.fsync == FsyncPolicy::kNone) {
+        return Result<void>{};
+      }
+      auto sync_result = SyncPath(file_.path, false);
+      if (!sync_result.ok() || file_.fsync != FsyncPolicy::kFileAndDirectory) {
+        return sync_result;
+      }
+      return SyncParentDirectory(file_.path);
+    }
+
+    committed_ = true;
+    if (fsync_group_) {
+      fsync_group_->add(file_);
+      return Result<void>{};
+    }
+    return CommitFiles({file_}, 1);
+  }
+
+ private:
+  bool owns_temp_file() const {
+    return file_.temp_path != file_.path && !committed_;
+  }
+
+  std::unique_ptr<LocalPositionOutputStream> stream_;
+  FsyncGroup::PendingFile file_;
+  int64_t preallocate_size_;
+  std::shared_ptr<FsyncGroup> fsync_group_;
+  bool closed_ = false;
+  // Set once the temp file is handed to a commit, which then owns it
+  bool committed_ = false;
+};
+#endif
+
 }  // namespace
 
+FsyncGroup::FsyncGroup(int threads) : threads_(std::max(threads, 1)) {}
+
+FsyncGroup::~FsyncGroup() {
+#if !defined(_WIN32)
+  RemoveTempFiles(pending_);
+#endif
+}
+
+void FsyncGroup::add(PendingFile file) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  pending_.push_back(std::move(file));
+}
+
+size_t FsyncGroup::pending() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return pending_.size();
+}
+
+Result<void> FsyncGroup::commit() {
+  std::vector<PendingFile> files;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    files.swap(pending_);
+  }
+  if (files.empty()) {
+    return Result<void>{};
+  }
+  ICYPUFF_LOG_DEBUG("Committing {} files", files.size());
+#if !defined(_WIN32)
+  return CommitFiles(files, threads_);
+#else
+  return {ErrorCode::kUnimplemented, "Group commit is not supported"};
+#endif
+}
+
 LocalOutputFile::LocalOutputFile(const std::string& path) : path_(path) {
-  spdlog::debug("Created LocalOutputFile with path: {}", path);
+  ICYPUFF_LOG_DEBUG("Created LocalOutputFile with path: {}", path);
 }
 
 LocalOutputFile::LocalOutputFile(const std::filesystem::path& path)
     : path_(path) {
-  spdlog::debug("Created LocalOutputFile with path: {}", path.string());
+  ICYPUFF_LOG_DEBUG("Created LocalOutputFile with path: {}", path.string());
+}
+
+LocalOutputFile::LocalOutputFile(const std::filesystem::path& path,
+                                 LocalOutputFileOptions options)
+    : path_(path), options_(std::move(options)) {
+  ICYPUFF_LOG_DEBUG("Created LocalOutputFile with path: {}", path.string());
 }
 
 Result<std::unique_ptr<PositionOutputStream>> LocalOutputFile::create() {
-  spdlog::debug("Attempting to create new file at: {}", path_.string());
+  ICYPUFF_LOG_DEBUG("Attempting to create new file at: {}", path_.string());
   if (std::filesystem::exists(path_)) {
-    spdlog::error("File already exists at path: {}", path_.string());
+    ICYPUFF_LOG_ERROR("File already exists at path: {}", path_.string());
     return Result<std::unique_ptr<PositionOutputStream>>{
         ErrorCode::kInvalidArgument, "File already exists"};
   }
+  if (is_durable()) {
+    return open_durable(false);
+  }
   auto stream = std::make_unique<LocalPositionOutputStream>(path_, false);
   if (!stream->is_valid()) {
-    spdlog::error("Failed to create file at path: {}", path_.string());
+    ICYPUFF_LOG_ERROR("Failed to create file at path: {}", path_.string());
     return Result<std::unique_ptr<PositionOutputStream>>{
         ErrorCode::kInvalidArgument, "Failed to create file"};
   }
-  spdlog::debug("Successfully created new file at: {}", path_.string());
+  ICYPUFF_LOG_DEBUG("Successfully created new file at: {}", path_.string());
   return Result<std::unique_ptr<PositionOutputStream>>{std::move(stream)};
 }
 
 Result<std::unique_ptr<PositionOutputStream>>
 LocalOutputFile::create_or_overwrite() {
-  spdlog::debug("Attempting to create or overwrite file at: {}",
-                path_.string());
+  ICYPUFF_LOG_DEBUG("Attempting to create or overwrite file at: {}",
+                    path_.string());
+  if (is_durable()) {
+    return open_durable(true);
+  }
   auto stream = std::make_unique<LocalPositionOutputStream>(path_, true);
   if (!stream->is_valid()) {
-    spdlog::error("Failed to create or overwrite file at path: {}",
-                  path_.string());
+    ICYPUFF_LOG_ERROR("Failed to create or overwrite file at path: {}",
+                      path_.string());
     return Result<std::unique_ptr<PositionOutputStream>>{
         ErrorCode::kInvalidArgument, "Failed to create file"};
   }
-  spdlog::debug("Successfully created or overwrote file at: {}",
-                path_.string());
+  ICYPUFF_LOG_DEBUG("Successfully created or overwrote file at: {}",
+                    path_.string());
+  return Result<std::unique_ptr<PositionOutputStream>>{std::move(stream)};
+}
+
+Result<std::unique_ptr<PositionOutputStream>> LocalOutputFile::append_at(
+    int64_t position) {
+  ICYPUFF_LOG_DEBUG("Attempting to append to file at: {} from position {}",
+                    path_.string(), position);
+  if (position < 0) {
+    return Result<std::unique_ptr<PositionOutputStream>>{
+        ErrorCode::kInvalidArgument, "Append position must be non-negative"};
+  }
+
+  if (options_.atomic) {
+    return append_staged(position);
+  }
+
+  std::error_code ec;
+  std::filesystem::resize_file(path_, static_cast<uintmax_t>(position), ec);
+  if (ec) {
+    ICYPUFF_LOG_ERROR("Failed to truncate file at path: {}: {}", path_.string(),
+                      ec.message());
+    return Result<std::unique_ptr<PositionOutputStream>>{
+        ErrorCode::kInvalidArgument, "Failed to truncate file"};
+  }
+
+  auto stream = std::make_unique<LocalPositionOutputStream>(
+      path_, std::ios::binary | std::ios::in | std::ios::out);
+  if (!stream->is_valid()) {
+    ICYPUFF_LOG_ERROR("Failed to open file for append at path: {}",
+                      path_.string());
+    return Result<std::unique_ptr<PositionOutputStream>>{
+        ErrorCode::kInvalidArgument, "Failed to open file for append"};
+  }
+#if !defined(_WIN32)
+  if (options_.fsync != FsyncPolicy::kNone) {
+    return Result<std::unique_ptr<PositionOutputStream>>{
+        std::make_unique<DurablePositionOutputStream>(
+            std::move(stream),
+            FsyncGroup::PendingFile{path_, path_, options_.fsync, true}, 0,
+            nullptr)};
+  }
+#endif
   return Result<std::unique_ptr<PositionOutputStream>>{std::move(stream)};
 }
 
+Result<std::unique_ptr<PositionOutputStream>> LocalOutputFile::append_staged(
+    int64_t position) {
+#if !defined(_WIN32)
+  // The kept part of the file is copied to the temporary file, so the path
+  // holds the complete old file until the append is renamed over it
+  auto temp_path = TempPathFor(path_);
+  FsyncGroup::PendingFile file{temp_path, path_, options_.fsync, true};
+  std::error_code ec;
+  std::filesystem::copy_file(path_, temp_path, ec);
+  if (!ec) {
+    std::filesystem::resize_file(temp_path, static_cast<uintmax_t>(position),
+                                 ec);
+  }
+  if (ec) {
+    ICYPUFF_LOG_ERROR("Failed to stage {} for append: {}", path_.string(),
+                      ec.message());
+    RemoveTempFiles({file});
+    return {ErrorCode::kInvalidArgument, "Failed to stage file for append"};
+  }
+
+  auto stream = std::make_unique<LocalPositionOutputStream>(
+      temp_path, std::ios::binary | std::ios::in | std::ios::out);
+  if (!stream->is_valid()) {
+    ICYPUFF_LOG_ERROR("Failed to open file at path: {}", temp_path.string());
+    RemoveTempFiles({file});
+    return {ErrorCode::kInvalidArgument, "Failed to open file for append"};
+  }
+  ICYPUFF_LOG_DEBUG("Staged append to {} in {}", path_.string(),
+                    temp_path.string());
+  return Result<std::unique_ptr<PositionOutputStream>>{
+      std::make_unique<DurablePositionOutputStream>(
+          std::move(stream), std::move(file), 0, options_.fsync_group)};
+#else
+  (void)position;
+  return {ErrorCode::kUnimplemented,
+          "Durable writes are not supported on this platform"};
+#endif
+}
+
+bool LocalOutputFile::is_durable() const {
+  return options_.atomic || options_.fsync != FsyncPolicy::kNone ||
+         options_.preallocate_size > 0;
+}
+
+Result<std::unique_ptr<PositionOutputStream>> LocalOutputFile::open_durable(
+    bool overwrite) {
+#if !defined(_WIN32)
+  auto temp_path = options_.atomic ? TempPathFor(path_) : path_;
+  int flags = options_.atomic || !overwrite ? O_EXCL : O_TRUNC;
+  auto prepare_result =
+      PrepareFile(temp_path, flags, options_.preallocate_size);
+  if (!prepare_result.ok()) {
+    return {prepare_result.error().code, prepare_result.error().message};
+  }
+
+  // Opened without truncation to keep the preallocated blocks
+  auto stream = std::make_unique<LocalPositionOutputStream>(
+      temp_path, std::ios::binary | std::ios::in | std::ios::out);
+  if (!stream->is_valid()) {
+    ICYPUFF_LOG_ERROR("Failed to open file at path: {}", temp_path.string());
+    if (options_.atomic) {
+      RemoveTempFiles({{temp_path, path_, options_.fsync, overwrite}});
+    }
+    return {ErrorCode::kInvalidArgument, "Failed to create file"};
+  }
+  ICYPUFF_LOG_DEBUG("Opened {} for a {} write to {}", temp_path.string(),
+                    options_.atomic ? "atomic" : "durable", path_.string());
+  return Result<std::unique_ptr<PositionOutputStream>>{
+      std::make_unique<DurablePositionOutputStream>(
+          std::move(stream),
+          FsyncGroup::PendingFile{temp_path, path_, options_.fsync, overwrite},
+          options_.preallocate_size, options_.fsync_group)};
+#else
+  (void)overwrite;
+  return {ErrorCode::kUnimplemented,
+          "Durable writes are not supported on this platform"};
+#endif
+}
+
 std::string LocalOutputFile::location() const { return path_.string(); }
 
 Result<std::unique_ptr<InputFile>> LocalOutputFile::to_input_file() const {
-  spdlog::debug("Converting output file to input file: {}", path_.string());
+  ICYPUFF_LOG_DEBUG("Converting output file to input file: {}", path_.string());
   return Result<std::unique_ptr<InputFile>>{
       std::make_unique<LocalInputFile>(path_)};
 }
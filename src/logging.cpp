@@ -0,0 +1,49 @@
+#include "icypuff/logging.h"
+
+#include <spdlog/spdlog.h>
+
+#include <atomic>
+
+namespace icypuff {
+
+namespace {
+
+spdlog::level::level_enum ToSpdlogLevel(LogLevel level) {
+  switch (level) {
+    case LogLevel::kTrace:
+      return spdlog::level::trace;
+    case LogLevel::kDebug:
+      return spdlog::level::debug;
+    case LogLevel::kInfo:
+      return spdlog::level::info;
+    case LogLevel::kWarn:
+      return spdlog::level::warn;
+    case LogLevel::kError:
+      return spdlog::level::err;
+  }
+  return spdlog::level::err;
+}
+
+class SpdlogSink : public LogSink {
+ public:
+  bool enabled(LogLevel level) const override {
+    return spdlog::should_log(ToSpdlogLevel(level));
+  }
+
+  void log(LogLevel level, std::string_view message) override {
+    spdlog::log(ToSpdlogLevel(level), "{}", message);
+  }
+};
+
+SpdlogSink default_sink;
+std::atomic<LogSink*> global_sink{&default_sink};
+
+}  // namespace
+
+void SetLogSink(LogSink* sink) {
+  global_sink.store(sink, std::memory_order_release);
+}
+
+LogSink* GetLogSink() { return global_sink.load(std::memory_order_acquire); }
+
+}  // namespace icypuff
@@ -0,0 +1,96 @@
+#include "icypuff/memory_input_file.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "icypuff/format_constants.h"
+#include "icypuff/seekable_input_stream.h"
+
+namespace icypuff {
+
+namespace {
+
+class MemorySeekableInputStream : public SeekableInputStream {
+ public:
+  explicit MemorySeekableInputStream(std::span<const uint8_t> data)
+      : data_(data) {}
+
+  Result<size_t> read(uint8_t* buffer, size_t length) override {
+    if (closed_) {
+      return {ErrorCode::kInvalidState, "Stream is closed"};
+    }
+    size_t available = data_.size() - position_;
+    size_t bytes_read = std::min(length, available);
+    std::memcpy(buffer, data_.data() + position_, bytes_read);
+    position_ += bytes_read;
+    return bytes_read;
+  }
+
+  Result<void> skip(int64_t length) override {
+    return seek(static_cast<int64_t>(position_) + length);
+  }
+
+  Result<void> seek(int64_t position) override {
+    if (position < 0 || position > static_cast<int64_t>(data_.size())) {
+      return {ErrorCode::kStreamSeekError, "Seek position out of range"};
+    }
+    position_ = static_cast<size_t>(position);
+    return Result<void>{};
+  }
+
+  Result<int64_t> position() const override {
+    return static_cast<int64_t>(position_);
+  }
+
+  Result<void> close() override {
+    closed_ = true;
+    return Result<void>{};
+  }
+
+ private:
+  std::span<const uint8_t> data_;
+  size_t position_ = 0;
+  bool closed_ = false;
+};
+
+}  // namespace
+
+MemoryInputFile::MemoryInputFile(std::span<const uint8_t> data,
+                                 std::string location)
+    : data_(data), location_(std::move(location)) {}
+
+MemoryInputFile::MemoryInputFile(
+    std::shared_ptr<const std::vector<uint8_t>> buffer, std::string location)
+    : buffer_(std::move(buffer)), location_(std::move(location)) {
+  if (buffer_) {
+    data_ = std::span<const uint8_t>(buffer_->data(), buffer_->size());
+  }
+}
+
+Result<int64_t> MemoryInputFile::length() const {
+  return static_cast<int64_t>(data_.size());
+}
+
+Result<std::unique_ptr<SeekableInputStream>> MemoryInputFile::new_stream()
+    const {
+  return Result<std::unique_ptr<SeekableInputStream>>{
+      std::make_unique<MemorySeekableInputStream>(data_)};
+}
+
+Result<void> MemoryInputFile::read_fully(int64_t position, uint8_t* buffer,
+                                         size_t length) const {
+  if (position < 0 || position > static_cast<int64_t>(data_.size())) {
+    return {ErrorCode::kStreamSeekError, "Seek position out of range"};
+  }
+  if (length > data_.size() - static_cast<size_t>(position)) {
+    return {ErrorCode::kIncompleteRead, ERROR_INCOMPLETE_BLOB_READ};
+  }
+  std::memcpy(buffer, data_.data() + position, length);
+  return Result<void>();
+}
+
+std::string MemoryInputFile::location() const { return location_; }
+
+bool MemoryInputFile::exists() const { return true; }
+
+}  // namespace icypuff
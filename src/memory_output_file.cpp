@@ -0,0 +1,110 @@
+#include "icypuff/memory_output_file.h"
+
+#include <functional>
+
+#include "icypuff/logging.h"
+#include "icypuff/memory_input_file.h"
+#include "icypuff/position_output_stream.h"
+
+namespace icypuff {
+
+namespace {
+
+class MemoryPositionOutputStream : public PositionOutputStream {
+ public:
+  explicit MemoryPositionOutputStream(
+      std::shared_ptr<std::vector<uint8_t>> buffer)
+      : buffer_(std::move(buffer)) {}
+
+  Result<void> write(const uint8_t* buffer, size_t length) override {
+    if (closed_) {
+      return {ErrorCode::kInvalidState, "Stream is closed"};
+    }
+    buffer_->insert(buffer_->end(), buffer, buffer + length);
+    return Result<void>{};
+  }
+
+  // Copies straight out of another in-memory file
+  Result<void> transfer_from(const InputFile& source, int64_t offset,
+                             int64_t length) override {
+    const auto* memory_source = dynamic_cast<const MemoryInputFile*>(&source);
+    if (memory_source == nullptr) {
+      return {ErrorCode::kUnimplemented, "Transfer requires a memory source"};
+    }
+    auto data = memory_source->data();
+    if (offset < 0 || length < 0 ||
+        offset + length > static_cast<int64_t>(data.size())) {
+      return {ErrorCode::kIncompleteRead, "Source file ended early"};
+    }
+    const uint8_t* begin = data.data() + offset;
+    // A source sharing this file's buffer would be moved by the insert, so
+    // its bytes are copied out first
+    std::less_equal<const uint8_t*> not_after;
+    if (!buffer_->empty() && not_after(buffer_->data(), begin) &&
+        not_after(begin, buffer_->data() + buffer_->size())) {
+      std::vector<uint8_t> copy(begin, begin + length);
+      return write(copy.data(), copy.size());
+    }
+    return write(begin, static_cast<size_t>(length));
+  }
+
+  Result<int64_t> position() const override {
+    return static_cast<int64_t>(buffer_->size());
+  }
+
+  Result<void> flush() override { return Result<void>{}; }
+
+  Result<void> close() override {
+    closed_ = true;
+    return Result<void>{};
+  }
+
+ private:
+  std::shared_ptr<std::vector<uint8_t>> buffer_;
+  bool closed_ = false;
+};
+
+}  // namespace
+
+MemoryOutputFile::MemoryOutputFile(std::string location)
+    : MemoryOutputFile(std::make_shared<std::vector<uint8_t>>(),
+                       std::move(location)) {}
+
+MemoryOutputFile::MemoryOutputFile(
+    std::shared_ptr<std::vector<uint8_t>> buffer, std::string location)
+    : buffer_(std::move(buffer)), location_(std::move(location)) {}
+
+Result<std::unique_ptr<PositionOutputStream>> MemoryOutputFile::create() {
+  if (!buffer_->empty()) {
+    return {ErrorCode::kInvalidArgument, "File already exists"};
+  }
+  return create_or_overwrite();
+}
+
+Result<std::unique_ptr<PositionOutputStream>>
+MemoryOutputFile::create_or_overwrite() {
+  buffer_->clear();
+  return Result<std::unique_ptr<PositionOutputStream>>{
+      std::make_unique<MemoryPositionOutputStream>(buffer_)};
+}
+
+Result<std::unique_ptr<PositionOutputStream>> MemoryOutputFile::append_at(
+    int64_t position) {
+  if (position < 0 || position > static_cast<int64_t>(buffer_->size())) {
+    return {ErrorCode::kInvalidArgument, "Append position out of range"};
+  }
+  buffer_->resize(static_cast<size_t>(position));
+  return Result<std::unique_ptr<PositionOutputStream>>{
+      std::make_unique<MemoryPositionOutputStream>(buffer_)};
+}
+
+std::string MemoryOutputFile::location() const { return location_; }
+
+Result<std::unique_ptr<InputFile>> MemoryOutputFile::to_input_file() const {
+  ICYPUFF_LOG_DEBUG("Sharing {} bytes of {} as an input file", buffer_->size(),
+                    location_);
+  return Result<std::unique_ptr<InputFile>>{
+      std::make_unique<MemoryInputFile>(buffer_, location_)};
+}
+
+}  // namespace icypuff
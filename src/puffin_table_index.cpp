@@ -0,0 +1,181 @@
+#include "icypuff/puffin_table_index.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+
+#include "icypuff/logging.h"
+
+namespace icypuff {
+
+namespace {
+
+size_t CombineHash(size_t seed, size_t value) {
+  return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+// Whether candidate is a later statistic than current
+bool IsLater(const IndexedBlob& candidate, const IndexedBlob& current) {
+  const BlobMetadata& a = *candidate.metadata;
+  const BlobMetadata& b = *current.metadata;
+  if (a.sequence_number() != b.sequence_number()) {
+    return a.sequence_number() > b.sequence_number();
+  }
+  if (a.snapshot_id() != b.snapshot_id()) {
+    return a.snapshot_id() > b.snapshot_id();
+  }
+  if (candidate.file_index != current.file_index) {
+    return candidate.file_index > current.file_index;
+  }
+  return candidate.blob_index > current.blob_index;
+}
+
+}  // namespace
+
+size_t PuffinTableIndex::KeyHash::operator()(const SnapshotKey& key) const {
+  size_t hash = std::hash<int64_t>()(key.snapshot_id);
+  hash = CombineHash(hash, std::hash<int>()(key.field_id));
+  return CombineHash(hash, std::hash<std::string>()(key.type));
+}
+
+size_t PuffinTableIndex::KeyHash::operator()(const FieldKey& key) const {
+  return CombineHash(std::hash<int>()(key.field_id),
+                     std::hash<std::string>()(key.type));
+}
+
+Result<std::unique_ptr<PuffinTableIndex>> PuffinTableIndex::Create(
+    std::vector<std::unique_ptr<InputFile>> input_files,
+    PuffinTableIndexParams params) {
+  for (const auto& input_file : input_files) {
+    if (!input_file) {
+      return {ErrorCode::kInvalidArgument, "Input file is null"};
+    }
+  }
+
+  std::unique_ptr<PuffinTableIndex> index(new PuffinTableIndex());
+  index->files_.resize(input_files.size());
+
+  // Each worker opens and parses whole files, so footers of different
+  // files are read and parsed concurrently
+  int threads = params.threads > 0
+                    ? params.threads
+                    : static_cast<int>(std::thread::hardware_concurrency());
+  int max_threads = static_cast<int>(std::max<size_t>(input_files.size(), 1));
+  threads = std::clamp(threads, 1, max_threads);
+
+  std::atomic<size_t> next_file{0};
+  std::atomic<bool> failed{false};
+  std::vector<ErrorCode> errors(input_files.size(), ErrorCode::kOk);
+  std::vector<std::string> error_messages(input_files.size());
+
+  auto worker = [&]() {
+    for (size_t i = next_file.fetch_add(1);
+         i < input_files.size() && !failed.load(std::memory_order_relaxed);
+         i = next_file.fetch_add(1)) {
+      IndexedFile& file = index->files_[i];
+      std::string location = input_files[i]->location();
+      file.reader = std::make_unique<IcypuffReader>(std::move(input_files[i]));
+      auto metadata = file.reader->file_metadata();
+      if (!metadata.ok()) {
+        ICYPUFF_LOG_WARN("Failed to index statistics file {}: {}", i,
+                         metadata.error().message);
+        errors[i] = metadata.error().code;
+        error_messages[i] = fmt::format(
+            "Failed to read the footer of statistics file {} ({}): {}", i,
+            location, metadata.error().message);
+        failed.store(true, std::memory_order_relaxed);
+        return;
+      }
+      file.metadata = metadata.value();
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (int t = 1; t < threads; t++) {
+    workers.emplace_back(worker);
+  }
+  worker();
+  for (auto& thread : workers) {
+    thread.join();
+  }
+
+  // Reader errors point into the reader, which is discarded with the index,
+  // so the message is kept until the next failed Create on this thread
+  for (size_t i = 0; i < errors.size(); i++) {
+    if (errors[i] != ErrorCode::kOk) {
+      thread_local std::string create_error_message;
+      create_error_message = std::move(error_messages[i]);
+      return {errors[i], create_error_message};
+    }
+  }
+
+  // Inserting in file order keeps each key's blobs in file order
+  for (size_t i = 0; i < index->files_.size(); i++) {
+    index->add_file(i);
+  }
+  ICYPUFF_LOG_DEBUG("Indexed {} blobs from {} files on {} threads",
+                    index->blob_count_, index->files_.size(), threads);
+  return index;
+}
+
+void PuffinTableIndex::add_file(size_t file_index) {
+  const auto& blobs = files_[file_index].metadata->blobs();
+  for (size_t i = 0; i < blobs.size(); i++) {
+    IndexedBlob entry{file_index, i, blobs[i].get()};
+    for (int field_id : blobs[i]->input_fields()) {
+      by_snapshot_[{blobs[i]->snapshot_id(), field_id, blobs[i]->type()}]
+          .push_back(entry);
+      auto [it, inserted] =
+          latest_.try_emplace({field_id, blobs[i]->type()}, entry);
+      if (!inserted && IsLater(entry, it->second)) {
+        it->second = entry;
+      }
+    }
+  }
+  blob_count_ += blobs.size();
+}
+
+std::vector<IndexedBlob> PuffinTableIndex::find(int64_t snapshot_id,
+                                                int field_id,
+                                                std::string_view type) const {
+  auto it = by_snapshot_.find({snapshot_id, field_id, std::string(type)});
+  if (it == by_snapshot_.end()) {
+    return {};
+  }
+  return it->second;
+}
+
+std::optional<IndexedBlob> PuffinTableIndex::find_latest(
+    int field_id, std::string_view type) const {
+  auto it = latest_.find({field_id, std::string(type)});
+  if (it == latest_.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+Result<std::vector<uint8_t>> PuffinTableIndex::read_blob(
+    const IndexedBlob& blob) const {
+  if (blob.file_index >= files_.size()) {
+    return {ErrorCode::kInvalidArgument, "File index out of range"};
+  }
+  return files_[blob.file_index].reader->read_blob(*blob.metadata);
+}
+
+Result<BulkFetchStats> PuffinTableIndex::fetch_blobs(
+    const std::vector<IndexedBlob>& blobs, const BlobFetchCallback& callback,
+    BulkFetchParams params) const {
+  std::vector<BlobFetchRequest> requests;
+  requests.reserve(blobs.size());
+  for (const auto& blob : blobs) {
+    if (blob.file_index >= files_.size()) {
+      return {ErrorCode::kInvalidArgument, "File index out of range"};
+    }
+    requests.push_back({files_[blob.file_index].reader.get(), blob.metadata});
+  }
+  return FetchBlobs(requests, callback, params);
+}
+
+}  // namespace icypuff
@@ -0,0 +1,71 @@
+#include "icypuff/stats.h"
+
+#include <chrono>
+
+namespace icypuff {
+namespace internal {
+
+namespace {
+
+constexpr auto kRelaxed = std::memory_order_relaxed;
+
+CodecStatsArray Snapshot(const std::array<AtomicCodecStats, 3>& stats) {
+  CodecStatsArray result;
+  for (size_t i = 0; i < stats.size(); i++) {
+    result[i] = stats[i].snapshot();
+  }
+  return result;
+}
+
+}  // namespace
+
+int64_t NowNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void AtomicCodecStats::record(int64_t uncompressed, int64_t compressed,
+                              int64_t elapsed) {
+  calls.fetch_add(1, kRelaxed);
+  uncompressed_bytes.fetch_add(uncompressed, kRelaxed);
+  compressed_bytes.fetch_add(compressed, kRelaxed);
+  nanos.fetch_add(elapsed, kRelaxed);
+}
+
+CodecStats AtomicCodecStats::snapshot() const {
+  return CodecStats{
+      .calls = calls.load(kRelaxed),
+      .uncompressed_bytes = uncompressed_bytes.load(kRelaxed),
+      .compressed_bytes = compressed_bytes.load(kRelaxed),
+      .nanos = nanos.load(kRelaxed),
+  };
+}
+
+ReaderStats ReaderCounters::snapshot() const {
+  return ReaderStats{
+      .bytes_read = bytes_read.load(kRelaxed),
+      .read_calls = read_calls.load(kRelaxed),
+      .seeks = seeks.load(kRelaxed),
+      .footer_reads = footer_reads.load(kRelaxed),
+      .footer_read_nanos = footer_read_nanos.load(kRelaxed),
+      .footer_parse_nanos = footer_parse_nanos.load(kRelaxed),
+      .footer_index_loads = footer_index_loads.load(kRelaxed),
+      .metadata_cache_hits = metadata_cache_hits.load(kRelaxed),
+      .dictionary_cache_hits = dictionary_cache_hits.load(kRelaxed),
+      .blobs_read = blobs_read.load(kRelaxed),
+      .decompression = Snapshot(decompression),
+  };
+}
+
+WriterStats WriterCounters::snapshot() const {
+  return WriterStats{
+      .bytes_written = bytes_written.load(kRelaxed),
+      .write_calls = write_calls.load(kRelaxed),
+      .blobs_written = blobs_written.load(kRelaxed),
+      .compression = Snapshot(compression),
+  };
+}
+
+}  // namespace internal
+}  // namespace icypuff
@@ -0,0 +1,39 @@
+#include "icypuff/tracing.h"
+
+#include <atomic>
+
+namespace icypuff {
+
+namespace {
+
+std::atomic<Tracer*> global_tracer{nullptr};
+
+}  // namespace
+
+std::string_view GetSpanName(SpanKind kind) {
+  switch (kind) {
+    case SpanKind::kFooterRead:
+      return "icypuff.footer_read";
+    case SpanKind::kFooterParse:
+      return "icypuff.footer_parse";
+    case SpanKind::kBlobRead:
+      return "icypuff.blob_read";
+    case SpanKind::kDecompress:
+      return "icypuff.decompress";
+    case SpanKind::kCompress:
+      return "icypuff.compress";
+    case SpanKind::kBlobWrite:
+      return "icypuff.blob_write";
+    case SpanKind::kClose:
+      return "icypuff.close";
+  }
+  return "icypuff.unknown";
+}
+
+void SetTracer(Tracer* tracer) {
+  global_tracer.store(tracer, std::memory_order_release);
+}
+
+Tracer* GetTracer() { return global_tracer.load(std::memory_order_acquire); }
+
+}  // namespace icypuff
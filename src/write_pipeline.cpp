@@ -0,0 +1,202 @@
+#include "icypuff/write_pipeline.h"
+
+#include <algorithm>
+
+#include "icypuff/logging.h"
+
+namespace icypuff {
+
+struct WritePipeline::Entry {
+  // Submission order, the order blobs are written in
+  uint64_t position = 0;
+  PipelineBlob blob;
+  // Bytes counted against max_buffered_bytes
+  int64_t buffered = 0;
+  // Not compressed when an earlier error drops the blob
+  Result<CompressedBlob> compressed{ErrorCode::kInvalidState,
+                                    "Blob was not compressed"};
+};
+
+Result<std::unique_ptr<WritePipeline>> WritePipeline::Create(
+    IcypuffWriter& writer, WritePipelineParams params) {
+  if (params.max_buffered_bytes <= 0) {
+    return {ErrorCode::kInvalidArgument, "Buffer limit must be positive"};
+  }
+  int threads = params.threads > 0
+                    ? params.threads
+                    : static_cast<int>(std::thread::hardware_concurrency());
+  threads = std::max(threads, 1);
+
+  std::unique_ptr<WritePipeline> pipeline(new WritePipeline(writer, params));
+  pipeline->threads_.reserve(threads);
+  for (int t = 0; t < threads; t++) {
+    pipeline->threads_.emplace_back([p = pipeline.get()]() { p->run(); });
+  }
+  ICYPUFF_LOG_DEBUG("Started write pipeline with {} threads", threads);
+  return pipeline;
+}
+
+WritePipeline::WritePipeline(IcypuffWriter& writer, WritePipelineParams params)
+    : writer_(writer), params_(params) {}
+
+WritePipeline::~WritePipeline() {
+  auto result = finish();
+  if (!result.ok()) {
+    ICYPUFF_LOG_WARN("Write pipeline finished with error: {}",
+                     result.error().message);
+  }
+}
+
+Result<void> WritePipeline::submit(PipelineBlob blob) {
+  return accept(blob, true);
+}
+
+Result<void> WritePipeline::try_submit(PipelineBlob&& blob) {
+  return accept(blob, false);
+}
+
+Result<void> WritePipeline::accept(PipelineBlob& blob, bool wait) {
+  int64_t bytes = static_cast<int64_t>(blob.data.size());
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!error_ && !stopping_ && !fits(bytes)) {
+    if (!wait) {
+      stats_.would_block++;
+      return {ErrorCode::kWouldBlock, "Write pipeline buffer is full"};
+    }
+    stats_.blocked_submits++;
+    space_available_.wait(
+        lock, [&]() { return error_ || stopping_ || fits(bytes); });
+  }
+  if (error_) {
+    return {error_->code, error_->message};
+  }
+  if (stopping_) {
+    return {ErrorCode::kInvalidState, "Write pipeline is finished"};
+  }
+
+  auto entry = std::make_unique<Entry>();
+  entry->position = next_position_++;
+  entry->blob = std::move(blob);
+  entry->buffered = bytes;
+  buffered_bytes_ += bytes;
+  stats_.peak_buffered_bytes =
+      std::max(stats_.peak_buffered_bytes, buffered_bytes_);
+  stats_.blobs_submitted++;
+  queue_.push_back(std::move(entry));
+  lock.unlock();
+  work_available_.notify_one();
+  return Result<void>();
+}
+
+bool WritePipeline::fits(int64_t bytes) const {
+  return buffered_bytes_ == 0 ||
+         buffered_bytes_ + bytes <= params_.max_buffered_bytes;
+}
+
+Result<void> WritePipeline::finish() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  work_available_.notify_all();
+  space_available_.notify_all();
+  // Threads exit once the queue is empty, and the last blob compressed is
+  // written before its thread exits
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+  threads_.clear();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (error_) {
+    return {error_->code, error_->message};
+  }
+  return Result<void>();
+}
+
+WritePipelineStats WritePipeline::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void WritePipeline::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    work_available_.wait(lock,
+                         [&]() { return !queue_.empty() || stopping_; });
+    if (queue_.empty()) {
+      return;
+    }
+    auto entry = std::move(queue_.front());
+    queue_.pop_front();
+
+    // After an error blobs are only passed on to release their bytes
+    if (!error_) {
+      lock.unlock();
+      const PipelineBlob& blob = entry->blob;
+      entry->compressed = writer_.compress_blob(
+          blob.data.data(), blob.data.size(), blob.type, blob.compression);
+      std::vector<uint8_t>().swap(entry->blob.data);
+      lock.lock();
+      if (entry->compressed.ok()) {
+        auto compressed_bytes =
+            static_cast<int64_t>(entry->compressed.value().data.size());
+        buffered_bytes_ += compressed_bytes - entry->buffered;
+        entry->buffered = compressed_bytes;
+        stats_.peak_buffered_bytes =
+            std::max(stats_.peak_buffered_bytes, buffered_bytes_);
+        space_available_.notify_all();
+      }
+    }
+    compressed_.emplace(entry->position, std::move(entry));
+    if (!committing_) {
+      commit_ready(lock);
+    }
+  }
+}
+
+void WritePipeline::commit_ready(std::unique_lock<std::mutex>& lock) {
+  // One thread writes at a time, taking over blobs compressed meanwhile
+  committing_ = true;
+  while (!compressed_.empty() && compressed_.begin()->first == next_commit_) {
+    auto entry = std::move(compressed_.begin()->second);
+    compressed_.erase(compressed_.begin());
+    int64_t buffered = entry->buffered;
+    if (!error_ && !entry->compressed.ok()) {
+      fail(entry->compressed.error());
+    }
+    if (!error_) {
+      lock.unlock();
+      const PipelineBlob& blob = entry->blob;
+      const CompressedBlob& compressed = entry->compressed.value();
+      auto properties = blob.properties;
+      properties.insert(compressed.properties.begin(),
+                        compressed.properties.end());
+      auto written = writer_.write_blob_precompressed(
+          compressed.data.data(), compressed.data.size(), compressed.codec,
+          blob.type, blob.fields, blob.snapshot_id, blob.sequence_number,
+          properties);
+      entry.reset();
+      lock.lock();
+      if (written.ok()) {
+        stats_.blobs_written++;
+      } else {
+        fail(written.error());
+      }
+    }
+    buffered_bytes_ -= buffered;
+    next_commit_++;
+    space_available_.notify_all();
+  }
+  committing_ = false;
+}
+
+void WritePipeline::fail(const ResultError& error) {
+  if (!error_) {
+    ICYPUFF_LOG_WARN("Write pipeline failed, dropping later blobs: {}",
+                     error.message);
+    error_ = error;
+  }
+}
+
+}  // namespace icypuff
@@ -0,0 +1,80 @@
+#include "icypuff/zstd_dictionary.h"
+
+#include <zdict.h>
+
+#include "icypuff/logging.h"
+
+namespace icypuff {
+
+Result<std::vector<uint8_t>> TrainZstdDictionary(
+    const std::vector<std::vector<uint8_t>>& samples, size_t capacity) {
+  if (samples.empty()) {
+    return {ErrorCode::kInvalidArgument, "No samples to train dictionary"};
+  }
+  if (capacity == 0) {
+    return {ErrorCode::kInvalidArgument,
+            "Dictionary capacity must be positive"};
+  }
+
+  // ZDICT expects all samples concatenated into one buffer
+  std::vector<uint8_t> samples_buffer;
+  std::vector<size_t> sample_sizes;
+  sample_sizes.reserve(samples.size());
+  for (const auto& sample : samples) {
+    samples_buffer.insert(samples_buffer.end(), sample.begin(), sample.end());
+    sample_sizes.push_back(sample.size());
+  }
+
+  std::vector<uint8_t> dictionary(capacity);
+  size_t result = ZDICT_trainFromBuffer(
+      dictionary.data(), dictionary.size(), samples_buffer.data(),
+      sample_sizes.data(), static_cast<unsigned>(sample_sizes.size()));
+  if (ZDICT_isError(result)) {
+    ICYPUFF_LOG_ERROR("Zstd dictionary training failed: {}",
+                      ZDICT_getErrorName(result));
+    return {ErrorCode::kCompressionError, "Zstd dictionary training failed"};
+  }
+
+  dictionary.resize(result);
+  ICYPUFF_LOG_DEBUG("Trained Zstd dictionary of {} bytes from {} samples",
+                    dictionary.size(), samples.size());
+  return dictionary;
+}
+
+uint32_t GetZstdDictionaryId(const std::vector<uint8_t>& dictionary) {
+  return ZDICT_getDictID(dictionary.data(), dictionary.size());
+}
+
+Result<std::unique_ptr<ZstdCompressionDictionary>>
+ZstdCompressionDictionary::Create(const std::vector<uint8_t>& dictionary,
+                                  int compression_level) {
+  uint32_t id = GetZstdDictionaryId(dictionary);
+  if (id == 0) {
+    return {ErrorCode::kInvalidArgument, "Invalid Zstd dictionary"};
+  }
+
+  ZSTD_CDict* dict = ZSTD_createCDict(dictionary.data(), dictionary.size(),
+                                      compression_level);
+  if (dict == nullptr) {
+    return {ErrorCode::kCompressionError,
+            "Failed to create Zstd compression dictionary"};
+  }
+  return std::make_unique<ZstdCompressionDictionary>(dict, id);
+}
+
+Result<std::unique_ptr<ZstdDecompressionDictionary>>
+ZstdDecompressionDictionary::Create(const std::vector<uint8_t>& dictionary) {
+  uint32_t id = GetZstdDictionaryId(dictionary);
+  if (id == 0) {
+    return {ErrorCode::kInvalidArgument, "Invalid Zstd dictionary"};
+  }
+
+  ZSTD_DDict* dict = ZSTD_createDDict(dictionary.data(), dictionary.size());
+  if (dict == nullptr) {
+    return {ErrorCode::kDecompressionError,
+            "Failed to create Zstd decompression dictionary"};
+  }
+  return std::make_unique<ZstdDecompressionDictionary>(dict, id);
+}
+
+}  // namespace icypuff
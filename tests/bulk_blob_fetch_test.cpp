@@ -0,0 +1,207 @@
+#include "icypuff/bulk_blob_fetch.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "icypuff/blob_metadata.h"
+#include "icypuff/icypuff.h"
+#include "icypuff/icypuff_reader.h"
+#include "icypuff/memory_input_file.h"
+#include "icypuff/memory_output_file.h"
+#include "icypuff/puffin_table_index.h"
+
+namespace icypuff {
+namespace {
+
+TEST(BulkBlobFetchTest, FetchesAcrossFiles) {
+  // Blobs alternate codecs so decoding goes through each of them
+  const CompressionCodec codecs[] = {CompressionCodec::None,
+                                     CompressionCodec::Lz4,
+                                     CompressionCodec::Zstd};
+  std::vector<std::shared_ptr<std::vector<uint8_t>>> buffers;
+  std::vector<std::vector<std::string>> contents;
+  for (int f = 0; f < 12; f++) {
+    auto buffer = std::make_shared<std::vector<uint8_t>>();
+    auto writer_result =
+        Icypuff::write(std::make_unique<MemoryOutputFile>(buffer)).build();
+    ASSERT_TRUE(writer_result.ok()) << writer_result.error().message;
+    auto writer = std::move(writer_result).value();
+    contents.emplace_back();
+    for (int b = 0; b < 20; b++) {
+      std::string data(500 + 37 * b, static_cast<char>('a' + (f + b) % 26));
+      data += std::to_string(f * 100 + b);
+      ASSERT_TRUE(writer
+                      ->write_blob(reinterpret_cast<const uint8_t*>(
+                                       data.data()),
+                                   data.size(), "sketch", {b}, f, f,
+                                   codecs[b % 3])
+                      .ok());
+      contents.back().push_back(data);
+    }
+    ASSERT_TRUE(writer->close().ok());
+    buffers.push_back(buffer);
+  }
+
+  std::vector<std::unique_ptr<InputFile>> files;
+  for (const auto& buffer : buffers) {
+    files.push_back(std::make_unique<MemoryInputFile>(*buffer));
+  }
+  auto index_result = PuffinTableIndex::Create(std::move(files));
+  ASSERT_TRUE(index_result.ok()) << index_result.error().message;
+  auto& index = *index_result.value();
+
+  std::vector<IndexedBlob> wanted;
+  for (size_t f = 0; f < index.file_count(); f++) {
+    for (size_t b = 0; b < index.blobs(f).size(); b++) {
+      wanted.push_back({f, b, index.blobs(f)[b].get()});
+    }
+  }
+
+  auto reader_totals = [&]() {
+    ReaderStats total;
+    for (size_t f = 0; f < index.file_count(); f++) {
+      ReaderStats file_stats = index.reader(f).stats();
+      total.read_calls += file_stats.read_calls;
+      total.bytes_read += file_stats.bytes_read;
+      total.blobs_read += file_stats.blobs_read;
+    }
+    return total;
+  };
+  ReaderStats before = reader_totals();
+
+  // The limit holds only a few reads, so workers wait on each other
+  BulkFetchParams params;
+  params.threads = 4;
+  params.max_in_flight_bytes = 8 << 10;
+  std::mutex mutex;
+  std::vector<std::string> fetched(wanted.size());
+  int errors = 0;
+  auto stats = index.fetch_blobs(
+      wanted,
+      [&](size_t i, Result<std::vector<uint8_t>> data) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!data.ok()) {
+          errors++;
+          return;
+        }
+        fetched[i].assign(data.value().begin(), data.value().end());
+      },
+      params);
+  ASSERT_TRUE(stats.ok()) << stats.error().message;
+  EXPECT_EQ(errors, 0);
+  for (size_t i = 0; i < wanted.size(); i++) {
+    EXPECT_EQ(fetched[i], contents[wanted[i].file_index][wanted[i].blob_index]);
+  }
+  EXPECT_EQ(stats.value().blobs, static_cast<int64_t>(wanted.size()));
+  EXPECT_EQ(stats.value().failures, 0);
+  // Adjacent blobs of a file share reads
+  EXPECT_LT(stats.value().reads, static_cast<int64_t>(wanted.size()));
+  EXPECT_LE(stats.value().peak_in_flight_bytes, params.max_in_flight_bytes);
+
+  // Coalesced reads are counted by the readers they go through
+  ReaderStats after = reader_totals();
+  EXPECT_EQ(after.read_calls - before.read_calls, stats.value().reads);
+  EXPECT_EQ(after.bytes_read - before.bytes_read, stats.value().bytes_read);
+  EXPECT_EQ(after.blobs_read - before.blobs_read,
+            static_cast<int64_t>(wanted.size()));
+
+  // Closed readers fail their blobs
+  IcypuffReader closed_reader(std::make_unique<MemoryInputFile>(*buffers[0]));
+  ASSERT_TRUE(closed_reader.close().ok());
+  std::vector<BlobFetchRequest> closed_requests = {
+      {&closed_reader, wanted[0].metadata}};
+  auto closed_stats = FetchBlobs(
+      closed_requests,
+      [](size_t, Result<std::vector<uint8_t>> data) {
+        EXPECT_FALSE(data.ok());
+      },
+      params);
+  ASSERT_TRUE(closed_stats.ok());
+  EXPECT_EQ(closed_stats.value().failures, 1);
+
+  // Raw fetches hand over the stored bytes
+  params.raw = true;
+  std::vector<BlobFetchRequest> requests = {
+      {&index.reader(1), wanted[21].metadata}};
+  std::vector<uint8_t> raw;
+  ASSERT_TRUE(FetchBlobs(
+                  requests,
+                  [&](size_t, Result<std::vector<uint8_t>> data) {
+                    ASSERT_TRUE(data.ok());
+                    raw = data.value();
+                  },
+                  params)
+                  .ok());
+  auto expected = index.reader(1).read_blob_raw(*wanted[21].metadata);
+  ASSERT_TRUE(expected.ok());
+  EXPECT_EQ(raw, expected.value().data);
+
+  // A blob larger than the limit is read alone, so it is the only read that
+  // takes the bytes in flight over the limit
+  BulkFetchParams tight;
+  tight.threads = 4;
+  tight.max_in_flight_bytes = 600;
+  int64_t largest = 0;
+  for (const auto& blob : wanted) {
+    largest = std::max(largest, blob.metadata->length());
+  }
+  ASSERT_GT(largest, tight.max_in_flight_bytes);
+  std::atomic<int> tight_errors{0};
+  auto tight_stats = index.fetch_blobs(
+      wanted,
+      [&](size_t, Result<std::vector<uint8_t>> data) {
+        tight_errors += data.ok() ? 0 : 1;
+      },
+      tight);
+  ASSERT_TRUE(tight_stats.ok()) << tight_stats.error().message;
+  EXPECT_EQ(tight_errors.load(), 0);
+  EXPECT_EQ(tight_stats.value().blobs, static_cast<int64_t>(wanted.size()));
+  EXPECT_LE(tight_stats.value().peak_in_flight_bytes,
+            std::max(tight.max_in_flight_bytes, largest));
+
+  // A failed read fails each blob it covers exactly once
+  int64_t file_length = static_cast<int64_t>(buffers[2]->size());
+  std::vector<std::unique_ptr<BlobMetadata>> past_end;
+  for (int64_t i = 0; i < 3; i++) {
+    BlobMetadataParams blob_params;
+    blob_params.type = "sketch";
+    blob_params.input_fields = {1};
+    blob_params.snapshot_id = 0;
+    blob_params.sequence_number = 0;
+    blob_params.offset = file_length - 20 + 10 * i;
+    blob_params.length = 10;
+    auto blob = BlobMetadata::Create(blob_params);
+    ASSERT_TRUE(blob.ok()) << blob.error().message;
+    past_end.push_back(std::move(blob).value());
+  }
+  std::vector<BlobFetchRequest> failing;
+  for (const auto& blob : past_end) {
+    failing.push_back({&index.reader(2), blob.get()});
+  }
+  std::vector<int> deliveries(failing.size());
+  std::vector<int> failed(failing.size());
+  auto failing_stats = FetchBlobs(
+      failing,
+      [&](size_t i, Result<std::vector<uint8_t>> data) {
+        std::lock_guard<std::mutex> lock(mutex);
+        deliveries[i]++;
+        failed[i] += data.ok() ? 0 : 1;
+      },
+      params);
+  ASSERT_TRUE(failing_stats.ok()) << failing_stats.error().message;
+  // The blobs are adjacent, so one read covers them all
+  EXPECT_EQ(failing_stats.value().reads, 1);
+  EXPECT_EQ(failing_stats.value().failures, 3);
+  EXPECT_EQ(deliveries, std::vector<int>(failing.size(), 1));
+  EXPECT_EQ(failed, std::vector<int>(failing.size(), 1));
+}
+
+}  // namespace
+}  // namespace icypuff
@@ -0,0 +1,132 @@
+#include "icypuff/file_handle_cache.h"
+
+#include <gtest/gtest.h>
+#include <spdlog/spdlog.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "icypuff/format_constants.h"
+#include "icypuff/icypuff.h"
+#include "icypuff/icypuff_reader.h"
+#include "icypuff/local_input_file.h"
+#include "icypuff/local_output_file.h"
+#include "test_resources.h"
+
+namespace icypuff {
+namespace {
+
+using ::icypuff::testing::ScratchDirectory;
+
+class FileHandleCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // Initialize logging
+    spdlog::set_level(spdlog::level::debug);
+    spdlog::set_pattern("[%H:%M:%S.%e] [%^%l%$] [%s:%#] %v");
+  }
+};
+
+TEST_F(FileHandleCacheTest, ReusesDescriptors) {
+  ScratchDirectory scratch;
+  std::vector<std::string> paths;
+  for (int i = 0; i < 3; i++) {
+    std::string filename = "handle-cache-" + std::to_string(i) + ".bin";
+    auto writer_result =
+        Icypuff::write(scratch.CreateOutputFile(filename)).build();
+    ASSERT_TRUE(writer_result.ok()) << writer_result.error().message;
+    auto writer = std::move(writer_result).value();
+    std::string data = "blob " + std::to_string(i);
+    ASSERT_TRUE(writer
+                    ->write_blob(reinterpret_cast<const uint8_t*>(data.data()),
+                                 data.size(), "sketch", {1})
+                    .ok());
+    ASSERT_TRUE(writer->close().ok());
+    paths.push_back(scratch.GetPath(filename));
+  }
+
+  FileHandleCacheParams params;
+  params.max_open_handles = 2;
+  auto cache_result = FileHandleCache::Create(params);
+  ASSERT_TRUE(cache_result.ok()) << cache_result.error().message;
+  auto& cache = *cache_result.value();
+
+  auto read_first_blob = [&](const std::string& path) {
+    IcypuffReader reader(std::make_unique<LocalInputFile>(path, &cache));
+    auto blobs = reader.get_blobs();
+    if (!blobs.ok()) {
+      return std::string();
+    }
+    auto data = reader.read_blob(*blobs.value()[0]);
+    return data.ok() ? std::string(data.value().begin(), data.value().end())
+                     : std::string();
+  };
+
+  // A file leases its descriptor once for all its reads, and files opened
+  // later reuse it
+  EXPECT_EQ(read_first_blob(paths[0]), "blob 0");
+  EXPECT_EQ(cache.stats().misses, 1);
+  EXPECT_EQ(cache.stats().hits, 0);
+  EXPECT_EQ(read_first_blob(paths[0]), "blob 0");
+  EXPECT_EQ(cache.stats().misses, 1);
+  EXPECT_EQ(cache.stats().hits, 1);
+
+  // The least recently used idle descriptor is closed at the limit
+  EXPECT_EQ(read_first_blob(paths[1]), "blob 1");
+  EXPECT_EQ(read_first_blob(paths[2]), "blob 2");
+  EXPECT_EQ(cache.stats().open_handles, 2);
+  EXPECT_EQ(cache.stats().evictions, 1);
+  EXPECT_EQ(read_first_blob(paths[0]), "blob 0");
+  EXPECT_EQ(cache.stats().misses, 4);
+
+  // Streams in use are never closed, idle ones go once they are released
+  std::vector<std::unique_ptr<InputFile>> files;
+  std::vector<std::unique_ptr<SeekableInputStream>> streams;
+  for (const auto& path : paths) {
+    files.push_back(std::make_unique<LocalInputFile>(path, &cache));
+    auto stream = files.back()->new_stream();
+    ASSERT_TRUE(stream.ok()) << stream.error().message;
+    streams.push_back(std::move(stream).value());
+  }
+  EXPECT_EQ(cache.stats().open_handles, 3);
+  uint8_t magic[MAGIC_LENGTH];
+  auto read = streams[2]->read(magic, MAGIC_LENGTH);
+  ASSERT_TRUE(read.ok());
+  EXPECT_EQ(read.value(), MAGIC_LENGTH);
+  EXPECT_EQ(std::memcmp(magic, MAGIC, MAGIC_LENGTH), 0);
+  streams.clear();
+  EXPECT_EQ(cache.stats().open_handles, 3);
+  files.clear();
+  EXPECT_EQ(cache.stats().open_handles, 2);
+
+  // A replaced file is reopened by new files, while a file opened before
+  // keeps reading the one it leased
+  LocalInputFile leased(paths[2], &cache);
+  uint8_t leased_magic[MAGIC_LENGTH];
+  ASSERT_TRUE(leased.read_fully(0, leased_magic, MAGIC_LENGTH).ok());
+  int64_t leased_length = leased.length().value();
+  LocalOutputFileOptions options;
+  options.atomic = true;
+  auto writer_result =
+      Icypuff::write(std::make_unique<LocalOutputFile>(paths[2], options))
+          .build();
+  ASSERT_TRUE(writer_result.ok()) << writer_result.error().message;
+  auto writer = std::move(writer_result).value();
+  ASSERT_TRUE(writer
+                  ->write_blob(reinterpret_cast<const uint8_t*>("replaced"), 8,
+                               "sketch", {1})
+                  .ok());
+  ASSERT_TRUE(writer->close().ok());
+  EXPECT_EQ(read_first_blob(paths[2]), "replaced");
+  std::vector<uint8_t> old_tail(MAGIC_LENGTH);
+  ASSERT_TRUE(leased
+                  .read_fully(leased_length - MAGIC_LENGTH, old_tail.data(),
+                              old_tail.size())
+                  .ok());
+  EXPECT_EQ(std::memcmp(old_tail.data(), MAGIC, MAGIC_LENGTH), 0);
+}
+
+}  // namespace
+}  // namespace icypuff
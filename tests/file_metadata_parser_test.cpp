@@ -251,5 +251,85 @@ TEST(FileMetadataParserTest, FieldNumberOutOfRange) {
             "Cannot parse integer from non-int value in fields: 2147483648");
 }
 
+// Reference serialization through the nlohmann DOM
+std::string DomJson(const FileMetadata& metadata, bool pretty) {
+  nlohmann::ordered_json json;
+  json[FileMetadataParser::kBlobs] = nlohmann::ordered_json::array();
+  for (const auto& blob : metadata.blobs()) {
+    nlohmann::ordered_json blob_json;
+    blob_json[FileMetadataParser::kType] = blob->type();
+    blob_json[FileMetadataParser::kFields] = blob->input_fields();
+    blob_json[FileMetadataParser::kSnapshotId] = blob->snapshot_id();
+    blob_json[FileMetadataParser::kSequenceNumber] = blob->sequence_number();
+    blob_json[FileMetadataParser::kOffset] = blob->offset();
+    blob_json[FileMetadataParser::kLength] = blob->length();
+    if (blob->compression_codec()) {
+      blob_json[FileMetadataParser::kCompressionCodec] =
+          *blob->compression_codec();
+    }
+    if (!blob->properties().empty()) {
+      blob_json[FileMetadataParser::kProperties] = blob->properties();
+    }
+    json[FileMetadataParser::kBlobs].push_back(blob_json);
+  }
+  if (!metadata.properties().empty()) {
+    json[FileMetadataParser::kProperties] = metadata.properties();
+  }
+  return pretty ? json.dump(2) : json.dump();
+}
+
+TEST(FileMetadataParserTest, SerializerMatchesDom) {
+  FileMetadataParams file_params;
+  for (int i = 0; i < 5; i++) {
+    BlobMetadataParams params;
+    params.type = i % 2 ? "apache-datasketches-theta-v1" : "quote \" and \\";
+    params.input_fields = {i + 1, -i, INT32_MAX};
+    params.snapshot_id = INT64_MIN + i;
+    params.sequence_number = i;
+    params.offset = 4 + i * 100;
+    params.length = 100;
+    if (i % 3 == 0) {
+      params.compression_codec = "zstd";
+    }
+    if (i > 1) {
+      params.properties = {{"ndv", std::to_string(i * 1000)},
+                           {"control\x01\b\f\n\r\t", "utf-8 \xF0\x9F\xA4\xAF"},
+                           {"del\x7F", ""}};
+    }
+    auto blob = BlobMetadata::Create(params);
+    ASSERT_TRUE(blob.ok());
+    file_params.blobs.push_back(std::move(blob).value());
+  }
+  file_params.properties = {{"created-by", "Test 1234"}, {"a", "b"}};
+  auto metadata = FileMetadata::Create(std::move(file_params));
+  ASSERT_TRUE(metadata.ok());
+
+  for (bool pretty : {false, true}) {
+    auto json_result = FileMetadataParser::ToJson(*metadata.value(), pretty);
+    ASSERT_TRUE(json_result.ok()) << json_result.error().message;
+    EXPECT_EQ(json_result.value(), DomJson(*metadata.value(), pretty));
+  }
+
+  // Empty metadata
+  auto empty = FileMetadata::Create(FileMetadataParams{});
+  ASSERT_TRUE(empty.ok());
+  for (bool pretty : {false, true}) {
+    auto json_result = FileMetadataParser::ToJson(*empty.value(), pretty);
+    ASSERT_TRUE(json_result.ok()) << json_result.error().message;
+    EXPECT_EQ(json_result.value(), DomJson(*empty.value(), pretty));
+  }
+}
+
+TEST(FileMetadataParserTest, SerializerRejectsInvalidUtf8) {
+  FileMetadataParams params;
+  params.properties = {{"bad", "\xC0\xAF"}};
+  auto metadata = FileMetadata::Create(std::move(params));
+  ASSERT_TRUE(metadata.ok());
+
+  auto json_result = FileMetadataParser::ToJson(*metadata.value());
+  ASSERT_FALSE(json_result.ok());
+  EXPECT_EQ(json_result.error().code, ErrorCode::kInvalidArgument);
+}
+
 }  // namespace
-}  // namespace icypuff
\ No newline at end of file
+}  // namespace icypuff
@@ -3,11 +3,18 @@
 #include <gtest/gtest.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "icypuff/blob_index.h"
 #include "icypuff/format_constants.h"
+#include "icypuff/icypuff.h"
+#include "icypuff/memory_input_file.h"
+#include "icypuff/memory_output_file.h"
 #include "test_resources.h"
 
 namespace icypuff {
@@ -235,5 +242,172 @@ TEST_F(IcypuffReaderTest, ValidateFooterSizeValue) {
   EXPECT_EQ(it->second, "Test 1234");
 }
 
+TEST_F(IcypuffReaderTest, BlobIndexReplacesFooterParse) {
+  auto buffer = std::make_shared<std::vector<uint8_t>>();
+  auto builder = Icypuff::write(std::make_unique<MemoryOutputFile>(buffer));
+  builder.created_by("index-test").compress_footer().write_blob_index();
+  auto writer_result = builder.build();
+  ASSERT_TRUE(writer_result.ok()) << writer_result.error().message;
+  auto writer = std::move(writer_result).value();
+  const std::string data(1000, 'x');
+  const std::vector<CompressionCodec> codecs = {
+      CompressionCodec::None, CompressionCodec::Lz4, CompressionCodec::Zstd};
+  for (int i = 0; i < 30; i++) {
+    ASSERT_TRUE(writer
+                    ->write_blob(reinterpret_cast<const uint8_t*>(data.data()),
+                                 data.size(), i % 2 ? "theta" : "bloom",
+                                 {i, i + 1}, 100 + i % 3, i, codecs[i % 3],
+                                 {{"ndv", std::to_string(i)}})
+                    .ok());
+  }
+  ASSERT_TRUE(writer->close().ok());
+
+  // The same file with a damaged trailer is read through the JSON footer
+  auto damaged = *buffer;
+  int64_t data_end =
+      static_cast<int64_t>(damaged.size()) - writer->footer_size().value();
+  damaged[data_end - 1] ^= 0xff;
+
+  auto expect_same_blobs = [](const BlobMetadata& a, const BlobMetadata& b) {
+    EXPECT_EQ(a.type(), b.type());
+    EXPECT_EQ(a.input_fields(), b.input_fields());
+    EXPECT_EQ(a.snapshot_id(), b.snapshot_id());
+    EXPECT_EQ(a.sequence_number(), b.sequence_number());
+    EXPECT_EQ(a.offset(), b.offset());
+    EXPECT_EQ(a.length(), b.length());
+    EXPECT_EQ(a.compression_codec(), b.compression_codec());
+    EXPECT_EQ(a.properties(), b.properties());
+  };
+
+  IcypuffReader indexed(std::make_unique<MemoryInputFile>(*buffer));
+  IcypuffReader parsed(std::make_unique<MemoryInputFile>(damaged));
+  auto indexed_blobs = indexed.get_blobs();
+  auto parsed_blobs = parsed.get_blobs();
+  ASSERT_TRUE(indexed_blobs.ok()) << indexed_blobs.error().message;
+  ASSERT_TRUE(parsed_blobs.ok()) << parsed_blobs.error().message;
+  EXPECT_EQ(indexed.stats().footer_index_loads, 1);
+  EXPECT_EQ(parsed.stats().footer_index_loads, 0);
+  ASSERT_EQ(indexed_blobs.value().size(), 31);
+  ASSERT_EQ(parsed_blobs.value().size(), 31);
+  for (size_t i = 0; i < 31; i++) {
+    expect_same_blobs(*indexed_blobs.value()[i], *parsed_blobs.value()[i]);
+  }
+  EXPECT_EQ(indexed.properties(), parsed.properties());
+  const BlobMetadata& index_blob = *indexed_blobs.value().back();
+  EXPECT_EQ(index_blob.type(), BLOB_INDEX_BLOB_TYPE);
+  EXPECT_EQ(index_blob.input_fields().size(), 31);
+  for (size_t i = 0; i < 30; i += 7) {
+    auto blob = indexed.read_blob(*indexed_blobs.value()[i]);
+    ASSERT_TRUE(blob.ok()) << blob.error().message;
+    EXPECT_EQ(std::string(blob.value().begin(), blob.value().end()), data);
+  }
+
+  // Appending replaces the index in place rather than keeping a stale one
+  {
+    auto append = Icypuff::append(std::make_unique<MemoryInputFile>(*buffer),
+                                  std::make_unique<MemoryOutputFile>(buffer));
+    auto appender = append.build();
+    ASSERT_TRUE(appender.ok()) << appender.error().message;
+    ASSERT_TRUE(appender.value()
+                    ->write_blob(reinterpret_cast<const uint8_t*>("new"), 3,
+                                 "theta", {99}, 200, 50)
+                    .ok());
+    ASSERT_TRUE(appender.value()->close().ok());
+  }
+  IcypuffReader appended(std::make_unique<MemoryInputFile>(*buffer));
+  auto appended_blobs = appended.get_blobs();
+  ASSERT_TRUE(appended_blobs.ok()) << appended_blobs.error().message;
+  EXPECT_EQ(appended.stats().footer_index_loads, 1);
+  ASSERT_EQ(appended_blobs.value().size(), 32);
+  EXPECT_EQ(appended_blobs.value()[30]->input_fields(), std::vector<int>{99});
+  EXPECT_EQ(appended_blobs.value()[30]->offset(), index_blob.offset());
+  EXPECT_EQ(appended_blobs.value()[31]->type(), BLOB_INDEX_BLOB_TYPE);
+  EXPECT_EQ(appended_blobs.value()[31]->offset(), index_blob.offset() + 3);
+
+  // Merging drops the index blobs of the inputs
+  auto merged = std::make_shared<std::vector<uint8_t>>();
+  auto merge = Icypuff::merge(std::make_unique<MemoryOutputFile>(merged));
+  merge.add_input(std::make_unique<MemoryInputFile>(*buffer));
+  merge.add_input(std::make_unique<MemoryInputFile>(damaged));
+  auto merger = merge.build();
+  ASSERT_TRUE(merger.ok()) << merger.error().message;
+  auto summary = merger.value()->merge();
+  ASSERT_TRUE(summary.ok()) << summary.error().message;
+  EXPECT_EQ(summary.value().blobs_copied, 61);
+  IcypuffReader merged_reader(std::make_unique<MemoryInputFile>(*merged));
+  auto merged_blobs = merged_reader.get_blobs();
+  ASSERT_TRUE(merged_blobs.ok()) << merged_blobs.error().message;
+  EXPECT_EQ(merged_reader.stats().footer_index_loads, 0);
+  EXPECT_EQ(std::count_if(merged_blobs.value().begin(),
+                          merged_blobs.value().end(),
+                          [](const auto& blob) {
+                            return blob->type() == BLOB_INDEX_BLOB_TYPE;
+                          }),
+            0);
+}
+
+TEST_F(IcypuffReaderTest, SharedReaderConcurrentReads) {
+  std::vector<std::vector<uint8_t>> samples;
+  for (int i = 0; i < 200; i++) {
+    std::string sketch = "{\"sketch\":\"theta\",\"entries\":[" +
+                         std::to_string(i * 7919) + "," +
+                         std::to_string(i * 104729) + "]}";
+    samples.emplace_back(sketch.begin(), sketch.end());
+  }
+
+  auto buffer = std::make_shared<std::vector<uint8_t>>();
+  auto writer_result =
+      Icypuff::write(std::make_unique<MemoryOutputFile>(buffer))
+          .compress_blobs(CompressionCodec::Zstd)
+          .build();
+  ASSERT_TRUE(writer_result.ok()) << writer_result.error().message;
+  auto writer = std::move(writer_result).value();
+  ASSERT_TRUE(writer->train_zstd_dictionary("sketch", samples, {1}).ok());
+  for (int i = 0; i < 32; i++) {
+    ASSERT_TRUE(writer
+                    ->write_blob(samples[i].data(), samples[i].size(),
+                                 "sketch", {1}, 1, 1)
+                    .ok());
+  }
+  ASSERT_TRUE(writer->close().ok());
+
+  // One reader shared by every thread, none of which loads the footer first
+  IcypuffReader reader(std::make_unique<MemoryInputFile>(*buffer));
+  constexpr int kThreads = 8;
+  std::atomic<int> mismatches{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&, t]() {
+      auto blobs = reader.get_blobs();
+      if (!blobs.ok()) {
+        mismatches++;
+        return;
+      }
+      // Blob 0 is the dictionary, the sketches follow in write order
+      for (size_t i = 1 + t; i < blobs.value().size(); i++) {
+        auto data = reader.read_blob(*blobs.value()[i]);
+        if (!data.ok() || data.value() != samples[i - 1]) {
+          mismatches++;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(mismatches.load(), 0);
+
+  auto stats = reader.stats();
+  EXPECT_EQ(stats.footer_reads, 1);
+  EXPECT_EQ(stats.metadata_cache_hits, kThreads - 1);
+  EXPECT_EQ(stats.read_calls, stats.seeks);
+
+  // A closed reader keeps its footer but refuses further reads
+  auto blobs = reader.get_blobs();
+  ASSERT_TRUE(blobs.ok());
+  ASSERT_TRUE(reader.close().ok());
+  EXPECT_FALSE(reader.read_blob(*blobs.value()[1]).ok());
+}
+
 }  // namespace
 }  // namespace icypuff
@@ -0,0 +1,121 @@
+#include "icypuff/icypuff_verifier.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "icypuff/icypuff.h"
+#include "icypuff/icypuff_reader.h"
+#include "icypuff/memory_input_file.h"
+#include "icypuff/memory_output_file.h"
+
+namespace icypuff {
+namespace {
+
+TEST(IcypuffVerifierTest, VerifyDetectsCorruption) {
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<> dis(0, 99999);
+  std::vector<std::vector<uint8_t>> samples;
+  for (int i = 0; i < 300; i++) {
+    std::string sketch = "{\"sketch\":\"theta\",\"lg_k\":12,\"entries\":[";
+    for (int j = 0; j < 8; j++) {
+      sketch += std::to_string(dis(gen)) + ",";
+    }
+    sketch += "0]}";
+    samples.emplace_back(sketch.begin(), sketch.end());
+  }
+  std::vector<uint8_t> large(256 << 10);
+  for (auto& byte : large) {
+    byte = static_cast<uint8_t>(dis(gen) % 16);
+  }
+
+  auto buffer = std::make_shared<std::vector<uint8_t>>();
+  auto writer_result =
+      Icypuff::write(std::make_unique<MemoryOutputFile>(buffer))
+          .compress_blobs(CompressionCodec::Zstd)
+          .build();
+  ASSERT_TRUE(writer_result.ok()) << writer_result.error().message;
+  auto writer = std::move(writer_result).value();
+  auto dictionary = writer->train_zstd_dictionary("sketch", samples, {1});
+  ASSERT_TRUE(dictionary.ok()) << dictionary.error().message;
+  int64_t expected_bytes = dictionary.value()->length();
+  for (int i = 0; i < 10; i++) {
+    ASSERT_TRUE(writer
+                    ->write_blob(samples[i].data(), samples[i].size(),
+                                 "sketch", {1}, 1, 1)
+                    .ok());
+    expected_bytes += static_cast<int64_t>(samples[i].size());
+  }
+  ASSERT_TRUE(writer
+                  ->write_blob(large.data(), large.size(), "large", {2}, 1, 1,
+                               CompressionCodec::Lz4)
+                  .ok());
+  ASSERT_TRUE(writer
+                  ->write_blob(large.data(), large.size(), "large", {2}, 1, 1,
+                               CompressionCodec::Zstd)
+                  .ok());
+  ASSERT_TRUE(writer
+                  ->write_blob(large.data(), 100, "raw", {3}, 1, 1,
+                               CompressionCodec::None)
+                  .ok());
+  expected_bytes += static_cast<int64_t>(2 * large.size() + 100);
+  ASSERT_TRUE(writer->close().ok());
+
+  IcypuffReader reader(std::make_unique<MemoryInputFile>(*buffer));
+  auto blobs_result = reader.get_blobs();
+  ASSERT_TRUE(blobs_result.ok()) << blobs_result.error().message;
+  const auto& blobs = blobs_result.value();
+  ASSERT_EQ(blobs.size(), 14);
+
+  IcypuffVerifierParams params;
+  params.threads = 4;
+  // Small reads so the blobs are spread over the workers
+  params.max_read_size = 4096;
+  auto verify = [&](const std::vector<uint8_t>& file) {
+    IcypuffVerifier verifier(std::make_unique<MemoryInputFile>(file), params);
+    auto report = verifier.verify();
+    EXPECT_TRUE(report.ok()) << report.error().message;
+    return report.ok() ? std::move(report).value() : VerificationReport{};
+  };
+
+  auto report = verify(*buffer);
+  EXPECT_TRUE(report.ok()) << report.issues.front().message;
+  EXPECT_EQ(report.blobs_checked, 14);
+  EXPECT_EQ(report.uncompressed_bytes, expected_bytes);
+  EXPECT_GT(report.reads, 1);
+
+  // The last bytes of an LZ4 frame are its content checksum
+  auto corrupted = *buffer;
+  corrupted[blobs[11]->offset() + blobs[11]->length() - 1] ^= 0xff;
+  report = verify(corrupted);
+  ASSERT_EQ(report.issues.size(), 1);
+  EXPECT_EQ(report.issues[0].blob_index, 11);
+
+  // Blobs compressed with the dictionary are decoded with it
+  corrupted = *buffer;
+  corrupted[blobs[3]->offset() + blobs[3]->length() / 2] ^= 0xff;
+  corrupted[blobs[12]->offset() + blobs[12]->length() / 2] ^= 0xff;
+  report = verify(corrupted);
+  ASSERT_EQ(report.issues.size(), 2);
+  EXPECT_EQ(report.issues[0].blob_index, 3);
+  EXPECT_EQ(report.issues[1].blob_index, 12);
+
+  corrupted = *buffer;
+  corrupted[0] = 'X';
+  report = verify(corrupted);
+  ASSERT_EQ(report.issues.size(), 1);
+  EXPECT_EQ(report.issues[0].blob_index, -1);
+
+  // A truncated file fails its footer checks
+  corrupted.assign(buffer->begin(), buffer->end() - 3);
+  report = verify(corrupted);
+  ASSERT_FALSE(report.ok());
+  EXPECT_EQ(report.issues[0].blob_index, -1);
+}
+
+}  // namespace
+}  // namespace icypuff
@@ -2,39 +2,108 @@
 
 #include <gtest/gtest.h>
 #include <spdlog/spdlog.h>
+#include <zstd.h>
 
+#include <algorithm>
+#include <coroutine>
+#include <filesystem>
+#include <latch>
 #include <memory>
 #include <random>
+#include <span>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "icypuff/async.h"
+#include "icypuff/format_constants.h"
 #include "icypuff/icypuff.h"
+#include "icypuff/icypuff_reader.h"
+#include "icypuff/memory_input_file.h"
+#include "icypuff/memory_output_file.h"
+#include "icypuff/synthetic_dataset.h"
+#include "icypuff/tracing.h"
+#include "icypuff/zstd_dictionary.h"
 #include "test_resources.h"
 
 namespace icypuff {
 namespace {
 
+using ::icypuff::testing::generate_uuid;
+using ::icypuff::testing::ScratchDirectory;
 using ::icypuff::testing::TestResources;
 
 // Test constants
 constexpr int EMPTY_PUFFIN_UNCOMPRESSED_FOOTER_SIZE =
     28;  // 4 (magic) + 4 (payload size) + 4 (flags) + 4 (magic) + 12 (payload)
 
-// Helper function to generate a random 8 character ID
-std::string generate_uuid() {
-  static std::random_device rd;
-  static std::mt19937 gen(rd());
-  static std::uniform_int_distribution<> dis(0, 15);
-  static const char* digits = "0123456789abcdef";
+// Coroutine that starts eagerly and frees itself when done, enough to
+// drive the awaitable calls
+struct DetachedCoroutine {
+  struct promise_type {
+    DetachedCoroutine get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
 
-  std::string id;
-  id.reserve(8);
+struct AsyncRoundTrip {
+  std::vector<std::string> blobs;
+  std::string error;
+  bool ran_off_caller_thread = true;
+  bool resumed_on_loop = false;
+};
 
-  for (int i = 0; i < 8; i++) {
-    id += digits[dis(gen)];
+DetachedCoroutine WriteAndReadAsync(Executor& io, Executor& loop,
+                                    std::thread::id caller,
+                                    std::thread::id loop_thread,
+                                    AsyncRoundTrip& out, std::latch& done) {
+  auto buffer = std::make_shared<std::vector<uint8_t>>();
+  auto writer_result =
+      Icypuff::write(std::make_unique<MemoryOutputFile>(buffer))
+          .compress_blobs(CompressionCodec::Zstd)
+          .build();
+  if (!writer_result.ok()) {
+    out.error = writer_result.error().message;
+    done.count_down();
+    co_return;
+  }
+  auto writer = std::move(writer_result).value();
+  // Arguments are built up front, GCC 12 cannot keep literal temporaries
+  // alive across a suspension
+  const std::vector<std::string> sketches = {"first sketch", "second sketch"};
+  const std::string type = "sketch";
+  const std::vector<int> fields = {1};
+  for (const std::string& data : sketches) {
+    auto blob = co_await writer->write_blob_async(
+        io, reinterpret_cast<const uint8_t*>(data.data()), data.size(), type,
+        fields);
+    out.ran_off_caller_thread &= std::this_thread::get_id() != caller;
+    if (!blob.ok()) {
+      out.error = blob.error().message;
+    }
+  }
+  auto closed = co_await writer->close_async(io);
+  if (!closed.ok()) {
+    out.error = closed.error().message;
+  }
+
+  IcypuffReader reader(std::make_unique<MemoryInputFile>(buffer));
+  auto blobs = co_await reader.get_blobs_async(io);
+  if (blobs.ok()) {
+    for (const auto& blob : blobs.value()) {
+      auto data = co_await reader.read_blob_async(io, *blob);
+      if (data.ok()) {
+        out.blobs.emplace_back(data.value().begin(), data.value().end());
+      }
+    }
   }
 
-  return id;
+  co_await ResumeOn(loop);
+  out.resumed_on_loop = std::this_thread::get_id() == loop_thread;
+  done.count_down();
 }
 
 class IcypuffWriterTest : public ::testing::Test {
@@ -286,5 +355,927 @@ TEST_F(IcypuffWriterTest, WriteMetricDataCompressedZstd) {
   }
 }
 
+TEST_F(IcypuffWriterTest, ZstdDictionaryRoundTrip) {
+  // Many small blobs sharing the same structure, like serialized sketches
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<> dis(0, 99999);
+  std::vector<std::vector<uint8_t>> samples;
+  for (int i = 0; i < 500; i++) {
+    std::string sketch = "{\"sketch\":\"theta\",\"lg_k\":12,\"seed\":9001,";
+    sketch += "\"theta\":" + std::to_string(dis(gen)) + ",\"entries\":[";
+    for (int j = 0; j < 8; j++) {
+      sketch += std::to_string(dis(gen)) + ",";
+    }
+    sketch += "0]}";
+    samples.emplace_back(sketch.begin(), sketch.end());
+  }
+
+  auto buffer = std::make_shared<std::vector<uint8_t>>();
+  auto writer_result =
+      Icypuff::write(std::make_unique<MemoryOutputFile>(buffer))
+          .compress_blobs(CompressionCodec::Zstd)
+          .build();
+  ASSERT_TRUE(writer_result.ok()) << writer_result.error().message;
+  auto writer = std::move(writer_result).value();
+
+  auto dictionary_result =
+      writer->train_zstd_dictionary("theta-sketch", samples, {1});
+  ASSERT_TRUE(dictionary_result.ok()) << dictionary_result.error().message;
+  const auto& dictionary_blob = dictionary_result.value();
+  EXPECT_EQ(dictionary_blob->type(), ZSTD_DICTIONARY_BLOB_TYPE);
+  EXPECT_EQ(dictionary_blob->compression_codec(), std::nullopt);
+  auto dictionary_id = dictionary_blob->properties().find(
+      std::string(ZSTD_DICTIONARY_ID_PROPERTY));
+  ASSERT_NE(dictionary_id, dictionary_blob->properties().end());
+
+  // A second dictionary for the same type is rejected
+  auto duplicate = writer->train_zstd_dictionary("theta-sketch", samples, {1});
+  ASSERT_FALSE(duplicate.ok());
+  EXPECT_EQ(duplicate.error().code, ErrorCode::kInvalidState);
+
+  for (const auto& sample : samples) {
+    auto blob_result = writer->write_blob(sample.data(), sample.size(),
+                                          "theta-sketch", {1}, 1, 1);
+    ASSERT_TRUE(blob_result.ok()) << blob_result.error().message;
+    EXPECT_EQ(blob_result.value()->properties().at(
+                  std::string(ZSTD_DICTIONARY_ID_PROPERTY)),
+              dictionary_id->second);
+  }
+
+  // Blobs of other types do not use the dictionary
+  auto other_result = writer->write_blob(samples[0].data(), samples[0].size(),
+                                         "other-sketch", {2}, 1, 1);
+  ASSERT_TRUE(other_result.ok()) << other_result.error().message;
+  EXPECT_TRUE(other_result.value()->properties().empty());
+
+  ASSERT_TRUE(writer->close().ok());
+
+  IcypuffReader reader(std::make_unique<MemoryInputFile>(buffer));
+  auto blobs_result = reader.get_blobs();
+  ASSERT_TRUE(blobs_result.ok()) << blobs_result.error().message;
+  const auto& blobs = blobs_result.value();
+  ASSERT_EQ(blobs.size(), samples.size() + 2);
+
+  int64_t dictionary_compressed_size = 0;
+  for (size_t i = 0; i < samples.size(); i++) {
+    const auto& blob = blobs[i + 1];
+    EXPECT_EQ(blob->compression_codec(), "zstd");
+    dictionary_compressed_size += blob->length();
+    auto data = reader.read_blob(*blob);
+    ASSERT_TRUE(data.ok()) << data.error().message;
+    EXPECT_EQ(data.value(), samples[i]);
+  }
+
+  auto other_data = reader.read_blob(*blobs.back());
+  ASSERT_TRUE(other_data.ok()) << other_data.error().message;
+  EXPECT_EQ(other_data.value(), samples[0]);
+
+  // Loading the dictionary is not counted as a blob decompression
+  ReaderStats stats = reader.stats();
+  EXPECT_EQ(GetCodecStats(stats.decompression, CompressionCodec::None).calls,
+            0);
+  EXPECT_EQ(GetCodecStats(stats.decompression, CompressionCodec::Zstd).calls,
+            static_cast<int64_t>(samples.size()) + 1);
+
+  // Per-blob frames without a dictionary barely compress such small inputs
+  EXPECT_LT(dictionary_compressed_size,
+            blobs.back()->length() * static_cast<int64_t>(samples.size()));
+}
+
+TEST_F(IcypuffWriterTest, AdaptiveCompression) {
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<> dis(0, 255);
+  std::vector<uint8_t> random_data(32 * 1024);
+  for (auto& byte : random_data) {
+    byte = static_cast<uint8_t>(dis(gen));
+  }
+
+  std::string text;
+  while (text.size() < 32 * 1024) {
+    text += "snapshot " + std::to_string(text.size() % 97) + " compresses ";
+  }
+
+  auto buffer = std::make_shared<std::vector<uint8_t>>();
+  AdaptiveCompressionPolicy policy;
+  auto writer_result =
+      Icypuff::write(std::make_unique<MemoryOutputFile>(buffer))
+          .compress_blobs_adaptive(policy)
+          .build();
+  ASSERT_TRUE(writer_result.ok()) << writer_result.error().message;
+  auto writer = std::move(writer_result).value();
+
+  // Incompressible data is stored as is
+  auto random_blob = writer->write_blob(random_data.data(), random_data.size(),
+                                        "random", {1});
+  ASSERT_TRUE(random_blob.ok()) << random_blob.error().message;
+  EXPECT_EQ(random_blob.value()->compression_codec(), std::nullopt);
+  EXPECT_EQ(random_blob.value()->length(), random_data.size());
+
+  // Compressible data uses the preferred codec
+  auto text_blob =
+      writer->write_blob(reinterpret_cast<const uint8_t*>(text.data()),
+                         text.size(), "text", {1});
+  ASSERT_TRUE(text_blob.ok()) << text_blob.error().message;
+  EXPECT_EQ(text_blob.value()->compression_codec(), "zstd");
+
+  // An explicit codec overrides the policy
+  auto forced_blob = writer->write_blob(random_data.data(), random_data.size(),
+                                        "random", {1}, 0, 0,
+                                        CompressionCodec::Lz4);
+  ASSERT_TRUE(forced_blob.ok()) << forced_blob.error().message;
+  EXPECT_EQ(forced_blob.value()->compression_codec(), "lz4");
+
+  ASSERT_TRUE(writer->close().ok());
+
+  // A gain below the Zstd threshold falls back to LZ4
+  policy.min_zstd_gain = 1.0;
+  EXPECT_EQ(SelectCompressionCodec(
+                policy, reinterpret_cast<const uint8_t*>(text.data()),
+                text.size()),
+            CompressionCodec::Lz4);
+
+  IcypuffReader reader(std::make_unique<MemoryInputFile>(buffer));
+  auto blobs_result = reader.get_blobs();
+  ASSERT_TRUE(blobs_result.ok()) << blobs_result.error().message;
+  ASSERT_EQ(blobs_result.value().size(), 3);
+  auto text_data = reader.read_blob(*blobs_result.value()[1]);
+  ASSERT_TRUE(text_data.ok()) << text_data.error().message;
+  EXPECT_EQ(std::string(text_data.value().begin(), text_data.value().end()),
+            text);
+}
+
+TEST_F(IcypuffWriterTest, MultithreadedZstdLargeBlob) {
+  // Repetitive data with long-range matches, large enough for several jobs
+  std::mt19937 gen(11);
+  std::uniform_int_distribution<> dis(0, 255);
+  std::vector<uint8_t> block(256 * 1024);
+  for (auto& byte : block) {
+    byte = static_cast<uint8_t>(dis(gen));
+  }
+  std::vector<uint8_t> large_data;
+  for (int i = 0; i < 16; i++) {
+    large_data.insert(large_data.end(), block.begin(), block.end());
+  }
+
+  auto buffer = std::make_shared<std::vector<uint8_t>>();
+  auto writer_result =
+      Icypuff::write(std::make_unique<MemoryOutputFile>(buffer))
+          .compress_blobs(CompressionCodec::Zstd)
+          .zstd_large_blobs({.workers = 2,
+                             .min_blob_size = 1024 * 1024,
+                             .job_size = 1024 * 1024,
+                             .long_distance_matching = true})
+          .build();
+  ASSERT_TRUE(writer_result.ok()) << writer_result.error().message;
+  auto writer = std::move(writer_result).value();
+
+  auto blob_result = writer->write_blob(large_data.data(), large_data.size(),
+                                        "deletion-vector", {1});
+  ASSERT_TRUE(blob_result.ok()) << blob_result.error().message;
+  const auto& blob = blob_result.value();
+  EXPECT_EQ(blob->compression_codec(), "zstd");
+  EXPECT_LT(blob->length(), large_data.size() / 2);
+  ASSERT_TRUE(writer->close().ok());
+
+  // The blob is a single frame that declares its content size
+  auto raw = std::span<const uint8_t>(*buffer).subspan(
+      static_cast<size_t>(blob->offset()), static_cast<size_t>(blob->length()));
+  EXPECT_EQ(ZSTD_findFrameCompressedSize(raw.data(), raw.size()), raw.size());
+  EXPECT_EQ(ZSTD_getFrameContentSize(raw.data(), raw.size()),
+            large_data.size());
+
+  IcypuffReader reader(std::make_unique<MemoryInputFile>(buffer));
+  auto data = reader.read_blob(*blob);
+  ASSERT_TRUE(data.ok()) << data.error().message;
+  EXPECT_EQ(data.value(), large_data);
+}
+
+TEST_F(IcypuffWriterTest, AppendBlobsAndProperties) {
+  auto buffer = std::make_shared<std::vector<uint8_t>>();
+  std::string first = "first blob";
+  std::string second = "second blob, compressed compressed compressed";
+
+  auto writer_result =
+      Icypuff::write(std::make_unique<MemoryOutputFile>(buffer))
+          .created_by("Test 1234")
+          .set("owner", "stats-job")
+          .build();
+  ASSERT_TRUE(writer_result.ok()) << writer_result.error().message;
+  auto writer = std::move(writer_result).value();
+  ASSERT_TRUE(writer
+                  ->write_blob(reinterpret_cast<const uint8_t*>(first.data()),
+                               first.size(), "some-blob", {1}, 1, 1)
+                  .ok());
+  ASSERT_TRUE(writer->close().ok());
+  int64_t data_end =
+      writer->file_size().value() - writer->footer_size().value();
+
+  std::vector<uint8_t> original(buffer->begin(), buffer->begin() + data_end);
+
+  // An appender dropped before writing leaves the file as it was
+  size_t original_length = buffer->size();
+  {
+    auto abandoned =
+        Icypuff::append(std::make_unique<MemoryInputFile>(*buffer),
+                        std::make_unique<MemoryOutputFile>(buffer))
+            .build();
+    ASSERT_TRUE(abandoned.ok()) << abandoned.error().message;
+  }
+  EXPECT_EQ(buffer->size(), original_length);
+
+  // Append one blob and update the file properties
+  auto append_result =
+      Icypuff::append(std::make_unique<MemoryInputFile>(*buffer),
+                      std::make_unique<MemoryOutputFile>(buffer))
+          .set("created-by", "Appender")
+          .remove("owner")
+          .compress_blobs(CompressionCodec::Zstd)
+          .build();
+  ASSERT_TRUE(append_result.ok()) << append_result.error().message;
+  auto appender = std::move(append_result).value();
+  auto appended_blob =
+      appender->write_blob(reinterpret_cast<const uint8_t*>(second.data()),
+                           second.size(), "other-blob", {2}, 2, 2);
+  ASSERT_TRUE(appended_blob.ok()) << appended_blob.error().message;
+  EXPECT_EQ(appended_blob.value()->offset(), data_end);
+  ASSERT_TRUE(appender->close().ok());
+  EXPECT_EQ(appender->written_blobs_metadata().size(), 2);
+
+  // The existing blob bytes were not rewritten
+  EXPECT_EQ(std::vector<uint8_t>(buffer->begin(), buffer->begin() + data_end),
+            original);
+  EXPECT_EQ(static_cast<int64_t>(buffer->size()),
+            appender->file_size().value());
+
+  IcypuffReader reader(std::make_unique<MemoryInputFile>(*buffer));
+  auto blobs_result = reader.get_blobs();
+  ASSERT_TRUE(blobs_result.ok()) << blobs_result.error().message;
+  const auto& blobs = blobs_result.value();
+  ASSERT_EQ(blobs.size(), 2);
+  EXPECT_EQ(reader.properties().size(), 1);
+  EXPECT_EQ(reader.properties().at("created-by"), "Appender");
+
+  auto first_data = reader.read_blob(*blobs[0]);
+  ASSERT_TRUE(first_data.ok()) << first_data.error().message;
+  EXPECT_EQ(std::string(first_data.value().begin(), first_data.value().end()),
+            first);
+  auto second_data = reader.read_blob(*blobs[1]);
+  ASSERT_TRUE(second_data.ok()) << second_data.error().message;
+  EXPECT_EQ(
+      std::string(second_data.value().begin(), second_data.value().end()),
+      second);
+  ASSERT_TRUE(reader.close().ok());
+
+  // Updating only properties rewrites just the footer
+  auto update_result =
+      Icypuff::append(std::make_unique<MemoryInputFile>(*buffer),
+                      std::make_unique<MemoryOutputFile>(buffer))
+          .set("stats-version", "2")
+          .build();
+  ASSERT_TRUE(update_result.ok()) << update_result.error().message;
+  ASSERT_TRUE(update_result.value()->close().ok());
+
+  IcypuffReader updated(std::make_unique<MemoryInputFile>(*buffer));
+  auto updated_blobs = updated.get_blobs();
+  ASSERT_TRUE(updated_blobs.ok()) << updated_blobs.error().message;
+  EXPECT_EQ(updated_blobs.value().size(), 2);
+  EXPECT_EQ(updated.properties().at("stats-version"), "2");
+  EXPECT_EQ(updated.properties().at("created-by"), "Appender");
+}
+
+TEST_F(IcypuffWriterTest, MergeFilesVerbatim) {
+  std::vector<std::vector<uint8_t>> samples;
+  for (int i = 0; i < 200; i++) {
+    std::string sketch = "{\"sketch\":\"theta\",\"lg_k\":12,\"entries\":[" +
+                         std::to_string(i * 7919) + "," +
+                         std::to_string(i * 104729) + "]}";
+    samples.emplace_back(sketch.begin(), sketch.end());
+  }
+
+  // Two small stats files with blobs of an expired and a live snapshot,
+  // both compressed with the same trained dictionary
+  std::vector<std::shared_ptr<std::vector<uint8_t>>> sources = {
+      std::make_shared<std::vector<uint8_t>>(),
+      std::make_shared<std::vector<uint8_t>>()};
+  for (const auto& source : sources) {
+    auto writer_result =
+        Icypuff::write(std::make_unique<MemoryOutputFile>(source))
+            .compress_blobs(CompressionCodec::Zstd)
+            .build();
+    ASSERT_TRUE(writer_result.ok()) << writer_result.error().message;
+    auto writer = std::move(writer_result).value();
+    ASSERT_TRUE(writer->train_zstd_dictionary("sketch", samples, {1}).ok());
+    for (int64_t snapshot_id : {1, 2}) {
+      for (int i = 0; i < 3; i++) {
+        const auto& sample = samples[snapshot_id * 10 + i];
+        ASSERT_TRUE(writer
+                        ->write_blob(sample.data(), sample.size(), "sketch",
+                                     {1}, snapshot_id, snapshot_id)
+                        .ok());
+      }
+    }
+    ASSERT_TRUE(writer->close().ok());
+  }
+
+  auto merged = std::make_shared<std::vector<uint8_t>>();
+  auto merger_result =
+      Icypuff::merge(std::make_unique<MemoryOutputFile>(merged))
+          .add_input(std::make_unique<MemoryInputFile>(sources[0]))
+          .add_input(std::make_unique<MemoryInputFile>(sources[1]))
+          .created_by("Merger")
+          .filter([](const BlobMetadata& blob) {
+            return blob.snapshot_id() != 1;
+          })
+          .build();
+  ASSERT_TRUE(merger_result.ok()) << merger_result.error().message;
+  auto summary = merger_result.value()->merge();
+  ASSERT_TRUE(summary.ok()) << summary.error().message;
+  EXPECT_EQ(summary.value().input_files, 2);
+  // One shared dictionary and three live blobs per input
+  EXPECT_EQ(summary.value().blobs_copied, 7);
+  EXPECT_EQ(summary.value().blobs_dropped, 7);
+
+  EXPECT_EQ(static_cast<int64_t>(merged->size()), summary.value().file_size);
+  IcypuffReader reader(std::make_unique<MemoryInputFile>(merged));
+  auto blobs_result = reader.get_blobs();
+  ASSERT_TRUE(blobs_result.ok()) << blobs_result.error().message;
+  const auto& blobs = blobs_result.value();
+  ASSERT_EQ(blobs.size(), 7);
+  EXPECT_EQ(reader.properties().at("created-by"), "Merger");
+  EXPECT_EQ(blobs[0]->type(), ZSTD_DICTIONARY_BLOB_TYPE);
+
+  // Compressed bytes are copied unchanged and still decode
+  IcypuffReader source_reader(std::make_unique<MemoryInputFile>(sources[1]));
+  auto source_blobs = source_reader.get_blobs();
+  ASSERT_TRUE(source_blobs.ok()) << source_blobs.error().message;
+  for (int i = 0; i < 3; i++) {
+    const auto& blob = *blobs[4 + i];
+    const auto& source_blob = *source_blobs.value()[4 + i];
+    EXPECT_EQ(blob.snapshot_id(), 2);
+    EXPECT_EQ(blob.compression_codec(), "zstd");
+    auto bytes = std::span<const uint8_t>(*merged).subspan(
+        static_cast<size_t>(blob.offset()), static_cast<size_t>(blob.length()));
+    auto source_bytes = std::span<const uint8_t>(*sources[1]).subspan(
+        static_cast<size_t>(source_blob.offset()),
+        static_cast<size_t>(source_blob.length()));
+    EXPECT_TRUE(std::ranges::equal(bytes, source_bytes));
+
+    auto data = reader.read_blob(blob);
+    ASSERT_TRUE(data.ok()) << data.error().message;
+    EXPECT_EQ(data.value(), samples[20 + i]);
+  }
+
+  // A different dictionary under an id already copied fails the merge
+  auto dictionary = TrainZstdDictionary(samples);
+  ASSERT_TRUE(dictionary.ok()) << dictionary.error().message;
+  std::vector<uint8_t> altered = dictionary.value();
+  altered.back() ^= 0xff;
+  auto write_with_dictionary =
+      [&](const std::shared_ptr<std::vector<uint8_t>>& target,
+          const std::vector<uint8_t>& bytes) {
+        auto writer_result =
+            Icypuff::write(std::make_unique<MemoryOutputFile>(target))
+                .compress_blobs(CompressionCodec::Zstd)
+                .build();
+        ASSERT_TRUE(writer_result.ok()) << writer_result.error().message;
+        auto writer = std::move(writer_result).value();
+        ASSERT_TRUE(writer->add_zstd_dictionary("sketch", bytes, {1}).ok());
+        ASSERT_TRUE(writer
+                        ->write_blob(samples[0].data(), samples[0].size(),
+                                     "sketch", {1}, 2, 2)
+                        .ok());
+        ASSERT_TRUE(writer->close().ok());
+      };
+  auto original = std::make_shared<std::vector<uint8_t>>();
+  auto conflicting = std::make_shared<std::vector<uint8_t>>();
+  write_with_dictionary(original, dictionary.value());
+  write_with_dictionary(conflicting, altered);
+  auto conflict_result =
+      Icypuff::merge(std::make_unique<MemoryOutputFile>())
+          .add_input(std::make_unique<MemoryInputFile>(original))
+          .add_input(std::make_unique<MemoryInputFile>(conflicting))
+          .build();
+  ASSERT_TRUE(conflict_result.ok()) << conflict_result.error().message;
+  auto conflict_summary = conflict_result.value()->merge();
+  ASSERT_FALSE(conflict_summary.ok());
+  EXPECT_EQ(conflict_summary.error().code, ErrorCode::kInvalidArgument);
+}
+
+TEST_F(IcypuffWriterTest, RawBlobPassthrough) {
+  std::string payload;
+  for (int i = 0; i < 100; i++) {
+    payload += "theta sketch entry " + std::to_string(i % 7) + ";";
+  }
+  const auto* payload_data = reinterpret_cast<const uint8_t*>(payload.data());
+
+  auto source = std::make_shared<std::vector<uint8_t>>();
+  auto writer_result =
+      Icypuff::write(std::make_unique<MemoryOutputFile>(source)).build();
+  ASSERT_TRUE(writer_result.ok()) << writer_result.error().message;
+  auto writer = std::move(writer_result).value();
+  for (auto codec : {CompressionCodec::Zstd, CompressionCodec::Lz4,
+                     CompressionCodec::None}) {
+    ASSERT_TRUE(writer
+                    ->write_blob(payload_data, payload.size(), "sketch", {1},
+                                 1, 1, codec)
+                    .ok());
+  }
+  ASSERT_TRUE(writer->close().ok());
+
+  IcypuffReader source_reader(std::make_unique<MemoryInputFile>(source));
+  auto source_blobs = source_reader.get_blobs();
+  ASSERT_TRUE(source_blobs.ok()) << source_blobs.error().message;
+
+  // Ship the stored frames into another file without recompressing them
+  auto target = std::make_shared<std::vector<uint8_t>>();
+  auto target_result =
+      Icypuff::write(std::make_unique<MemoryOutputFile>(target)).build();
+  ASSERT_TRUE(target_result.ok()) << target_result.error().message;
+  auto target_writer = std::move(target_result).value();
+  std::vector<RawBlob> raw_blobs;
+  for (const auto& blob : source_blobs.value()) {
+    auto raw = source_reader.read_blob_raw(*blob);
+    ASSERT_TRUE(raw.ok()) << raw.error().message;
+    EXPECT_EQ(raw.value().data.size(), blob->length());
+    auto written = target_writer->write_blob_precompressed(
+        raw.value().data.data(), raw.value().data.size(), raw.value().codec,
+        blob->type(), blob->input_fields(), 2, 2);
+    ASSERT_TRUE(written.ok()) << written.error().message;
+    EXPECT_EQ(written.value()->compression_codec(), blob->compression_codec());
+    EXPECT_EQ(written.value()->length(), blob->length());
+    raw_blobs.push_back(std::move(raw).value());
+  }
+  EXPECT_EQ(raw_blobs[0].codec, CompressionCodec::Zstd);
+  EXPECT_EQ(raw_blobs[1].codec, CompressionCodec::Lz4);
+  EXPECT_EQ(raw_blobs[2].codec, CompressionCodec::None);
+
+  // Data that is not a frame of the declared codec is rejected
+  auto not_zstd = target_writer->write_blob_precompressed(
+      payload_data, payload.size(), CompressionCodec::Zstd, "sketch", {1});
+  EXPECT_FALSE(not_zstd.ok());
+  auto not_lz4 = target_writer->write_blob_precompressed(
+      raw_blobs[0].data.data(), raw_blobs[0].data.size(),
+      CompressionCodec::Lz4, "sketch", {1});
+  EXPECT_FALSE(not_lz4.ok());
+
+  // Empty blobs round-trip through the compressed codecs, although LZ4
+  // frames record an empty content size as unknown. Uncompressed empty
+  // blobs have no bytes to store.
+  const std::vector<CompressionCodec> empty_codecs = {CompressionCodec::Zstd,
+                                                      CompressionCodec::Lz4};
+  for (auto codec : empty_codecs) {
+    auto compressed = target_writer->compress_blob(nullptr, 0, "empty", codec);
+    ASSERT_TRUE(compressed.ok()) << compressed.error().message;
+    EXPECT_EQ(compressed.value().codec, codec);
+    auto written = target_writer->write_blob_precompressed(
+        compressed.value().data.data(), compressed.value().data.size(),
+        compressed.value().codec, "empty", {2});
+    ASSERT_TRUE(written.ok()) << written.error().message;
+  }
+  ASSERT_TRUE(target_writer->close().ok());
+
+  IcypuffReader target_reader(std::make_unique<MemoryInputFile>(target));
+  auto target_blobs = target_reader.get_blobs();
+  ASSERT_TRUE(target_blobs.ok()) << target_blobs.error().message;
+  ASSERT_EQ(target_blobs.value().size(), 5);
+  for (size_t i = 0; i < 3; i++) {
+    auto raw = target_reader.read_blob_raw(*target_blobs.value()[i]);
+    ASSERT_TRUE(raw.ok()) << raw.error().message;
+    EXPECT_EQ(raw.value().data, raw_blobs[i].data);
+    auto data = target_reader.read_blob(*target_blobs.value()[i]);
+    ASSERT_TRUE(data.ok()) << data.error().message;
+    EXPECT_EQ(std::string(data.value().begin(), data.value().end()), payload);
+  }
+
+  // Stored empty frames can be shipped on again
+  auto copy_buffer = std::make_shared<std::vector<uint8_t>>();
+  auto copy_result =
+      Icypuff::write(std::make_unique<MemoryOutputFile>(copy_buffer)).build();
+  ASSERT_TRUE(copy_result.ok()) << copy_result.error().message;
+  auto copy_writer = std::move(copy_result).value();
+  for (size_t i = 3; i < 5; i++) {
+    auto data = target_reader.read_blob(*target_blobs.value()[i]);
+    ASSERT_TRUE(data.ok()) << data.error().message;
+    EXPECT_TRUE(data.value().empty());
+    auto raw = target_reader.read_blob_raw(*target_blobs.value()[i]);
+    ASSERT_TRUE(raw.ok()) << raw.error().message;
+    auto written = copy_writer->write_blob_precompressed(
+        raw.value().data.data(), raw.value().data.size(), raw.value().codec,
+        "empty", {2});
+    ASSERT_TRUE(written.ok()) << written.error().message;
+  }
+  ASSERT_TRUE(copy_writer->close().ok());
+}
+
+TEST_F(IcypuffWriterTest, AtomicWritesWithGroupCommit) {
+  std::string blob = "committed blob";
+  ScratchDirectory scratch;
+  auto count_temp_files = [&]() {
+    int count = 0;
+    for (const auto& entry :
+         std::filesystem::directory_iterator(scratch.path())) {
+      if (entry.path().extension() == ".tmp") {
+        count++;
+      }
+    }
+    return count;
+  };
+
+  auto group = std::make_shared<FsyncGroup>();
+  LocalOutputFileOptions options;
+  options.atomic = true;
+  options.fsync = FsyncPolicy::kFileAndDirectory;
+  options.preallocate_size = 64 * 1024;
+  options.fsync_group = group;
+
+  std::vector<std::string> filenames;
+  for (int i = 0; i < 3; i++) {
+    filenames.push_back("atomic-" + std::to_string(i) + ".bin");
+    auto writer_result =
+        Icypuff::write(std::make_unique<LocalOutputFile>(
+                           scratch.GetPath(filenames.back()), options))
+            .build();
+    ASSERT_TRUE(writer_result.ok()) << writer_result.error().message;
+    auto writer = std::move(writer_result).value();
+    ASSERT_TRUE(writer
+                    ->write_blob(reinterpret_cast<const uint8_t*>(blob.data()),
+                                 blob.size(), "some-blob", {1})
+                    .ok());
+    ASSERT_TRUE(writer->close().ok());
+  }
+
+  // Closed files appear at their paths only on commit
+  EXPECT_EQ(group->pending(), 3);
+  EXPECT_EQ(count_temp_files(), 3);
+  for (const auto& filename : filenames) {
+    EXPECT_FALSE(scratch.CreateInputFile(filename)->exists());
+  }
+  ASSERT_TRUE(group->commit().ok());
+  EXPECT_EQ(group->pending(), 0);
+  EXPECT_EQ(count_temp_files(), 0);
+
+  for (const auto& filename : filenames) {
+    auto input_file = scratch.CreateInputFile(filename);
+    auto length = input_file->length().value();
+    IcypuffReader reader(std::move(input_file), length);
+    auto blobs = reader.get_blobs();
+    ASSERT_TRUE(blobs.ok()) << blobs.error().message;
+    ASSERT_EQ(blobs.value().size(), 1);
+    auto data = reader.read_blob(*blobs.value()[0]);
+    ASSERT_TRUE(data.ok()) << data.error().message;
+    EXPECT_EQ(std::string(data.value().begin(), data.value().end()), blob);
+  }
+
+  // Atomic appends are staged in a copy and replace the file on commit
+  {
+    std::string appended = "appended blob";
+    auto append_result =
+        Icypuff::append(scratch.CreateInputFile(filenames[1]),
+                        std::make_unique<LocalOutputFile>(
+                            scratch.GetPath(filenames[1]), options))
+            .build();
+    ASSERT_TRUE(append_result.ok()) << append_result.error().message;
+    auto appender = std::move(append_result).value();
+    ASSERT_TRUE(
+        appender
+            ->write_blob(reinterpret_cast<const uint8_t*>(appended.data()),
+                         appended.size(), "some-blob", {1})
+            .ok());
+    ASSERT_TRUE(appender->close().ok());
+    auto blob_count = [&]() {
+      auto input_file = scratch.CreateInputFile(filenames[1]);
+      auto length = input_file->length().value();
+      IcypuffReader reader(std::move(input_file), length);
+      auto blobs = reader.get_blobs();
+      return blobs.ok() ? blobs.value().size() : 0;
+    };
+    EXPECT_EQ(blob_count(), 1);
+    ASSERT_TRUE(group->commit().ok());
+    EXPECT_EQ(blob_count(), 2);
+    EXPECT_EQ(count_temp_files(), 0);
+  }
+
+  // An abandoned atomic write leaves the existing file untouched
+  auto original = scratch.CreateInputFile(filenames[0])->read_at(
+      0, scratch.CreateInputFile(filenames[0])->length().value());
+  ASSERT_TRUE(original.ok());
+  options.fsync_group.reset();
+  {
+    auto writer_result =
+        Icypuff::write(std::make_unique<LocalOutputFile>(
+                           scratch.GetPath(filenames[0]), options))
+            .build();
+    ASSERT_TRUE(writer_result.ok()) << writer_result.error().message;
+    ASSERT_TRUE(writer_result.value()
+                    ->write_blob(reinterpret_cast<const uint8_t*>("torn"), 4,
+                                 "some-blob", {1})
+                    .ok());
+  }
+  EXPECT_EQ(count_temp_files(), 0);
+  auto after = scratch.CreateInputFile(filenames[0])->read_at(
+      0, scratch.CreateInputFile(filenames[0])->length().value());
+  ASSERT_TRUE(after.ok());
+  EXPECT_EQ(after.value(), original.value());
+}
+
+TEST_F(IcypuffWriterTest, InMemoryRoundTrip) {
+  std::string blob = "in-memory blob, in-memory blob, in-memory blob";
+  auto output_file = std::make_unique<MemoryOutputFile>("memory://stats");
+  auto* output = output_file.get();
+
+  auto writer_result = Icypuff::write(std::move(output_file))
+                           .created_by("Test 1234")
+                           .compress_blobs(CompressionCodec::Zstd)
+                           .build();
+  ASSERT_TRUE(writer_result.ok()) << writer_result.error().message;
+  auto writer = std::move(writer_result).value();
+  ASSERT_TRUE(writer
+                  ->write_blob(reinterpret_cast<const uint8_t*>(blob.data()),
+                               blob.size(), "some-blob", {1}, 1, 1)
+                  .ok());
+  ASSERT_TRUE(writer->close().ok());
+  ASSERT_EQ(static_cast<int64_t>(output->buffer()->size()),
+            writer->file_size().value());
+
+  // The input file shares the written buffer
+  auto input_result = output->to_input_file();
+  ASSERT_TRUE(input_result.ok()) << input_result.error().message;
+  auto input_file = std::move(input_result).value();
+  EXPECT_EQ(static_cast<MemoryInputFile*>(input_file.get())->data().data(),
+            output->buffer()->data());
+  auto length = input_file->length().value();
+  IcypuffReader reader(std::move(input_file), length);
+  auto blobs = reader.get_blobs();
+  ASSERT_TRUE(blobs.ok()) << blobs.error().message;
+  ASSERT_EQ(blobs.value().size(), 1);
+  auto data = reader.read_blob(*blobs.value()[0]);
+  ASSERT_TRUE(data.ok()) << data.error().message;
+  EXPECT_EQ(std::string(data.value().begin(), data.value().end()), blob);
+  EXPECT_EQ(reader.properties().at("created-by"), "Test 1234");
+
+  // Merging between memory files copies the blob bytes directly
+  auto merged = std::make_shared<std::vector<uint8_t>>();
+  auto merger_result =
+      Icypuff::merge(std::make_unique<MemoryOutputFile>(merged))
+          .add_input(std::make_unique<MemoryInputFile>(*output->buffer()))
+          .build();
+  ASSERT_TRUE(merger_result.ok()) << merger_result.error().message;
+  auto summary = merger_result.value()->merge();
+  ASSERT_TRUE(summary.ok()) << summary.error().message;
+  EXPECT_EQ(summary.value().blobs_copied, 1);
+
+  MemoryInputFile merged_input(*merged);
+  auto merged_length = merged_input.length().value();
+  auto original_blob = blobs.value()[0].get();
+  EXPECT_TRUE(std::equal(
+      merged_input.data().begin() + MAGIC_LENGTH,
+      merged_input.data().begin() + MAGIC_LENGTH + original_blob->length(),
+      output->buffer()->begin() + original_blob->offset()));
+  EXPECT_EQ(merged_length, summary.value().file_size);
+
+  // A transfer from a file sharing the destination buffer, which grows
+  auto shared = std::make_shared<std::vector<uint8_t>>();
+  MemoryOutputFile shared_output(shared);
+  auto shared_stream = shared_output.create_or_overwrite();
+  ASSERT_TRUE(shared_stream.ok()) << shared_stream.error().message;
+  std::vector<uint8_t> prefix(4096);
+  for (size_t i = 0; i < prefix.size(); i++) {
+    prefix[i] = static_cast<uint8_t>(i * 31);
+  }
+  ASSERT_TRUE(shared_stream.value()->write(prefix.data(), prefix.size()).ok());
+  shared->shrink_to_fit();
+  std::shared_ptr<const std::vector<uint8_t>> shared_bytes = shared;
+  MemoryInputFile shared_input(shared_bytes);
+  ASSERT_TRUE(
+      shared_stream.value()->transfer_from(shared_input, 0, 4096).ok());
+  ASSERT_EQ(shared->size(), 2 * prefix.size());
+  EXPECT_TRUE(std::equal(prefix.begin(), prefix.end(),
+                         shared->begin() + prefix.size()));
+}
+
+TEST_F(IcypuffWriterTest, ReaderAndWriterStats) {
+  std::string blob(4096, 'a');
+  auto buffer = std::make_shared<std::vector<uint8_t>>();
+  auto writer_result =
+      Icypuff::write(std::make_unique<MemoryOutputFile>(buffer))
+          .compress_blobs(CompressionCodec::Zstd)
+          .build();
+  ASSERT_TRUE(writer_result.ok()) << writer_result.error().message;
+  auto writer = std::move(writer_result).value();
+  for (int i = 0; i < 2; i++) {
+    ASSERT_TRUE(writer
+                    ->write_blob(reinterpret_cast<const uint8_t*>(blob.data()),
+                                 blob.size(), "some-blob", {1})
+                    .ok());
+  }
+  ASSERT_TRUE(writer
+                  ->write_blob(reinterpret_cast<const uint8_t*>(blob.data()),
+                               blob.size(), "some-blob", {1}, 0, 0,
+                               CompressionCodec::None)
+                  .ok());
+  ASSERT_TRUE(writer->close().ok());
+
+  auto writer_stats = writer->stats();
+  EXPECT_EQ(writer_stats.blobs_written, 3);
+  EXPECT_EQ(writer_stats.bytes_written, writer->file_size().value());
+  EXPECT_GE(writer_stats.write_calls, 5);
+  const auto& zstd = GetCodecStats(writer_stats.compression,
+                                   CompressionCodec::Zstd);
+  EXPECT_EQ(zstd.calls, 2);
+  EXPECT_EQ(zstd.uncompressed_bytes, 2 * 4096);
+  EXPECT_GT(zstd.ratio(), 10.0);
+  EXPECT_EQ(
+      GetCodecStats(writer_stats.compression, CompressionCodec::None).calls,
+      1);
+
+  IcypuffReader reader(std::make_unique<MemoryInputFile>(*buffer));
+  auto blobs = reader.get_blobs();
+  ASSERT_TRUE(blobs.ok()) << blobs.error().message;
+  for (const auto& metadata : blobs.value()) {
+    ASSERT_TRUE(reader.read_blob(*metadata).ok());
+  }
+  ASSERT_TRUE(reader.get_blobs().ok());
+
+  auto reader_stats = reader.stats();
+  EXPECT_EQ(reader_stats.footer_reads, 1);
+  EXPECT_EQ(reader_stats.metadata_cache_hits, 1);
+  EXPECT_EQ(reader_stats.blobs_read, 3);
+  EXPECT_GE(reader_stats.read_calls, 4);
+  EXPECT_GE(reader_stats.seeks, 4);
+  EXPECT_GT(reader_stats.bytes_read, zstd.compressed_bytes + 4096);
+  const auto& zstd_reads = GetCodecStats(reader_stats.decompression,
+                                         CompressionCodec::Zstd);
+  EXPECT_EQ(zstd_reads.calls, 2);
+  EXPECT_EQ(zstd_reads.uncompressed_bytes, 2 * 4096);
+  EXPECT_EQ(zstd_reads.compressed_bytes, zstd.compressed_bytes);
+}
+
+// Records the kind and outcome of every finished span
+class RecordingTracer : public Tracer {
+ public:
+  struct Span {
+    SpanKind kind;
+    int64_t bytes;
+    bool ok;
+  };
+
+  uint64_t begin_span(SpanKind) override { return ++open_spans; }
+
+  void end_span(SpanKind kind, uint64_t, int64_t bytes, bool ok) override {
+    spans.push_back({kind, bytes, ok});
+  }
+
+  size_t count(SpanKind kind) const {
+    return std::count_if(spans.begin(), spans.end(),
+                         [&](const Span& span) { return span.kind == kind; });
+  }
+
+  uint64_t open_spans = 0;
+  std::vector<Span> spans;
+};
+
+TEST_F(IcypuffWriterTest, TracerReceivesSpans) {
+  if (!ICYPUFF_ENABLE_TRACING) {
+    GTEST_SKIP() << "Built without ICYPUFF_ENABLE_TRACING";
+  }
+  RecordingTracer tracer;
+  SetTracer(&tracer);
+
+  std::string blob(4096, 'a');
+  auto buffer = std::make_shared<std::vector<uint8_t>>();
+  auto writer_result =
+      Icypuff::write(std::make_unique<MemoryOutputFile>(buffer))
+          .compress_blobs(CompressionCodec::Zstd)
+          .build();
+  ASSERT_TRUE(writer_result.ok()) << writer_result.error().message;
+  auto writer = std::move(writer_result).value();
+  for (int i = 0; i < 2; i++) {
+    ASSERT_TRUE(writer
+                    ->write_blob(reinterpret_cast<const uint8_t*>(blob.data()),
+                                 blob.size(), "some-blob", {1})
+                    .ok());
+  }
+  ASSERT_TRUE(writer->close().ok());
+
+  IcypuffReader reader(std::make_unique<MemoryInputFile>(*buffer));
+  auto blobs = reader.get_blobs();
+  ASSERT_TRUE(blobs.ok()) << blobs.error().message;
+  for (const auto& metadata : blobs.value()) {
+    ASSERT_TRUE(reader.read_blob(*metadata).ok());
+  }
+  SetTracer(nullptr);
+
+  EXPECT_EQ(tracer.count(SpanKind::kCompress), 2);
+  EXPECT_EQ(tracer.count(SpanKind::kBlobWrite), 2);
+  EXPECT_EQ(tracer.count(SpanKind::kClose), 1);
+  EXPECT_EQ(tracer.count(SpanKind::kFooterRead), 1);
+  EXPECT_EQ(tracer.count(SpanKind::kFooterParse), 1);
+  EXPECT_EQ(tracer.count(SpanKind::kBlobRead), 2);
+  EXPECT_EQ(tracer.count(SpanKind::kDecompress), 2);
+  EXPECT_EQ(tracer.spans.size(), tracer.open_spans);
+  for (const auto& span : tracer.spans) {
+    EXPECT_TRUE(span.ok) << GetSpanName(span.kind);
+    EXPECT_GT(span.bytes, 0) << GetSpanName(span.kind);
+  }
+  EXPECT_EQ(tracer.spans.back().bytes, 4096);
+}
+
+TEST_F(IcypuffWriterTest, SyntheticDatasetAtScale) {
+  SyntheticDatasetOptions options;
+  options.blob_count = 20000;
+  options.size_distribution = BlobSizeDistribution::kLogNormal;
+  options.min_blob_size = 16;
+  options.max_blob_size = 4096;
+  options.types = {"apache-datasketches-theta-v1", "bloom-filter-v1"};
+  options.codecs = {CompressionCodec::None, CompressionCodec::Lz4};
+  options.properties_per_blob = 2;
+  options.property_cardinality = 100000;
+  options.fields_per_blob = 3;
+  options.field_count = 4;
+  options.snapshot_count = 10;
+  options.compress_footer = true;
+
+  auto buffer = std::make_shared<std::vector<uint8_t>>();
+  auto summary = GenerateSyntheticDataset(
+      std::make_unique<MemoryOutputFile>(buffer), options);
+  ASSERT_TRUE(summary.ok()) << summary.error().message;
+  EXPECT_EQ(summary.value().blob_count, 20000);
+  EXPECT_EQ(summary.value().file_size, static_cast<int64_t>(buffer->size()));
+
+  IcypuffReader reader(std::make_unique<MemoryInputFile>(*buffer));
+  auto blobs = reader.get_blobs();
+  ASSERT_TRUE(blobs.ok()) << blobs.error().message;
+  ASSERT_EQ(blobs.value().size(), 20000);
+  EXPECT_EQ(reader.footer_size().value(), summary.value().footer_size);
+
+  int64_t data_bytes = 0;
+  for (size_t i = 0; i < blobs.value().size(); i += 199) {
+    const auto& blob = *blobs.value()[i];
+    EXPECT_EQ(blob.properties().size(), 2);
+    std::vector<int> fields = blob.input_fields();
+    ASSERT_EQ(fields.size(), 3);
+    std::sort(fields.begin(), fields.end());
+    EXPECT_EQ(std::adjacent_find(fields.begin(), fields.end()), fields.end());
+    EXPECT_GE(fields.front(), 1);
+    EXPECT_LE(fields.back(), 4);
+    auto data = reader.read_blob(blob);
+    ASSERT_TRUE(data.ok()) << data.error().message;
+    EXPECT_GE(data.value().size(), options.min_blob_size);
+    EXPECT_LE(data.value().size(), options.max_blob_size);
+    data_bytes += static_cast<int64_t>(data.value().size());
+  }
+  EXPECT_GT(data_bytes, 0);
+
+  // Equal seeds generate identical files
+  options.blob_count = 100;
+  auto first = std::make_shared<std::vector<uint8_t>>();
+  auto second = std::make_shared<std::vector<uint8_t>>();
+  ASSERT_TRUE(GenerateSyntheticDataset(
+                  std::make_unique<MemoryOutputFile>(first), options)
+                  .ok());
+  ASSERT_TRUE(GenerateSyntheticDataset(
+                  std::make_unique<MemoryOutputFile>(second), options)
+                  .ok());
+  EXPECT_EQ(*first, *second);
+
+  options.blob_count = 0;
+  EXPECT_FALSE(GenerateSyntheticDataset(std::make_unique<MemoryOutputFile>(),
+                                        options)
+                   .ok());
+  options.blob_count = 100;
+  options.fields_per_blob = 0;
+  EXPECT_FALSE(GenerateSyntheticDataset(std::make_unique<MemoryOutputFile>(),
+                                        options)
+                   .ok());
+  options.fields_per_blob = 5;
+  EXPECT_FALSE(GenerateSyntheticDataset(std::make_unique<MemoryOutputFile>(),
+                                        options)
+                   .ok());
+}
+
+TEST_F(IcypuffWriterTest, AwaitableReaderAndWriter) {
+  ThreadPoolExecutor io(2);
+  ThreadPoolExecutor loop(1);
+  std::thread::id loop_thread;
+  std::latch started(1);
+  loop.post([&]() {
+    loop_thread = std::this_thread::get_id();
+    started.count_down();
+  });
+  started.wait();
+
+  AsyncRoundTrip round_trip;
+  std::latch done(1);
+  WriteAndReadAsync(io, loop, std::this_thread::get_id(), loop_thread,
+                    round_trip, done);
+  done.wait();
+
+  EXPECT_TRUE(round_trip.error.empty()) << round_trip.error;
+  EXPECT_EQ(round_trip.blobs,
+            (std::vector<std::string>{"first sketch", "second sketch"}));
+  EXPECT_TRUE(round_trip.ran_off_caller_thread);
+  EXPECT_TRUE(round_trip.resumed_on_loop);
+}
+
 }  // namespace
-}  // namespace icypuff
\ No newline at end of file
+}  // namespace icypuff
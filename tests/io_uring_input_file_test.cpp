@@ -0,0 +1,130 @@
+#include "icypuff/io_uring_input_file.h"
+
+#include <gtest/gtest.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "icypuff/icypuff.h"
+#include "icypuff/icypuff_reader.h"
+#include "icypuff/local_input_file.h"
+#include "test_resources.h"
+
+namespace icypuff {
+namespace {
+
+using ::icypuff::testing::ScratchDirectory;
+
+class IoUringInputFileTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // Initialize logging
+    spdlog::set_level(spdlog::level::debug);
+    spdlog::set_pattern("[%H:%M:%S.%e] [%^%l%$] [%s:%#] %v");
+  }
+};
+
+TEST_F(IoUringInputFileTest, BatchedReads) {
+  const CompressionCodec codecs[] = {CompressionCodec::None,
+                                     CompressionCodec::Lz4,
+                                     CompressionCodec::Zstd};
+  ScratchDirectory scratch;
+  auto writer_result =
+      Icypuff::write(scratch.CreateOutputFile("io-uring.bin")).build();
+  ASSERT_TRUE(writer_result.ok()) << writer_result.error().message;
+  auto writer = std::move(writer_result).value();
+  std::vector<std::string> contents;
+  for (int b = 0; b < 40; b++) {
+    std::string data(300 + 211 * b, static_cast<char>('a' + b % 26));
+    data += std::to_string(b);
+    ASSERT_TRUE(writer
+                    ->write_blob(reinterpret_cast<const uint8_t*>(data.data()),
+                                 data.size(), "sketch", {b}, 1, 1,
+                                 codecs[b % 3])
+                    .ok());
+    contents.push_back(data);
+  }
+  ASSERT_TRUE(writer->close().ok());
+  std::string path = scratch.GetPath("io-uring.bin");
+
+  IoUringInputFileParams buffered;
+  // A queue shorter than the batch makes reads wait for free slots
+  buffered.queue_depth = 8;
+  IoUringInputFileParams direct = buffered;
+  direct.direct_io = true;
+  IoUringInputFileParams fallback = buffered;
+  fallback.disable_io_uring = true;
+  // Submissions fail while reads are in flight, which are drained before
+  // the batch finishes with pread
+  IoUringInputFileParams failing = buffered;
+  failing.fail_submissions_after = 1;
+
+  for (const auto& params : {buffered, direct, fallback, failing}) {
+    auto file_result = IoUringInputFile::Create(path, params);
+    ASSERT_TRUE(file_result.ok()) << file_result.error().message;
+    if (params.disable_io_uring) {
+      EXPECT_FALSE(file_result.value()->uses_io_uring());
+    }
+    IcypuffReader reader(std::move(file_result).value());
+    auto blobs = reader.get_blobs();
+    ASSERT_TRUE(blobs.ok()) << blobs.error().message;
+    ASSERT_EQ(blobs.value().size(), contents.size());
+
+    std::vector<const BlobMetadata*> wanted;
+    for (const auto& blob : blobs.value()) {
+      wanted.push_back(blob.get());
+    }
+    auto results = reader.read_blobs(wanted);
+    ASSERT_EQ(results.size(), contents.size());
+    for (size_t i = 0; i < results.size(); i++) {
+      ASSERT_TRUE(results[i].ok()) << results[i].error().message;
+      EXPECT_EQ(std::string(results[i].value().begin(),
+                            results[i].value().end()),
+                contents[i]);
+    }
+    auto single = reader.read_blob(*blobs.value()[7]);
+    ASSERT_TRUE(single.ok()) << single.error().message;
+    EXPECT_EQ(std::string(single.value().begin(), single.value().end()),
+              contents[7]);
+  }
+
+  // Raw batches report every read once, including failed ones
+  auto file_result = IoUringInputFile::Create(path, direct);
+  ASSERT_TRUE(file_result.ok()) << file_result.error().message;
+  auto& file = *file_result.value();
+  int64_t length = file.length().value();
+  std::vector<std::vector<uint8_t>> buffers(100);
+  std::vector<PositionalRead> reads;
+  for (size_t i = 0; i < buffers.size(); i++) {
+    buffers[i].resize(1 + i * 13);
+    reads.push_back({static_cast<int64_t>(i * 97) % (length - 1400),
+                     buffers[i].data(), buffers[i].size()});
+  }
+  std::vector<uint8_t> past_end(16);
+  reads.push_back({length - 8, past_end.data(), past_end.size()});
+  std::vector<int> completions(reads.size());
+  std::vector<bool> succeeded(reads.size());
+  file.read_batch(reads, [&](size_t i, Result<void> result) {
+    completions[i]++;
+    succeeded[i] = result.ok();
+  });
+
+  std::vector<uint8_t> expected(static_cast<size_t>(length));
+  ASSERT_TRUE(LocalInputFile(path)
+                  .read_fully(0, expected.data(), expected.size())
+                  .ok());
+  for (size_t i = 0; i < buffers.size(); i++) {
+    EXPECT_EQ(completions[i], 1);
+    ASSERT_TRUE(succeeded[i]);
+    EXPECT_TRUE(std::equal(buffers[i].begin(), buffers[i].end(),
+                           expected.begin() + reads[i].position));
+  }
+  EXPECT_EQ(completions.back(), 1);
+  EXPECT_FALSE(succeeded.back());
+}
+
+}  // namespace
+}  // namespace icypuff
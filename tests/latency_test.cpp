@@ -0,0 +1,88 @@
+#include "icypuff/latency.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "icypuff/icypuff.h"
+#include "icypuff/icypuff_reader.h"
+#include "icypuff/memory_input_file.h"
+#include "icypuff/memory_output_file.h"
+
+namespace icypuff {
+namespace {
+
+TEST(LatencyTest, LatencyHistograms) {
+  // Bucket bounds stay within 12.5% of the values they hold
+  for (int64_t value : std::vector<int64_t>{0, 15, 16, 1000, 123456789}) {
+    size_t index = LatencyHistogram::BucketIndex(value);
+    EXPECT_GE(LatencyHistogram::BucketUpperBound(index), value);
+    EXPECT_LE(LatencyHistogram::BucketUpperBound(index), value + value / 8);
+    if (index > 0) {
+      EXPECT_LT(LatencyHistogram::BucketUpperBound(index - 1), value);
+    }
+  }
+  EXPECT_EQ(LatencyHistogram::BucketIndex(int64_t{1} << 45),
+            LatencyHistogram::kBucketCount - 1);
+
+  LatencyHistogram histogram;
+  for (int64_t i = 1; i <= 1000; i++) {
+    histogram.record(i * 1000);
+  }
+  auto snapshot = histogram.snapshot();
+  EXPECT_EQ(snapshot.count, 1000);
+  EXPECT_EQ(snapshot.sum_nanos, 500500000);
+  EXPECT_GE(snapshot.percentile(0.99), 990000);
+  EXPECT_LE(snapshot.percentile(0.99), 990000 + 990000 / 8);
+  EXPECT_LE(snapshot.percentile(0.5), 500000 + 500000 / 8);
+
+  ResetLatencyHistograms();
+  std::string blob(4096, 'a');
+  auto buffer = std::make_shared<std::vector<uint8_t>>();
+  auto writer_result =
+      Icypuff::write(std::make_unique<MemoryOutputFile>(buffer))
+          .compress_blobs(CompressionCodec::Zstd)
+          .build();
+  ASSERT_TRUE(writer_result.ok()) << writer_result.error().message;
+  auto writer = std::move(writer_result).value();
+  for (int i = 0; i < 3; i++) {
+    ASSERT_TRUE(writer
+                    ->write_blob(reinterpret_cast<const uint8_t*>(blob.data()),
+                                 blob.size(), "some-blob", {1})
+                    .ok());
+  }
+  ASSERT_TRUE(writer->close().ok());
+
+  IcypuffReader reader(std::make_unique<MemoryInputFile>(*buffer));
+  auto blobs = reader.get_blobs();
+  ASSERT_TRUE(blobs.ok()) << blobs.error().message;
+  for (const auto& metadata : blobs.value()) {
+    ASSERT_TRUE(reader.read_blob(*metadata).ok());
+  }
+
+  auto count = [](LatencyOp op) {
+    return GetLatencyHistogram(op).snapshot().count;
+  };
+  EXPECT_EQ(count(LatencyOp::kWriteBlob), 3);
+  EXPECT_EQ(count(LatencyOp::kClose), 1);
+  EXPECT_EQ(count(LatencyOp::kReadFileMetadata), 1);
+  EXPECT_EQ(count(LatencyOp::kReadBlobIo), 3);
+  EXPECT_EQ(count(LatencyOp::kReadBlobDecompress), 3);
+
+  std::string text = RenderLatencyPrometheus();
+  EXPECT_NE(text.find("# TYPE icypuff_operation_latency_seconds histogram"),
+            std::string::npos);
+  EXPECT_NE(text.find("icypuff_operation_latency_seconds_bucket{"
+                      "op=\"write_blob\",le=\"+Inf\"} 3\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("icypuff_operation_latency_seconds_count{"
+                      "op=\"read_blob_io\"} 3\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("le=\"1.023e-06\""), std::string::npos);
+}
+
+}  // namespace
+}  // namespace icypuff
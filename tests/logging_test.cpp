@@ -0,0 +1,53 @@
+#include "icypuff/logging.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "icypuff/icypuff_reader.h"
+#include "icypuff/memory_input_file.h"
+
+namespace icypuff {
+namespace {
+
+// Captures messages at or above a level
+class RecordingLogSink : public LogSink {
+ public:
+  explicit RecordingLogSink(LogLevel level) : level_(level) {}
+
+  bool enabled(LogLevel level) const override { return level >= level_; }
+
+  void log(LogLevel, std::string_view message) override {
+    messages.emplace_back(message);
+  }
+
+  std::vector<std::string> messages;
+
+ private:
+  LogLevel level_;
+};
+
+TEST(LoggingTest, PluggableLogSink) {
+  std::vector<uint8_t> empty;
+  RecordingLogSink sink(LogLevel::kError);
+  LogSink* previous = GetLogSink();
+  SetLogSink(&sink);
+  IcypuffReader reader(std::make_unique<MemoryInputFile>(empty), 100, 10);
+  EXPECT_FALSE(reader.get_blobs().ok());
+  ASSERT_EQ(sink.messages.size(), 1);
+  EXPECT_EQ(sink.messages[0], "Invalid footer size: 10");
+
+  // Without a sink messages are discarded
+  SetLogSink(nullptr);
+  IcypuffReader discarded(std::make_unique<MemoryInputFile>(empty), 100, 10);
+  EXPECT_FALSE(discarded.get_blobs().ok());
+  EXPECT_EQ(sink.messages.size(), 1);
+  SetLogSink(previous);
+}
+
+}  // namespace
+}  // namespace icypuff
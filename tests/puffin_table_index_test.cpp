@@ -0,0 +1,107 @@
+#include "icypuff/puffin_table_index.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "icypuff/icypuff.h"
+#include "icypuff/memory_input_file.h"
+#include "icypuff/memory_output_file.h"
+
+namespace icypuff {
+namespace {
+
+TEST(PuffinTableIndexTest, IndexesBlobsAcrossFiles) {
+  // One statistics file per snapshot, each with an NDV sketch per column.
+  // Snapshot 30 is the latest but only covers column 1.
+  struct Snapshot {
+    int64_t snapshot_id;
+    int64_t sequence_number;
+    std::vector<int> fields;
+  };
+  const std::vector<Snapshot> snapshots = {
+      {20, 2, {1, 2}}, {10, 1, {1, 2, 3}}, {30, 3, {1}}};
+  std::vector<std::shared_ptr<std::vector<uint8_t>>> buffers;
+  for (const auto& snapshot : snapshots) {
+    auto buffer = std::make_shared<std::vector<uint8_t>>();
+    auto writer_result =
+        Icypuff::write(std::make_unique<MemoryOutputFile>(buffer)).build();
+    ASSERT_TRUE(writer_result.ok()) << writer_result.error().message;
+    auto writer = std::move(writer_result).value();
+    for (int field : snapshot.fields) {
+      std::string data = "ndv-" + std::to_string(snapshot.snapshot_id) +
+                         "-" + std::to_string(field);
+      ASSERT_TRUE(writer
+                      ->write_blob(reinterpret_cast<const uint8_t*>(
+                                       data.data()),
+                                   data.size(), "apache-datasketches-theta-v1",
+                                   {field}, snapshot.snapshot_id,
+                                   snapshot.sequence_number)
+                      .ok());
+    }
+    // A blob covering several columns is indexed under each of them
+    ASSERT_TRUE(writer
+                    ->write_blob(reinterpret_cast<const uint8_t*>("bloom"), 5,
+                                 "bloom-filter-v1", snapshot.fields,
+                                 snapshot.snapshot_id,
+                                 snapshot.sequence_number)
+                    .ok());
+    ASSERT_TRUE(writer->close().ok());
+    buffers.push_back(buffer);
+  }
+
+  auto open_files = [&]() {
+    std::vector<std::unique_ptr<InputFile>> files;
+    for (const auto& buffer : buffers) {
+      files.push_back(std::make_unique<MemoryInputFile>(*buffer));
+    }
+    return files;
+  };
+
+  PuffinTableIndexParams params;
+  params.threads = 2;
+  auto index_result = PuffinTableIndex::Create(open_files(), params);
+  ASSERT_TRUE(index_result.ok()) << index_result.error().message;
+  auto& index = *index_result.value();
+  EXPECT_EQ(index.file_count(), 3);
+  EXPECT_EQ(index.blob_count(), 9);
+
+  auto found = index.find(10, 3, "apache-datasketches-theta-v1");
+  ASSERT_EQ(found.size(), 1);
+  EXPECT_EQ(found[0].file_index, 1);
+  EXPECT_EQ(found[0].blob_index, 2);
+  EXPECT_TRUE(index.find(30, 2, "apache-datasketches-theta-v1").empty());
+  EXPECT_TRUE(index.find(10, 3, "other").empty());
+  ASSERT_EQ(index.find(20, 2, "bloom-filter-v1").size(), 1);
+
+  auto read_latest = [&](int field) {
+    auto latest = index.find_latest(field, "apache-datasketches-theta-v1");
+    EXPECT_TRUE(latest.has_value());
+    auto data = index.read_blob(*latest);
+    EXPECT_TRUE(data.ok()) << data.error().message;
+    return std::string(data.value().begin(), data.value().end());
+  };
+  EXPECT_EQ(read_latest(1), "ndv-30-1");
+  EXPECT_EQ(read_latest(2), "ndv-20-2");
+  EXPECT_EQ(read_latest(3), "ndv-10-3");
+  EXPECT_FALSE(index.find_latest(4, "apache-datasketches-theta-v1"));
+
+  // One unreadable file fails the whole index
+  auto files = open_files();
+  files.push_back(
+      std::make_unique<MemoryInputFile>(std::make_shared<std::vector<uint8_t>>(
+          buffers[0]->begin(), buffers[0]->begin() + 20)));
+  size_t bad_file = files.size() - 1;
+  auto failed = PuffinTableIndex::Create(std::move(files), params);
+  ASSERT_FALSE(failed.ok());
+  EXPECT_NE(std::string(failed.error().message)
+                .find("statistics file " + std::to_string(bad_file) + " ("),
+            std::string::npos)
+      << failed.error().message;
+}
+
+}  // namespace
+}  // namespace icypuff
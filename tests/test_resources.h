@@ -3,7 +3,9 @@
 #include <filesystem>
 #include <iostream>
 #include <memory>
+#include <random>
 #include <string>
+#include <system_error>
 
 #include "icypuff/local_input_file.h"
 #include "icypuff/local_output_file.h"
@@ -35,5 +37,60 @@ class TestResources {
   }
 };
 
+// Helper function to generate a random 8 character ID
+inline std::string generate_uuid() {
+  static std::random_device rd;
+  static std::mt19937 gen(rd());
+  static std::uniform_int_distribution<> dis(0, 15);
+  static const char* digits = "0123456789abcdef";
+
+  std::string id;
+  id.reserve(8);
+
+  for (int i = 0; i < 8; i++) {
+    id += digits[dis(gen)];
+  }
+
+  return id;
+}
+
+// A uniquely named directory under the system temp directory, for tests
+// that need real files. It is removed with its contents on destruction.
+class ScratchDirectory {
+ public:
+  ScratchDirectory()
+      : path_(std::filesystem::temp_directory_path() /
+              ("icypuff-" + generate_uuid())) {
+    std::filesystem::create_directories(path_);
+  }
+
+  ~ScratchDirectory() {
+    std::error_code error;
+    std::filesystem::remove_all(path_, error);
+  }
+
+  ScratchDirectory(const ScratchDirectory&) = delete;
+  ScratchDirectory& operator=(const ScratchDirectory&) = delete;
+
+  const std::filesystem::path& path() const { return path_; }
+
+  std::filesystem::path GetPath(const std::string& name) const {
+    return path_ / name;
+  }
+
+  std::unique_ptr<LocalInputFile> CreateInputFile(
+      const std::string& name) const {
+    return std::make_unique<LocalInputFile>(GetPath(name));
+  }
+
+  std::unique_ptr<LocalOutputFile> CreateOutputFile(
+      const std::string& name) const {
+    return std::make_unique<LocalOutputFile>(GetPath(name));
+  }
+
+ private:
+  std::filesystem::path path_;
+};
+
 }  // namespace testing
 }  // namespace icypuff
\ No newline at end of file
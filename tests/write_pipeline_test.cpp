@@ -0,0 +1,183 @@
+#include "icypuff/write_pipeline.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "icypuff/icypuff.h"
+#include "icypuff/icypuff_reader.h"
+#include "icypuff/memory_input_file.h"
+#include "icypuff/memory_output_file.h"
+
+namespace icypuff {
+namespace {
+
+TEST(WritePipelineTest, BoundsBufferedBytes) {
+  const CompressionCodec codecs[] = {CompressionCodec::None,
+                                     CompressionCodec::Lz4,
+                                     CompressionCodec::Zstd};
+  auto make_blob = [&](int producer, int b) {
+    std::string data(2000 + 53 * b, static_cast<char>('a' + producer));
+    data += std::to_string(producer * 1000 + b);
+    PipelineBlob blob;
+    blob.data.assign(data.begin(), data.end());
+    blob.type = "sketch";
+    blob.fields = {producer};
+    blob.snapshot_id = b;
+    blob.compression = codecs[b % 3];
+    return blob;
+  };
+
+  // One producer gives the same file as serial write_blob calls
+  auto serial = std::make_shared<std::vector<uint8_t>>();
+  auto pipelined = std::make_shared<std::vector<uint8_t>>();
+  {
+    auto writer =
+        Icypuff::write(std::make_unique<MemoryOutputFile>(serial)).build();
+    ASSERT_TRUE(writer.ok()) << writer.error().message;
+    for (int b = 0; b < 30; b++) {
+      PipelineBlob blob = make_blob(0, b);
+      ASSERT_TRUE(writer.value()
+                      ->write_blob(blob.data.data(), blob.data.size(),
+                                   blob.type, blob.fields, blob.snapshot_id,
+                                   0, blob.compression)
+                      .ok());
+    }
+    ASSERT_TRUE(writer.value()->close().ok());
+  }
+  {
+    auto writer =
+        Icypuff::write(std::make_unique<MemoryOutputFile>(pipelined)).build();
+    ASSERT_TRUE(writer.ok()) << writer.error().message;
+    WritePipelineParams params;
+    params.threads = 4;
+    params.max_buffered_bytes = 8 << 10;
+    auto pipeline = WritePipeline::Create(*writer.value(), params);
+    ASSERT_TRUE(pipeline.ok()) << pipeline.error().message;
+    for (int b = 0; b < 30; b++) {
+      ASSERT_TRUE(pipeline.value()->submit(make_blob(0, b)).ok());
+    }
+    ASSERT_TRUE(pipeline.value()->finish().ok());
+    EXPECT_EQ(pipeline.value()->submit(make_blob(0, 0)).error().code,
+              ErrorCode::kInvalidState);
+    ASSERT_TRUE(writer.value()->close().ok());
+  }
+  EXPECT_EQ(*pipelined, *serial);
+
+  // Concurrent producers, half of them retrying refused try_submit calls
+  auto buffer = std::make_shared<std::vector<uint8_t>>();
+  auto writer =
+      Icypuff::write(std::make_unique<MemoryOutputFile>(buffer)).build();
+  ASSERT_TRUE(writer.ok()) << writer.error().message;
+  WritePipelineParams params;
+  params.threads = 3;
+  params.max_buffered_bytes = 16 << 10;
+  auto pipeline_result = WritePipeline::Create(*writer.value(), params);
+  ASSERT_TRUE(pipeline_result.ok()) << pipeline_result.error().message;
+  auto& pipeline = *pipeline_result.value();
+
+  constexpr int kProducers = 6;
+  constexpr int kBlobsPerProducer = 40;
+  std::atomic<int64_t> refused{0};
+  std::atomic<int> failures{0};
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; p++) {
+    producers.emplace_back([&, p]() {
+      for (int b = 0; b < kBlobsPerProducer; b++) {
+        PipelineBlob blob = make_blob(p, b);
+        if (p % 2 == 0) {
+          failures += pipeline.submit(std::move(blob)).ok() ? 0 : 1;
+          continue;
+        }
+        while (true) {
+          auto result = pipeline.try_submit(std::move(blob));
+          if (result.ok()) {
+            break;
+          }
+          if (result.error().code != ErrorCode::kWouldBlock) {
+            failures++;
+            break;
+          }
+          refused++;
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  ASSERT_TRUE(pipeline.finish().ok());
+  EXPECT_EQ(failures.load(), 0);
+
+  WritePipelineStats stats = pipeline.stats();
+  EXPECT_EQ(stats.blobs_submitted, kProducers * kBlobsPerProducer);
+  EXPECT_EQ(stats.blobs_written, kProducers * kBlobsPerProducer);
+  EXPECT_EQ(stats.would_block, refused.load());
+  // The limit is exceeded only by a blob admitted into an empty buffer
+  EXPECT_LE(stats.peak_buffered_bytes, params.max_buffered_bytes);
+  ASSERT_TRUE(writer.value()->close().ok());
+
+  // Each producer's blobs are written in the order it submitted them
+  IcypuffReader reader(std::make_unique<MemoryInputFile>(*buffer));
+  auto blobs = reader.get_blobs();
+  ASSERT_TRUE(blobs.ok()) << blobs.error().message;
+  ASSERT_EQ(blobs.value().size(), kProducers * kBlobsPerProducer);
+  std::vector<int> next(kProducers, 0);
+  for (const auto& blob : blobs.value()) {
+    int producer = blob->input_fields()[0];
+    int b = next[producer]++;
+    EXPECT_EQ(blob->snapshot_id(), b);
+    auto data = reader.read_blob(*blob);
+    ASSERT_TRUE(data.ok()) << data.error().message;
+    EXPECT_EQ(data.value(), make_blob(producer, b).data);
+  }
+}
+
+TEST(WritePipelineTest, WritesEmptyBlobs) {
+  // Empty compressed blobs are written like any other and do not fail the
+  // blobs after them
+  auto buffer = std::make_shared<std::vector<uint8_t>>();
+  auto writer =
+      Icypuff::write(std::make_unique<MemoryOutputFile>(buffer)).build();
+  ASSERT_TRUE(writer.ok()) << writer.error().message;
+  WritePipelineParams params;
+  params.threads = 2;
+  auto pipeline = WritePipeline::Create(*writer.value(), params);
+  ASSERT_TRUE(pipeline.ok()) << pipeline.error().message;
+  const std::vector<CompressionCodec> codecs = {CompressionCodec::Lz4,
+                                                CompressionCodec::Zstd};
+  for (int b = 0; b < 6; b++) {
+    PipelineBlob blob;
+    if (b % 3 == 2) {
+      std::string data = "sketch " + std::to_string(b);
+      blob.data.assign(data.begin(), data.end());
+    }
+    blob.type = "sketch";
+    blob.fields = {b};
+    blob.compression = codecs[b % 2];
+    ASSERT_TRUE(pipeline.value()->submit(std::move(blob)).ok());
+  }
+  ASSERT_TRUE(pipeline.value()->finish().ok());
+  EXPECT_EQ(pipeline.value()->stats().blobs_written, 6);
+  ASSERT_TRUE(writer.value()->close().ok());
+
+  IcypuffReader reader(std::make_unique<MemoryInputFile>(*buffer));
+  auto blobs = reader.get_blobs();
+  ASSERT_TRUE(blobs.ok()) << blobs.error().message;
+  ASSERT_EQ(blobs.value().size(), 6);
+  for (int b = 0; b < 6; b++) {
+    auto data = reader.read_blob(*blobs.value()[b]);
+    ASSERT_TRUE(data.ok()) << data.error().message;
+    std::string expected = b % 3 == 2 ? "sketch " + std::to_string(b) : "";
+    EXPECT_EQ(std::string(data.value().begin(), data.value().end()), expected);
+  }
+}
+
+}  // namespace
+}  // namespace icypuff